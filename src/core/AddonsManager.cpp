@@ -36,6 +36,8 @@
 #include <QtCore/QJsonDocument>
 #include <QtCore/QJsonObject>
 
+#include <algorithm>
+
 namespace Otter
 {
 
@@ -61,9 +63,15 @@ bool Addon::isEnabled() const
 
 AddonsManager *AddonsManager::m_instance(nullptr);
 QHash<QString, UserScript*> AddonsManager::m_userScripts;
+QVector<UserScript*> AddonsManager::m_indexedUserScripts;
+QVector<AddonsManager::UserScriptRule> AddonsManager::m_userScriptRules;
+QVector<int> AddonsManager::m_genericUserScriptRules;
+QVector<int> AddonsManager::m_globalUserScripts;
+QMultiHash<QString, int> AddonsManager::m_hostUserScriptRules;
 QHash<QString, WebBackend*> AddonsManager::m_webBackends;
 QHash<QString, AddonsManager::SpecialPageInformation> AddonsManager::m_specialPages;
 bool AddonsManager::m_areUserScripsInitialized(false);
+bool AddonsManager::m_areUserScriptRulesValid(false);
 
 AddonsManager::AddonsManager(QObject *parent) : QObject(parent)
 {
@@ -114,6 +122,8 @@ void AddonsManager::loadUserScripts()
 
 	m_userScripts.clear();
 
+	invalidateUserScriptRules();
+
 	QHash<QString, bool> enabledScripts;
 	QFile file(SessionsManager::getWritableDataPath(QLatin1String("scripts/scripts.json")));
 
@@ -152,6 +162,72 @@ void AddonsManager::loadUserScripts()
 	m_areUserScripsInitialized = true;
 }
 
+void AddonsManager::invalidateUserScriptRules()
+{
+	m_areUserScriptRulesValid = false;
+}
+
+void AddonsManager::updateUserScriptRules()
+{
+	if (!m_areUserScripsInitialized)
+	{
+		loadUserScripts();
+	}
+
+	m_indexedUserScripts = m_userScripts.values().toVector();
+	m_userScriptRules.clear();
+	m_genericUserScriptRules.clear();
+	m_globalUserScripts.clear();
+	m_hostUserScriptRules.clear();
+
+	for (int i = 0; i < m_indexedUserScripts.count(); ++i)
+	{
+		const UserScript *script(m_indexedUserScripts.at(i));
+		const QStringList includeRules(script->getIncludeRules() + script->getMatchRules());
+
+		if (includeRules.isEmpty())
+		{
+			m_globalUserScripts.append(i);
+		}
+
+		addUserScriptRules(includeRules, i, false);
+		addUserScriptRules(script->getExcludeRules(), i, true);
+	}
+
+	m_areUserScriptRulesValid = true;
+}
+
+void AddonsManager::addUserScriptRules(const QStringList &rules, int script, bool isException)
+{
+	for (int i = 0; i < rules.count(); ++i)
+	{
+		UserScriptRule rule;
+		rule.expression = createUserScriptRule(rules.at(i));
+		rule.script = script;
+		rule.isException = isException;
+
+		if (!rule.expression.isValid())
+		{
+			Console::addMessage(QCoreApplication::translate("main", "Invalid rule for User Script: %1").arg(rules.at(i)), Console::OtherCategory, Console::ErrorLevel);
+
+			continue;
+		}
+
+		const QString host(getUserScriptRuleHost(rules.at(i)));
+
+		if (host.isEmpty())
+		{
+			m_genericUserScriptRules.append(m_userScriptRules.count());
+		}
+		else
+		{
+			m_hostUserScriptRules.insert(host, m_userScriptRules.count());
+		}
+
+		m_userScriptRules.append(rule);
+	}
+}
+
 UserScript* AddonsManager::getUserScript(const QString &name)
 {
 	if (!m_areUserScripsInitialized)
@@ -199,6 +275,154 @@ AddonsManager::SpecialPageInformation AddonsManager::getSpecialPage(const QStrin
 	return SpecialPageInformation();
 }
 
+QString AddonsManager::getUserScriptRuleHost(const QString &rule)
+{
+	const int position(rule.indexOf(QLatin1String("://")));
+
+	if (position < 0 || rule.startsWith(QLatin1Char('/')))
+	{
+		return QString();
+	}
+
+	QString host(rule.mid(position + 3).section(QLatin1Char('/'), 0, 0).section(QLatin1Char(':'), 0, 0).toLower());
+
+	if (host.startsWith(QLatin1String("*.")))
+	{
+		host = host.mid(2);
+	}
+
+	if (host.contains(QLatin1Char('*')) || host.contains(QLatin1Char('@')) || host.endsWith(QLatin1String(".tld")))
+	{
+		return QString();
+	}
+
+	return host;
+}
+
+QRegularExpression AddonsManager::createUserScriptRule(const QString &rule)
+{
+	if (rule.length() > 1 && rule.startsWith(QLatin1Char('/')) && rule.endsWith(QLatin1Char('/')))
+	{
+		QRegularExpression expression(rule.mid(1, (rule.length() - 2)));
+		expression.optimize();
+
+		return expression;
+	}
+
+	QString pattern(QLatin1String("^"));
+	QString literal;
+	int position(0);
+
+	while (position < rule.length())
+	{
+		const bool isWildcard(rule.at(position) == QLatin1Char('*'));
+		const bool isTopLevelDomain(!isWildcard && rule.midRef(position, 4).compare(QLatin1String(".tld"), Qt::CaseInsensitive) == 0);
+
+		if (isWildcard || isTopLevelDomain)
+		{
+			pattern.append(QRegularExpression::escape(literal));
+			pattern.append(isWildcard ? QLatin1String(".*") : QLatin1String("(?:\\.[^./:]+)+"));
+
+			literal.clear();
+
+			position += (isWildcard ? 1 : 4);
+		}
+		else
+		{
+			literal.append(rule.at(position));
+
+			++position;
+		}
+	}
+
+	pattern.append(QRegularExpression::escape(literal));
+	pattern.append(QLatin1Char('$'));
+
+	QRegularExpression expression(pattern);
+	expression.optimize();
+
+	return expression;
+}
+
+QList<UserScript*> AddonsManager::getUserScriptsForUrl(const QUrl &url)
+{
+	const QString scheme(url.scheme());
+
+	if (scheme != QLatin1String("http") && scheme != QLatin1String("https") && scheme != QLatin1String("file") && scheme != QLatin1String("ftp") && scheme != QLatin1String("about"))
+	{
+		return QList<UserScript*>();
+	}
+
+	if (!m_areUserScriptRulesValid)
+	{
+		updateUserScriptRules();
+	}
+
+	const QString urlString(url.url());
+	QVector<int> rules(m_genericUserScriptRules);
+	QString host(url.host().toLower());
+
+	while (!host.isEmpty())
+	{
+		QMultiHash<QString, int>::const_iterator iterator(m_hostUserScriptRules.constFind(host));
+
+		while (iterator != m_hostUserScriptRules.constEnd() && iterator.key() == host)
+		{
+			rules.append(iterator.value());
+
+			++iterator;
+		}
+
+		const int position(host.indexOf(QLatin1Char('.')));
+
+		host = ((position < 0) ? QString() : host.mid(position + 1));
+	}
+
+	QSet<int> includedScripts;
+
+	for (int i = 0; i < m_globalUserScripts.count(); ++i)
+	{
+		includedScripts.insert(m_globalUserScripts.at(i));
+	}
+
+	for (int i = 0; i < rules.count(); ++i)
+	{
+		const UserScriptRule &rule(m_userScriptRules.at(rules.at(i)));
+
+		if (!rule.isException && !includedScripts.contains(rule.script) && m_indexedUserScripts.at(rule.script)->isEnabled() && rule.expression.match(urlString).hasMatch())
+		{
+			includedScripts.insert(rule.script);
+		}
+	}
+
+	for (int i = 0; i < rules.count(); ++i)
+	{
+		const UserScriptRule &rule(m_userScriptRules.at(rules.at(i)));
+
+		if (rule.isException && includedScripts.contains(rule.script) && rule.expression.match(urlString).hasMatch())
+		{
+			includedScripts.remove(rule.script);
+		}
+	}
+
+	QList<int> indexes(includedScripts.toList());
+	QList<UserScript*> scripts;
+
+	std::sort(indexes.begin(), indexes.end());
+
+	for (int i = 0; i < indexes.count(); ++i)
+	{
+		UserScript *script(m_indexedUserScripts.at(indexes.at(i)));
+
+		if (script->isEnabled())
+		{
+			scripts.append(script);
+		}
+	}
+
+	return scripts;
+}
+
 QStringList AddonsManager::getUserScripts()
 {
 	if (!m_areUserScripsInitialized)
@@ -21,6 +21,7 @@
 #define OTTER_ADDONSMANAGER_H
 
 #include <QtCore/QCoreApplication>
+#include <QtCore/QRegularExpression>
 #include <QtCore/QUrl>
 #include <QtGui/QIcon>
 
@@ -108,19 +109,41 @@ public:
 	static UserScript* getUserScript(const QString &name = QString());
 	static WebBackend* getWebBackend(const QString &name = QString());
 	static SpecialPageInformation getSpecialPage(const QString &name);
+	static QList<UserScript*> getUserScriptsForUrl(const QUrl &url);
 	static QStringList getUserScripts();
 	static QStringList getWebBackends();
 	static QStringList getSpecialPages();
 
 protected:
+	struct UserScriptRule
+	{
+		QRegularExpression expression;
+		int script = -1;
+		bool isException = false;
+	};
+
 	explicit AddonsManager(QObject *parent = nullptr);
 
+	static void invalidateUserScriptRules();
+	static void updateUserScriptRules();
+	static void addUserScriptRules(const QStringList &rules, int script, bool isException);
+	static QString getUserScriptRuleHost(const QString &rule);
+	static QRegularExpression createUserScriptRule(const QString &rule);
+
 private:
 	static AddonsManager *m_instance;
 	static QHash<QString, UserScript*> m_userScripts;
+	static QVector<UserScript*> m_indexedUserScripts;
+	static QVector<UserScriptRule> m_userScriptRules;
+	static QVector<int> m_genericUserScriptRules;
+	static QVector<int> m_globalUserScripts;
+	static QMultiHash<QString, int> m_hostUserScriptRules;
 	static QHash<QString, WebBackend*> m_webBackends;
 	static QHash<QString, SpecialPageInformation> m_specialPages;
 	static bool m_areUserScripsInitialized;
+	static bool m_areUserScriptRulesValid;
+
+friend class UserScript;
 };
 
 }
@@ -31,16 +31,25 @@
 #include <QtCore/QDir>
 #include <QtCore/QFileInfo>
 #include <QtCore/QMimeDatabase>
+#include <QtConcurrent/QtConcurrentRun>
 #include <QtWidgets/QFileIconProvider>
 
 namespace Otter
 {
 
+const QVector<AddressCompletionModel::CompletionType> AddressCompletionModel::m_sources({SearchSuggestionsCompletionType, BookmarksCompletionType, LocalPathSuggestionsCompletionType, HistoryCompletionType, TypedHistoryCompletionType, SpecialPagesCompletionType});
+
 AddressCompletionModel::AddressCompletionModel(QObject *parent) : QAbstractListModel(parent),
+	m_localPathsWatcher(new QFutureWatcher<QFileInfoList>(this)),
 	m_types(UnknownCompletionType),
+	m_pendingTypes(UnknownCompletionType),
 	m_updateTimer(0),
+	m_sourceIndex(0),
+	m_isUpdateQueued(false),
+	m_needsReset(false),
 	m_showCompletionCategories(true)
 {
+	connect(m_localPathsWatcher, SIGNAL(finished()), this, SLOT(updateLocalPaths()));
 }
 
 void AddressCompletionModel::timerEvent(QTimerEvent *event)
@@ -54,161 +63,129 @@ void AddressCompletionModel::timerEvent(QTimerEvent *event)
 		if (!m_filter.isEmpty())
 		{
 			updateModel();
-
-			emit completionReady(m_filter);
 		}
 	}
 }
 
 void AddressCompletionModel::updateModel()
 {
-	QList<CompletionEntry> completions;
+	m_pendingTypes = m_types;
+	m_sourceIndex = 0;
+	m_needsReset = true;
+	m_sectionSizes.clear();
 
-	if (m_types.testFlag(SearchSuggestionsCompletionType))
-	{
-		const QString keyword(m_filter.section(QLatin1Char(' '), 0, 0));
-		const SearchEnginesManager::SearchEngineDefinition searchEngine(SearchEnginesManager::getSearchEngine(keyword, true));
-		QString title(m_defaultSearchEngine.title);
-		QString text(m_filter);
-		QIcon icon(m_defaultSearchEngine.icon);
-
-		if (!searchEngine.identifier.isEmpty())
-		{
-			title = searchEngine.title;
-			text = m_filter.section(QLatin1Char(' '), 1, -1);
-			icon = searchEngine.icon;
-		}
-		else if (keyword == QLatin1String("?"))
-		{
-			text = m_filter.section(QLatin1Char(' '), 1, -1);
-		}
+	updateSources();
+}
 
-		if (icon.isNull())
-		{
-			icon = ThemesManager::getIcon(QLatin1String("edit-find"));
-		}
+void AddressCompletionModel::updateSources()
+{
+	m_isUpdateQueued = false;
 
-		if (m_showCompletionCategories)
-		{
-			completions.append(CompletionEntry(QUrl(), tr("Search with %1").arg(title), QString(), QIcon(), QDateTime(), HeaderType));
+	while (m_sourceIndex < m_sources.count() && !m_pendingTypes.testFlag(m_sources.at(m_sourceIndex)))
+	{
+		++m_sourceIndex;
+	}
 
-			title = QString();
-		}
+	if (m_sourceIndex >= m_sources.count())
+	{
+		return;
+	}
 
-		CompletionEntry completionEntry(QUrl(), title, QString(), icon, QDateTime(), SearchSuggestionType);
-		completionEntry.text = text;
+	const CompletionType type(m_sources.at(m_sourceIndex));
 
-		completions.append(completionEntry);
-	}
+	++m_sourceIndex;
 
-	if (m_types.testFlag(BookmarksCompletionType))
+	if (type == LocalPathSuggestionsCompletionType)
 	{
-		const QList<BookmarksModel::BookmarkMatch> bookmarks(BookmarksManager::findBookmarks(m_filter));
+		const QString directory(getLocalPathsDirectory());
 
-		if (m_showCompletionCategories && !bookmarks.isEmpty())
+		if (directory.isEmpty())
 		{
-			completions.append(CompletionEntry(QUrl(), tr("Bookmarks"), QString(), QIcon(), QDateTime(), HeaderType));
+			addCompletions(type, QList<CompletionEntry>());
 		}
-
-		for (int i = 0; i < bookmarks.count(); ++i)
+		else if (directory != m_localPathsDirectory)
 		{
-			CompletionEntry completionEntry(bookmarks.at(i).bookmark->data(BookmarksModel::UrlRole).toUrl(), bookmarks.at(i).bookmark->data(BookmarksModel::TitleRole).toString(), bookmarks.at(i).match, bookmarks.at(i).bookmark->data(Qt::DecorationRole).value<QIcon>(), QDateTime(), BookmarkType);
-			completionEntry.keyword = bookmarks.at(i).bookmark->data(BookmarksModel::KeywordRole).toString();
-
-			if (completionEntry.keyword.startsWith(m_filter))
-			{
-				completionEntry.match = completionEntry.keyword;
-			}
-
-			completions.append(completionEntry);
+			m_localPathsDirectory = directory;
+			m_localPathsEntries.clear();
+			m_localPathsWatcher->setFuture(QtConcurrent::run(&AddressCompletionModel::getDirectoryEntries, directory));
+		}
+		else if (!m_localPathsWatcher->isRunning())
+		{
+			addCompletions(type, getLocalPathCompletions());
 		}
 	}
+	else
+	{
+		addCompletions(type, getCompletions(type));
+	}
 
-	if (m_types.testFlag(LocalPathSuggestionsCompletionType) && m_filter.contains(QDir::separator()))
+	if (m_sourceIndex < m_sources.count() && !m_isUpdateQueued)
 	{
-		const QString directory(m_filter.section(QDir::separator(), 0, -2) + QDir::separator());
-		const QString prefix(m_filter.section(QDir::separator(), -1, -1));
-		const QList<QFileInfo> entries(QDir(Utils::normalizePath(directory)).entryInfoList(QDir::AllEntries | QDir::NoDotAndDotDot));
-		const QFileIconProvider iconProvider;
-		bool wasAdded(!m_showCompletionCategories);
+		m_isUpdateQueued = true;
 
-		for (int i = 0; i < entries.count(); ++i)
-		{
-			if (entries.at(i).fileName().startsWith(prefix, Qt::CaseInsensitive))
-			{
-				const QString path(directory + entries.at(i).fileName());
-				const QMimeType type(QMimeDatabase().mimeTypeForFile(entries.at(i), QMimeDatabase::MatchExtension));
+		QMetaObject::invokeMethod(this, "updateSources", Qt::QueuedConnection);
+	}
+}
 
-				if (!wasAdded)
-				{
-					completions.append(CompletionEntry(QUrl(), tr("Local files"), QString(), QIcon(), QDateTime(), HeaderType));
+void AddressCompletionModel::updateLocalPaths()
+{
+	if (m_localPathsDirectory.isEmpty())
+	{
+		return;
+	}
 
-					wasAdded = true;
-				}
+	m_localPathsEntries = m_localPathsWatcher->result();
 
-				completions.append(CompletionEntry(QUrl::fromLocalFile(QDir::toNativeSeparators(path)), path, path, QIcon::fromTheme(type.iconName(), iconProvider.icon(entries.at(i))), QDateTime(), LocalPathType));
-			}
-		}
+	if (m_pendingTypes.testFlag(LocalPathSuggestionsCompletionType) && getLocalPathsDirectory() == m_localPathsDirectory)
+	{
+		addCompletions(LocalPathSuggestionsCompletionType, getLocalPathCompletions());
 	}
+}
 
-	if (m_types.testFlag(HistoryCompletionType))
-	{
-		const QList<HistoryModel::HistoryEntryMatch> entries(HistoryManager::findEntries(m_filter));
+void AddressCompletionModel::addCompletions(CompletionType type, const QList<CompletionEntry> &completions)
+{
+	m_pendingTypes &= ~type;
 
-		if (m_showCompletionCategories && !entries.isEmpty())
+	if (m_needsReset)
+	{
+		if (completions.isEmpty() && m_pendingTypes != UnknownCompletionType)
 		{
-			completions.append(CompletionEntry(QUrl(), tr("History"), QString(), QIcon(), QDateTime(), HeaderType));
+			return;
 		}
 
-		for (int i = 0; i < entries.count(); ++i)
-		{
-			completions.append(CompletionEntry(entries.at(i).entry->data(HistoryModel::UrlRole).toUrl(), entries.at(i).entry->data(HistoryModel::TitleRole).toString(), entries.at(i).match, entries.at(i).entry->data(Qt::DecorationRole).value<QIcon>(), entries.at(i).entry->data(HistoryModel::TimeVisitedRole).toDateTime(), (entries.at(i).isTypedIn ? TypedInHistoryType : HistoryType)));
-		}
-	}
+		beginResetModel();
 
-	if (m_types.testFlag(TypedHistoryCompletionType))
-	{
-		const QList<HistoryModel::HistoryEntryMatch> entries(HistoryManager::findEntries(QString(), true));
+		m_completions = completions;
 
-		if (m_showCompletionCategories && !entries.isEmpty())
-		{
-			completions.append(CompletionEntry(QUrl(), tr("Typed history"), QString(), QIcon(), QDateTime(), HeaderType));
-		}
+		endResetModel();
 
-		for (int i = 0; i < entries.count(); ++i)
-		{
-			completions.append(CompletionEntry(entries.at(i).entry->data(HistoryModel::UrlRole).toUrl(), entries.at(i).entry->data(HistoryModel::TitleRole).toString(), entries.at(i).match, entries.at(i).entry->data(Qt::DecorationRole).value<QIcon>(), entries.at(i).entry->data(HistoryModel::TimeVisitedRole).toDateTime(), TypedInHistoryType));
-		}
+		m_needsReset = false;
 	}
-
-	if (m_types.testFlag(SpecialPagesCompletionType))
+	else if (!completions.isEmpty())
 	{
-		const QStringList specialPages(AddonsManager::getSpecialPages());
-		bool wasAdded(!m_showCompletionCategories);
+		int position(0);
 
-		for (int i = 0; i < specialPages.count(); ++i)
+		for (int i = 0; i < m_sources.count() && m_sources.at(i) != type; ++i)
 		{
-			const AddonsManager::SpecialPageInformation information(AddonsManager::getSpecialPage(specialPages.at(i)));
-
-			if (information.url.toString().startsWith(m_filter))
-			{
-				if (!wasAdded)
-				{
-					completions.append(CompletionEntry(QUrl(), tr("Special pages"), QString(), QIcon(), QDateTime(), HeaderType));
+			position += m_sectionSizes.value(m_sources.at(i), 0);
+		}
 
-					wasAdded = true;
-				}
+		beginInsertRows(QModelIndex(), position, (position + completions.count() - 1));
 
-				completions.append(CompletionEntry(information.url, information.getTitle(), QString(), information.icon, QDateTime(), SpecialPageType));
-			}
+		for (int i = 0; i < completions.count(); ++i)
+		{
+			m_completions.insert((position + i), completions.at(i));
 		}
-	}
 
-	beginResetModel();
+		endInsertRows();
+	}
 
-	m_completions = completions;
+	m_sectionSizes[type] = completions.count();
 
-	endResetModel();
+	if (!m_filter.isEmpty() && (!completions.isEmpty() || m_pendingTypes == UnknownCompletionType))
+	{
+		emit completionReady(m_filter);
+	}
 }
 
 void AddressCompletionModel::setFilter(const QString &filter, CompletionTypes types)
@@ -267,6 +244,13 @@ void AddressCompletionModel::setFilter(const QString &filter, CompletionTypes ty
 			m_updateTimer = 0;
 		}
 
+		m_pendingTypes = UnknownCompletionType;
+		m_sourceIndex = m_sources.count();
+		m_needsReset = false;
+		m_localPathsDirectory.clear();
+		m_localPathsEntries.clear();
+		m_sectionSizes.clear();
+
 		beginResetModel();
 
 		m_completions.clear();
@@ -281,6 +265,190 @@ void AddressCompletionModel::setFilter(const QString &filter, CompletionTypes ty
 	}
 }
 
+QList<AddressCompletionModel::CompletionEntry> AddressCompletionModel::getCompletions(CompletionType type) const
+{
+	QList<CompletionEntry> completions;
+
+	switch (type)
+	{
+		case SearchSuggestionsCompletionType:
+			{
+				const QString keyword(m_filter.section(QLatin1Char(' '), 0, 0));
+				const SearchEnginesManager::SearchEngineDefinition searchEngine(SearchEnginesManager::getSearchEngine(keyword, true));
+				QString title(m_defaultSearchEngine.title);
+				QString text(m_filter);
+				QIcon icon(m_defaultSearchEngine.icon);
+
+				if (!searchEngine.identifier.isEmpty())
+				{
+					title = searchEngine.title;
+					text = m_filter.section(QLatin1Char(' '), 1, -1);
+					icon = searchEngine.icon;
+				}
+				else if (keyword == QLatin1String("?"))
+				{
+					text = m_filter.section(QLatin1Char(' '), 1, -1);
+				}
+
+				if (icon.isNull())
+				{
+					icon = ThemesManager::getIcon(QLatin1String("edit-find"));
+				}
+
+				if (m_showCompletionCategories)
+				{
+					completions.append(CompletionEntry(QUrl(), tr("Search with %1").arg(title), QString(), QIcon(), QDateTime(), HeaderType));
+
+					title = QString();
+				}
+
+				CompletionEntry completionEntry(QUrl(), title, QString(), icon, QDateTime(), SearchSuggestionType);
+				completionEntry.text = text;
+
+				completions.append(completionEntry);
+			}
+
+			break;
+		case BookmarksCompletionType:
+			{
+				const QList<BookmarksModel::BookmarkMatch> bookmarks(BookmarksManager::findBookmarks(m_filter));
+
+				if (m_showCompletionCategories && !bookmarks.isEmpty())
+				{
+					completions.append(CompletionEntry(QUrl(), tr("Bookmarks"), QString(), QIcon(), QDateTime(), HeaderType));
+				}
+
+				for (int i = 0; i < bookmarks.count(); ++i)
+				{
+					CompletionEntry completionEntry(bookmarks.at(i).bookmark->data(BookmarksModel::UrlRole).toUrl(), bookmarks.at(i).bookmark->data(BookmarksModel::TitleRole).toString(), bookmarks.at(i).match, bookmarks.at(i).bookmark->data(Qt::DecorationRole).value<QIcon>(), QDateTime(), BookmarkType);
+					completionEntry.keyword = bookmarks.at(i).bookmark->data(BookmarksModel::KeywordRole).toString();
+
+					if (completionEntry.keyword.startsWith(m_filter))
+					{
+						completionEntry.match = completionEntry.keyword;
+					}
+
+					completions.append(completionEntry);
+				}
+			}
+
+			break;
+		case HistoryCompletionType:
+			{
+				const QList<HistoryModel::HistoryEntryMatch> entries(HistoryManager::findEntries(m_filter, false, 50));
+
+				if (m_showCompletionCategories && !entries.isEmpty())
+				{
+					completions.append(CompletionEntry(QUrl(), tr("History"), QString(), QIcon(), QDateTime(), HeaderType));
+				}
+
+				for (int i = 0; i < entries.count(); ++i)
+				{
+					completions.append(CompletionEntry(entries.at(i).entry.url, entries.at(i).entry.title, entries.at(i).match, entries.at(i).entry.icon, entries.at(i).entry.timeVisited, (entries.at(i).isTypedIn ? TypedInHistoryType : HistoryType)));
+				}
+			}
+
+			break;
+		case TypedHistoryCompletionType:
+			{
+				const QList<HistoryModel::HistoryEntryMatch> entries(HistoryManager::findEntries(QString(), true));
+
+				if (m_showCompletionCategories && !entries.isEmpty())
+				{
+					completions.append(CompletionEntry(QUrl(), tr("Typed history"), QString(), QIcon(), QDateTime(), HeaderType));
+				}
+
+				for (int i = 0; i < entries.count(); ++i)
+				{
+					completions.append(CompletionEntry(entries.at(i).entry.url, entries.at(i).entry.title, entries.at(i).match, entries.at(i).entry.icon, entries.at(i).entry.timeVisited, TypedInHistoryType));
+				}
+			}
+
+			break;
+		case SpecialPagesCompletionType:
+			{
+				const QStringList specialPages(AddonsManager::getSpecialPages());
+				bool wasAdded(!m_showCompletionCategories);
+
+				for (int i = 0; i < specialPages.count(); ++i)
+				{
+					const AddonsManager::SpecialPageInformation information(AddonsManager::getSpecialPage(specialPages.at(i)));
+
+					if (information.url.toString().startsWith(m_filter))
+					{
+						if (!wasAdded)
+						{
+							completions.append(CompletionEntry(QUrl(), tr("Special pages"), QString(), QIcon(), QDateTime(), HeaderType));
+
+							wasAdded = true;
+						}
+
+						completions.append(CompletionEntry(information.url, information.getTitle(), QString(), information.icon, QDateTime(), SpecialPageType));
+					}
+				}
+			}
+
+			break;
+		case LocalPathSuggestionsCompletionType:
+			return getLocalPathCompletions();
+		default:
+			break;
+	}
+
+	return completions;
+}
+
+QList<AddressCompletionModel::CompletionEntry> AddressCompletionModel::getLocalPathCompletions() const
+{
+	QList<CompletionEntry> completions;
+	const QString directory(getLocalPathsDirectory());
+
+	if (directory.isEmpty() || directory != m_localPathsDirectory)
+	{
+		return completions;
+	}
+
+	const QString prefix(m_filter.section(QDir::separator(), -1, -1));
+	const QMimeDatabase mimeDatabase;
+	const QFileIconProvider iconProvider;
+	bool wasAdded(!m_showCompletionCategories);
+
+	for (int i = 0; i < m_localPathsEntries.count(); ++i)
+	{
+		if (m_localPathsEntries.at(i).fileName().startsWith(prefix, Qt::CaseInsensitive))
+		{
+			const QString path(directory + m_localPathsEntries.at(i).fileName());
+			const QMimeType type(mimeDatabase.mimeTypeForFile(m_localPathsEntries.at(i), QMimeDatabase::MatchExtension));
+
+			if (!wasAdded)
+			{
+				completions.append(CompletionEntry(QUrl(), tr("Local files"), QString(), QIcon(), QDateTime(), HeaderType));
+
+				wasAdded = true;
+			}
+
+			completions.append(CompletionEntry(QUrl::fromLocalFile(QDir::toNativeSeparators(path)), path, path, QIcon::fromTheme(type.iconName(), iconProvider.icon(m_localPathsEntries.at(i))), QDateTime(), LocalPathType));
+		}
+	}
+
+	return completions;
+}
+
+QString AddressCompletionModel::getLocalPathsDirectory() const
+{
+	if (!m_filter.contains(QDir::separator()))
+	{
+		return QString();
+	}
+
+	return (m_filter.section(QDir::separator(), 0, -2) + QDir::separator());
+}
+
+QFileInfoList AddressCompletionModel::getDirectoryEntries(const QString &path)
+{
+	return QDir(Utils::normalizePath(path)).entryInfoList(QDir::AllEntries | QDir::NoDotAndDotDot);
+}
+
 QVariant AddressCompletionModel::data(const QModelIndex &index, int role) const
 {
 	if (index.column() == 0 && index.row() >= 0 && index.row() < m_completions.count())
@@ -298,7 +466,7 @@ QVariant AddressCompletionModel::data(const QModelIndex &index, int role) const
 			case KeywordRole:
 				return m_completions.at(index.row()).keyword;
 			case MatchRole:
-				return (m_completions.at(index.row()).match.isEmpty() ? m_completions.at(index.row()).url.toString() : m_completions.at(index.row()).match);
+				return ((m_completions.at(index.row()).match.isEmpty() && m_completions.at(index.row()).type != BookmarkType) ? m_completions.at(index.row()).url.toString() : m_completions.at(index.row()).match);
 			case TimeVisitedRole:
 				return m_completions.at(index.row()).timeVisited;
 			case TypeRole:
@@ -25,6 +25,8 @@
 #include "../core/SearchEnginesManager.h"
 
 #include <QtCore/QAbstractListModel>
+#include <QtCore/QFileInfo>
+#include <QtCore/QFutureWatcher>
 #include <QtCore/QUrl>
 
 namespace Otter
@@ -101,15 +103,34 @@ public slots:
 protected:
 	void timerEvent(QTimerEvent *event) override;
 	void updateModel();
+	void addCompletions(CompletionType type, const QList<CompletionEntry> &completions);
+	QList<CompletionEntry> getCompletions(CompletionType type) const;
+	QList<CompletionEntry> getLocalPathCompletions() const;
+	QString getLocalPathsDirectory() const;
+	static QFileInfoList getDirectoryEntries(const QString &path);
+
+protected slots:
+	void updateSources();
+	void updateLocalPaths();
 
 private:
+	QFutureWatcher<QFileInfoList> *m_localPathsWatcher;
 	QList<CompletionEntry> m_completions;
+	QFileInfoList m_localPathsEntries;
 	QString m_filter;
+	QString m_localPathsDirectory;
 	SearchEnginesManager::SearchEngineDefinition m_defaultSearchEngine;
+	QHash<CompletionType, int> m_sectionSizes;
 	AddressCompletionModel::CompletionTypes m_types;
+	AddressCompletionModel::CompletionTypes m_pendingTypes;
 	int m_updateTimer;
+	int m_sourceIndex;
+	bool m_isUpdateQueued;
+	bool m_needsReset;
 	bool m_showCompletionCategories;
 
+	static const QVector<CompletionType> m_sources;
+
 signals:
 	void completionReady(const QString &filter);
 };
@@ -102,7 +102,7 @@ void BookmarksManager::removeBookmark(const QUrl &url)
 		return;
 	}
 
-	const QList<BookmarksItem*> items(m_model->findUrls(adjustedUrl));
+	const QList<BookmarksItem*> items(m_model->getBookmarks(adjustedUrl));
 
 	for (int i = 0; i < items.count(); ++i)
 	{
@@ -24,6 +24,7 @@
 #include "ThemesManager.h"
 #include "Utils.h"
 
+#include <QtConcurrent/QtConcurrentRun>
 #include <QtCore/QCoreApplication>
 #include <QtCore/QFile>
 #include <QtCore/QMimeData>
@@ -198,6 +199,7 @@ QList<QUrl> BookmarksItem::getUrls() const
 BookmarksModel::BookmarksModel(const QString &path, FormatMode mode, QObject *parent) : QStandardItemModel(parent),
 	m_rootItem(new BookmarksItem()),
 	m_trashItem(new BookmarksItem()),
+	m_saveWatcher(nullptr),
 	m_mode(mode)
 {
 	m_rootItem->setData(RootBookmark, TypeRole);
@@ -221,7 +223,7 @@ BookmarksModel::BookmarksModel(const QString &path, FormatMode mode, QObject *pa
 		return;
 	}
 
-	QXmlStreamReader reader(file.readAll());
+	QXmlStreamReader reader(&file);
 
 	if (reader.readNextStartElement() && reader.name() == QLatin1String("xbel") && reader.attributes().value(QLatin1String("version")).toString() == QLatin1String("1.0"))
 	{
@@ -257,6 +259,30 @@ BookmarksModel::BookmarksModel(const QString &path, FormatMode mode, QObject *pa
 	connect(this, SIGNAL(rowsMoved(QModelIndex,int,int,QModelIndex,int)), this, SIGNAL(modelModified()));
 }
 
+BookmarksModel::~BookmarksModel()
+{
+	if (m_saveWatcher)
+	{
+		m_saveWatcher->waitForFinished();
+	}
+
+	if (!m_pendingSavePath.isEmpty())
+	{
+		QVector<BookmarkRecord> records;
+		QStandardItem *rootItem(item(0, 0));
+
+		for (int i = 0; i < rootItem->rowCount(); ++i)
+		{
+			if (rootItem->child(i, 0))
+			{
+				createRecords(rootItem->child(i, 0), records);
+			}
+		}
+
+		writeBookmarks(m_pendingSavePath, records, m_mode);
+	}
+}
+
 void BookmarksModel::trashBookmark(BookmarksItem *bookmark)
 {
 	if (!bookmark)
@@ -347,6 +373,8 @@ void BookmarksModel::removeBookmark(BookmarksItem *bookmark)
 		m_keywords.remove(bookmark->data(KeywordRole).toString());
 	}
 
+	removeSearchIndex(bookmark);
+
 	emit bookmarkRemoved(bookmark);
 
 	bookmark->parent()->removeRow(bookmark->row());
@@ -354,6 +382,39 @@ void BookmarksModel::removeBookmark(BookmarksItem *bookmark)
 	emit modelModified();
 }
 
+void BookmarksModel::save(const QString &path)
+{
+	if (SessionsManager::isReadOnly())
+	{
+		return;
+	}
+
+	if (m_saveWatcher)
+	{
+		m_pendingSavePath = path;
+
+		return;
+	}
+
+	QVector<BookmarkRecord> records;
+	QStandardItem *rootItem(item(0, 0));
+
+	for (int i = 0; i < rootItem->rowCount(); ++i)
+	{
+		if (rootItem->child(i, 0))
+		{
+			createRecords(rootItem->child(i, 0), records);
+		}
+	}
+
+	m_savePath = path;
+	m_saveWatcher = new QFutureWatcher<bool>(this);
+
+	connect(m_saveWatcher, SIGNAL(finished()), this, SLOT(handleSaveFinished()));
+
+	m_saveWatcher->setFuture(QtConcurrent::run(&BookmarksModel::writeBookmarks, path, records, m_mode));
+}
+
 void BookmarksModel::readBookmark(QXmlStreamReader *reader, BookmarksItem *parent)
 {
 	BookmarksItem *bookmark(nullptr);
@@ -517,118 +578,6 @@ void BookmarksModel::readBookmark(QXmlStreamReader *reader, BookmarksItem *paren
 	}
 }
 
-void BookmarksModel::writeBookmark(QXmlStreamWriter *writer, QStandardItem *bookmark) const
-{
-	if (!bookmark)
-	{
-		return;
-	}
-
-	switch (static_cast<BookmarkType>(bookmark->data(TypeRole).toInt()))
-	{
-		case FolderBookmark:
-			writer->writeStartElement(QLatin1String("folder"));
-			writer->writeAttribute(QLatin1String("id"), QString::number(bookmark->data(IdentifierRole).toULongLong()));
-
-			if (bookmark->data(TimeAddedRole).toDateTime().isValid())
-			{
-				writer->writeAttribute(QLatin1String("added"), bookmark->data(TimeAddedRole).toDateTime().toString(Qt::ISODate));
-			}
-
-			if (bookmark->data(TimeModifiedRole).toDateTime().isValid())
-			{
-				writer->writeAttribute(QLatin1String("modified"), bookmark->data(TimeModifiedRole).toDateTime().toString(Qt::ISODate));
-			}
-
-			writer->writeTextElement(QLatin1String("title"), bookmark->data(TitleRole).toString());
-
-			if (!bookmark->data(DescriptionRole).toString().isEmpty())
-			{
-				writer->writeTextElement(QLatin1String("desc"), bookmark->data(DescriptionRole).toString());
-			}
-
-			if (m_mode == BookmarksMode && !bookmark->data(KeywordRole).toString().isEmpty())
-			{
-				writer->writeStartElement(QLatin1String("info"));
-				writer->writeStartElement(QLatin1String("metadata"));
-				writer->writeAttribute(QLatin1String("owner"), QLatin1String("http://otter-browser.org/otter-xbel-bookmark"));
-				writer->writeTextElement(QLatin1String("keyword"), bookmark->data(KeywordRole).toString());
-				writer->writeEndElement();
-				writer->writeEndElement();
-			}
-
-			for (int i = 0; i < bookmark->rowCount(); ++i)
-			{
-				writeBookmark(writer, bookmark->child(i, 0));
-			}
-
-			writer->writeEndElement();
-
-			break;
-		case UrlBookmark:
-			writer->writeStartElement(QLatin1String("bookmark"));
-			writer->writeAttribute(QLatin1String("id"), QString::number(bookmark->data(IdentifierRole).toULongLong()));
-
-			if (!bookmark->data(UrlRole).toString().isEmpty())
-			{
-				writer->writeAttribute(QLatin1String("href"), bookmark->data(UrlRole).toString());
-			}
-
-			if (bookmark->data(TimeAddedRole).toDateTime().isValid())
-			{
-				writer->writeAttribute(QLatin1String("added"), bookmark->data(TimeAddedRole).toDateTime().toString(Qt::ISODate));
-			}
-
-			if (bookmark->data(TimeModifiedRole).toDateTime().isValid())
-			{
-				writer->writeAttribute(QLatin1String("modified"), bookmark->data(TimeModifiedRole).toDateTime().toString(Qt::ISODate));
-			}
-
-			if (m_mode != NotesMode)
-			{
-				if (bookmark->data(TimeVisitedRole).toDateTime().isValid())
-				{
-					writer->writeAttribute(QLatin1String("visited"), bookmark->data(TimeVisitedRole).toDateTime().toString(Qt::ISODate));
-				}
-
-				writer->writeTextElement(QLatin1String("title"), bookmark->data(TitleRole).toString());
-			}
-
-			if (!bookmark->data(DescriptionRole).toString().isEmpty())
-			{
-				writer->writeTextElement(QLatin1String("desc"), bookmark->data(DescriptionRole).toString());
-			}
-
-			if (m_mode == BookmarksMode && (!bookmark->data(KeywordRole).toString().isEmpty() || bookmark->data(VisitsRole).toInt() > 0))
-			{
-				writer->writeStartElement(QLatin1String("info"));
-				writer->writeStartElement(QLatin1String("metadata"));
-				writer->writeAttribute(QLatin1String("owner"), QLatin1String("http://otter-browser.org/otter-xbel-bookmark"));
-
-				if (!bookmark->data(KeywordRole).toString().isEmpty())
-				{
-					writer->writeTextElement(QLatin1String("keyword"), bookmark->data(KeywordRole).toString());
-				}
-
-				if (bookmark->data(VisitsRole).toInt() > 0)
-				{
-					writer->writeTextElement(QLatin1String("visits"), QString::number(bookmark->data(VisitsRole).toInt()));
-				}
-
-				writer->writeEndElement();
-				writer->writeEndElement();
-			}
-
-			writer->writeEndElement();
-
-			break;
-		default:
-			writer->writeEmptyElement(QLatin1String("separator"));
-
-			break;
-	}
-}
-
 void BookmarksModel::removeBookmarkUrl(BookmarksItem *bookmark)
 {
 	if (!bookmark)
@@ -686,9 +635,123 @@ void BookmarksModel::readdBookmarkUrl(BookmarksItem *bookmark)
 	}
 }
 
+void BookmarksModel::updateSearchIndex(BookmarksItem *bookmark)
+{
+	const quint64 identifier(bookmark->data(IdentifierRole).toULongLong());
+	const BookmarkType type(static_cast<BookmarkType>(bookmark->data(TypeRole).toInt()));
+
+	if (identifier == 0 || (type != FolderBookmark && type != UrlBookmark))
+	{
+		return;
+	}
+
+	removeSearchTokens(identifier);
+
+	const QList<QPair<QString, int> > fields({qMakePair(bookmark->data(TitleRole).toString(), 8), qMakePair(bookmark->data(KeywordRole).toString(), 8), qMakePair(bookmark->data(UrlRole).toUrl().toString(QUrl::RemoveScheme), 4), qMakePair(bookmark->data(DescriptionRole).toString(), 2)});
+	QHash<QString, int> weights;
+
+	for (int i = 0; i < fields.count(); ++i)
+	{
+		QStringList tokens(getSearchTokens(fields.at(i).first));
+		tokens.removeDuplicates();
+
+		for (int j = 0; j < tokens.count(); ++j)
+		{
+			weights[tokens.at(j)] += fields.at(i).second;
+		}
+	}
+
+	QHash<QString, int>::const_iterator iterator;
+
+	for (iterator = weights.constBegin(); iterator != weights.constEnd(); ++iterator)
+	{
+		m_searchIndex[iterator.key()][identifier] = iterator.value();
+	}
+
+	m_searchTokens[identifier] = weights.keys();
+}
+
+void BookmarksModel::removeSearchIndex(QStandardItem *bookmark)
+{
+	if (!bookmark)
+	{
+		return;
+	}
+
+	for (int i = 0; i < bookmark->rowCount(); ++i)
+	{
+		removeSearchIndex(bookmark->child(i, 0));
+	}
+
+	removeSearchTokens(bookmark->data(IdentifierRole).toULongLong());
+}
+
+void BookmarksModel::removeSearchTokens(quint64 identifier)
+{
+	const QStringList tokens(m_searchTokens.take(identifier));
+
+	for (int i = 0; i < tokens.count(); ++i)
+	{
+		QMap<QString, QHash<quint64, int> >::iterator iterator(m_searchIndex.find(tokens.at(i)));
+
+		if (iterator != m_searchIndex.end())
+		{
+			iterator.value().remove(identifier);
+
+			if (iterator.value().isEmpty())
+			{
+				m_searchIndex.erase(iterator);
+			}
+		}
+	}
+}
+
+void BookmarksModel::createRecords(QStandardItem *bookmark, QVector<BookmarkRecord> &records)
+{
+	BookmarkRecord record;
+	record.url = bookmark->data(UrlRole).toString();
+	record.title = bookmark->data(TitleRole).toString();
+	record.description = bookmark->data(DescriptionRole).toString();
+	record.keyword = bookmark->data(KeywordRole).toString();
+	record.timeAdded = bookmark->data(TimeAddedRole).toDateTime();
+	record.timeModified = bookmark->data(TimeModifiedRole).toDateTime();
+	record.timeVisited = bookmark->data(TimeVisitedRole).toDateTime();
+	record.identifier = bookmark->data(IdentifierRole).toULongLong();
+	record.type = static_cast<BookmarkType>(bookmark->data(TypeRole).toInt());
+	record.visits = bookmark->data(VisitsRole).toInt();
+
+	records.append(record);
+
+	if (record.type != FolderBookmark)
+	{
+		return;
+	}
+
+	const int index(records.count() - 1);
+	int children(0);
+
+	for (int i = 0; i < bookmark->rowCount(); ++i)
+	{
+		if (bookmark->child(i, 0))
+		{
+			createRecords(bookmark->child(i, 0), records);
+
+			++children;
+		}
+	}
+
+	records[index].children = children;
+}
+
 void BookmarksModel::emptyTrash()
 {
 	BookmarksItem *trashItem(getTrashItem());
+
+	for (int i = 0; i < trashItem->rowCount(); ++i)
+	{
+		removeSearchIndex(trashItem->child(i, 0));
+	}
+
 	trashItem->removeRows(0, trashItem->rowCount());
 	trashItem->setEnabled(false);
 
@@ -707,6 +770,31 @@ void BookmarksModel::notifyBookmarkModified(const QModelIndex &index)
 	}
 }
 
+void BookmarksModel::handleSaveFinished()
+{
+	if (!m_saveWatcher)
+	{
+		return;
+	}
+
+	if (!m_saveWatcher->result())
+	{
+		Console::addMessage(((m_mode == NotesMode) ? tr("Failed to save notes file") : tr("Failed to save bookmarks file")), Console::OtherCategory, Console::ErrorLevel, m_savePath);
+	}
+
+	m_saveWatcher->deleteLater();
+	m_saveWatcher = nullptr;
+
+	if (!m_pendingSavePath.isEmpty())
+	{
+		const QString path(m_pendingSavePath);
+
+		m_pendingSavePath.clear();
+
+		save(path);
+	}
+}
+
 BookmarksItem* BookmarksModel::addBookmark(BookmarkType type, quint64 identifier, const QUrl &url, const QString &title, BookmarksItem *parent, int index)
 {
 	BookmarksItem *bookmark(new BookmarksItem());
@@ -738,7 +826,7 @@ BookmarksItem* BookmarksModel::addBookmark(BookmarkType type, quint64 identifier
 	{
 		if (identifier == 0 || m_identifiers.contains(identifier))
 		{
-			identifier = (m_identifiers.isEmpty() ? 1 : (m_identifiers.keys().last() + 1));
+			identifier = (m_identifiers.isEmpty() ? 1 : (m_identifiers.lastKey() + 1));
 		}
 
 		setData(bookmark->index(), identifier, IdentifierRole);
@@ -931,38 +1019,132 @@ QList<BookmarksModel::BookmarkMatch> BookmarksModel::findBookmarks(const QString
 		allMatches.append(currentMatches.at(i));
 	}
 
-	return allMatches;
-}
+	const QList<BookmarksItem*> bookmarks(searchBookmarks(prefix, 50));
 
-QList<BookmarksItem*> BookmarksModel::findUrls(const QUrl &url, QStandardItem *branch) const
-{
-	if (!branch)
+	for (int i = 0; i < bookmarks.count() && allMatches.count() < 50; ++i)
 	{
-		branch = item(0, 0);
+		BookmarksItem *bookmark(bookmarks.at(i));
+
+		if (static_cast<BookmarkType>(bookmark->data(TypeRole).toInt()) == UrlBookmark && !matchedBookmarks.contains(bookmark) && !bookmark->data(IsTrashedRole).toBool())
+		{
+			BookmarkMatch match;
+			match.bookmark = bookmark;
+
+			allMatches.append(match);
+		}
 	}
 
-	QList<BookmarksItem*> items;
+	return allMatches;
+}
+
+QList<BookmarksItem*> BookmarksModel::searchBookmarks(const QString &query, int limit) const
+{
+	const QStringList terms(getSearchTokens(query));
+	QHash<quint64, int> scores;
 
-	for (int i = 0; i < branch->rowCount(); ++i)
+	for (int i = 0; i < terms.count(); ++i)
 	{
-		BookmarksItem *item(dynamic_cast<BookmarksItem*>(branch->child(i)));
+		QHash<quint64, int> termScores;
+		QMap<QString, QHash<quint64, int> >::const_iterator iterator(m_searchIndex.lowerBound(terms.at(i)));
 
-		if (item)
+		while (iterator != m_searchIndex.constEnd() && iterator.key().startsWith(terms.at(i)))
 		{
-			const BookmarkType type(static_cast<BookmarkType>(item->data(TypeRole).toInt()));
+			const bool isExact(iterator.key().length() == terms.at(i).length());
+			QHash<quint64, int>::const_iterator postingsIterator;
 
-			if (type == FolderBookmark)
+			for (postingsIterator = iterator.value().constBegin(); postingsIterator != iterator.value().constEnd(); ++postingsIterator)
 			{
-				items.append(findUrls(url, item));
+				const int score(postingsIterator.value() * (isExact ? 2 : 1));
+
+				if (score > termScores.value(postingsIterator.key(), 0))
+				{
+					termScores[postingsIterator.key()] = score;
+				}
 			}
-			else if (type == UrlBookmark && url == Utils::normalizeUrl(item->data(UrlRole).toUrl()))
+
+			++iterator;
+		}
+
+		if (i == 0)
+		{
+			scores = termScores;
+		}
+		else
+		{
+			QHash<quint64, int>::iterator scoresIterator(scores.begin());
+
+			while (scoresIterator != scores.end())
 			{
-				items.append(item);
+				if (termScores.contains(scoresIterator.key()))
+				{
+					scoresIterator.value() += termScores.value(scoresIterator.key());
+
+					++scoresIterator;
+				}
+				else
+				{
+					scoresIterator = scores.erase(scoresIterator);
+				}
 			}
 		}
+
+		if (scores.isEmpty())
+		{
+			break;
+		}
 	}
 
-	return items;
+	QList<quint64> identifiers(scores.keys());
+
+	std::sort(identifiers.begin(), identifiers.end(), [&](quint64 first, quint64 second)
+	{
+		const int firstScore(scores.value(first));
+		const int secondScore(scores.value(second));
+
+		return (firstScore > secondScore || (firstScore == secondScore && first > second));
+	});
+
+	QList<BookmarksItem*> bookmarks;
+
+	for (int i = 0; i < identifiers.count() && (limit <= 0 || bookmarks.count() < limit); ++i)
+	{
+		BookmarksItem *bookmark(m_identifiers.value(identifiers.at(i)));
+
+		if (bookmark)
+		{
+			bookmarks.append(bookmark);
+		}
+	}
+
+	return bookmarks;
+}
+
+QStringList BookmarksModel::getSearchTokens(const QString &text)
+{
+	const QString normalizedText(text.toLower());
+	QStringList tokens;
+	QString token;
+
+	for (int i = 0; i < normalizedText.length(); ++i)
+	{
+		if (normalizedText.at(i).isLetterOrNumber())
+		{
+			token.append(normalizedText.at(i));
+		}
+		else if (!token.isEmpty())
+		{
+			tokens.append(token);
+
+			token.clear();
+		}
+	}
+
+	if (!token.isEmpty())
+	{
+		tokens.append(token);
+	}
+
+	return tokens;
 }
 
 QList<BookmarksItem*> BookmarksModel::getBookmarks(const QUrl &url) const
@@ -977,6 +1159,118 @@ QList<BookmarksItem*> BookmarksModel::getBookmarks(const QUrl &url) const
 	return QList<BookmarksItem*>();
 }
 
+int BookmarksModel::writeBookmark(QXmlStreamWriter *writer, const QVector<BookmarkRecord> &records, int index, FormatMode mode)
+{
+	const BookmarkRecord &record(records.at(index));
+	int nextIndex(index + 1);
+
+	switch (record.type)
+	{
+		case FolderBookmark:
+			writer->writeStartElement(QLatin1String("folder"));
+			writer->writeAttribute(QLatin1String("id"), QString::number(record.identifier));
+
+			if (record.timeAdded.isValid())
+			{
+				writer->writeAttribute(QLatin1String("added"), record.timeAdded.toString(Qt::ISODate));
+			}
+
+			if (record.timeModified.isValid())
+			{
+				writer->writeAttribute(QLatin1String("modified"), record.timeModified.toString(Qt::ISODate));
+			}
+
+			writer->writeTextElement(QLatin1String("title"), record.title);
+
+			if (!record.description.isEmpty())
+			{
+				writer->writeTextElement(QLatin1String("desc"), record.description);
+			}
+
+			if (mode == BookmarksMode && !record.keyword.isEmpty())
+			{
+				writer->writeStartElement(QLatin1String("info"));
+				writer->writeStartElement(QLatin1String("metadata"));
+				writer->writeAttribute(QLatin1String("owner"), QLatin1String("http://otter-browser.org/otter-xbel-bookmark"));
+				writer->writeTextElement(QLatin1String("keyword"), record.keyword);
+				writer->writeEndElement();
+				writer->writeEndElement();
+			}
+
+			for (int i = 0; i < record.children; ++i)
+			{
+				nextIndex = writeBookmark(writer, records, nextIndex, mode);
+			}
+
+			writer->writeEndElement();
+
+			break;
+		case UrlBookmark:
+			writer->writeStartElement(QLatin1String("bookmark"));
+			writer->writeAttribute(QLatin1String("id"), QString::number(record.identifier));
+
+			if (!record.url.isEmpty())
+			{
+				writer->writeAttribute(QLatin1String("href"), record.url);
+			}
+
+			if (record.timeAdded.isValid())
+			{
+				writer->writeAttribute(QLatin1String("added"), record.timeAdded.toString(Qt::ISODate));
+			}
+
+			if (record.timeModified.isValid())
+			{
+				writer->writeAttribute(QLatin1String("modified"), record.timeModified.toString(Qt::ISODate));
+			}
+
+			if (mode != NotesMode)
+			{
+				if (record.timeVisited.isValid())
+				{
+					writer->writeAttribute(QLatin1String("visited"), record.timeVisited.toString(Qt::ISODate));
+				}
+
+				writer->writeTextElement(QLatin1String("title"), record.title);
+			}
+
+			if (!record.description.isEmpty())
+			{
+				writer->writeTextElement(QLatin1String("desc"), record.description);
+			}
+
+			if (mode == BookmarksMode && (!record.keyword.isEmpty() || record.visits > 0))
+			{
+				writer->writeStartElement(QLatin1String("info"));
+				writer->writeStartElement(QLatin1String("metadata"));
+				writer->writeAttribute(QLatin1String("owner"), QLatin1String("http://otter-browser.org/otter-xbel-bookmark"));
+
+				if (!record.keyword.isEmpty())
+				{
+					writer->writeTextElement(QLatin1String("keyword"), record.keyword);
+				}
+
+				if (record.visits > 0)
+				{
+					writer->writeTextElement(QLatin1String("visits"), QString::number(record.visits));
+				}
+
+				writer->writeEndElement();
+				writer->writeEndElement();
+			}
+
+			writer->writeEndElement();
+
+			break;
+		default:
+			writer->writeEmptyElement(QLatin1String("separator"));
+
+			break;
+	}
+
+	return nextIndex;
+}
+
 BookmarksModel::FormatMode BookmarksModel::getFormatMode() const
 {
 	return m_mode;
@@ -1065,13 +1359,8 @@ bool BookmarksModel::dropMimeData(const QMimeData *data, Qt::DropAction action,
 	return false;
 }
 
-bool BookmarksModel::save(const QString &path) const
+bool BookmarksModel::writeBookmarks(const QString &path, const QVector<BookmarkRecord> &records, FormatMode mode)
 {
-	if (SessionsManager::isReadOnly())
-	{
-		return false;
-	}
-
 	QSaveFile file(path);
 
 	if (!file.open(QIODevice::WriteOnly))
@@ -1087,11 +1376,11 @@ bool BookmarksModel::save(const QString &path) const
 	writer.writeStartElement(QLatin1String("xbel"));
 	writer.writeAttribute(QLatin1String("version"), QLatin1String("1.0"));
 
-	QStandardItem *rootItem(item(0, 0));
+	int index(0);
 
-	for (int i = 0; i < rootItem->rowCount(); ++i)
+	while (index < records.count())
 	{
-		writeBookmark(&writer, rootItem->child(i, 0));
+		index = writeBookmark(&writer, records, index, mode);
 	}
 
 	writer.writeEndDocument();
@@ -1157,6 +1446,13 @@ bool BookmarksModel::setData(const QModelIndex &index, const QVariant &value, in
 
 	bookmark->setItemData(value, role);
 
+	if (role == TitleRole || role == UrlRole || role == DescriptionRole || role == KeywordRole || role == IdentifierRole)
+	{
+		updateSearchIndex(bookmark);
+
+		emit searchIndexModified();
+	}
+
 	switch (role)
 	{
 		case TitleRole:
@@ -20,6 +20,8 @@
 #ifndef OTTER_BOOKMARKSMODEL_H
 #define OTTER_BOOKMARKSMODEL_H
 
+#include <QtCore/QDateTime>
+#include <QtCore/QFutureWatcher>
 #include <QtCore/QUrl>
 #include <QtCore/QXmlStreamReader>
 #include <QtCore/QXmlStreamWriter>
@@ -88,10 +90,12 @@ public:
 	};
 
 	explicit BookmarksModel(const QString &path, FormatMode mode, QObject *parent = nullptr);
+	~BookmarksModel();
 
 	void trashBookmark(BookmarksItem *bookmark);
 	void restoreBookmark(BookmarksItem *bookmark);
 	void removeBookmark(BookmarksItem *bookmark);
+	void save(const QString &path);
 	BookmarksItem* addBookmark(BookmarkType type, quint64 identifier = 0, const QUrl &url = QUrl(), const QString &title = QString(), BookmarksItem *parent = nullptr, int index = -1);
 	BookmarksItem* getBookmark(const QString &keyword) const;
 	BookmarksItem* getBookmark(const QModelIndex &index) const;
@@ -103,12 +107,11 @@ public:
 	QStringList mimeTypes() const override;
 	QStringList getKeywords() const;
 	QList<BookmarkMatch> findBookmarks(const QString &prefix) const;
-	QList<BookmarksItem*> findUrls(const QUrl &url, QStandardItem *branch = nullptr) const;
+	QList<BookmarksItem*> searchBookmarks(const QString &query, int limit = 0) const;
 	QList<BookmarksItem*> getBookmarks(const QUrl &url) const;
 	FormatMode getFormatMode() const;
 	bool moveBookmark(BookmarksItem *bookmark, BookmarksItem *newParent, int newRow = -1);
 	bool dropMimeData(const QMimeData *data, Qt::DropAction action, int row, int column, const QModelIndex &parent) override;
-	bool save(const QString &path) const;
 	bool setData(const QModelIndex &index, const QVariant &value, int role) override;
 	bool hasBookmark(const QUrl &url) const;
 	bool hasKeyword(const QString &keyword) const;
@@ -117,21 +120,48 @@ public slots:
 	void emptyTrash();
 
 protected:
+	struct BookmarkRecord
+	{
+		QString url;
+		QString title;
+		QString description;
+		QString keyword;
+		QDateTime timeAdded;
+		QDateTime timeModified;
+		QDateTime timeVisited;
+		quint64 identifier = 0;
+		BookmarkType type = UnknownBookmark;
+		int visits = 0;
+		int children = 0;
+	};
+
 	void readBookmark(QXmlStreamReader *reader, BookmarksItem *parent);
-	void writeBookmark(QXmlStreamWriter *writer, QStandardItem *bookmark) const;
 	void removeBookmarkUrl(BookmarksItem *bookmark);
 	void readdBookmarkUrl(BookmarksItem *bookmark);
+	void updateSearchIndex(BookmarksItem *bookmark);
+	void removeSearchIndex(QStandardItem *bookmark);
+	void removeSearchTokens(quint64 identifier);
+	static void createRecords(QStandardItem *bookmark, QVector<BookmarkRecord> &records);
+	static int writeBookmark(QXmlStreamWriter *writer, const QVector<BookmarkRecord> &records, int index, FormatMode mode);
+	static QStringList getSearchTokens(const QString &text);
+	static bool writeBookmarks(const QString &path, const QVector<BookmarkRecord> &records, FormatMode mode);
 
 protected slots:
 	void notifyBookmarkModified(const QModelIndex &index);
+	void handleSaveFinished();
 
 private:
 	BookmarksItem *m_rootItem;
 	BookmarksItem *m_trashItem;
+	QFutureWatcher<bool> *m_saveWatcher;
 	QHash<BookmarksItem*, QPair<QModelIndex, int> > m_trash;
 	QHash<QUrl, QList<BookmarksItem*> > m_urls;
 	QHash<QString, BookmarksItem*> m_keywords;
 	QMap<quint64, BookmarksItem*> m_identifiers;
+	QMap<QString, QHash<quint64, int> > m_searchIndex;
+	QHash<quint64, QStringList> m_searchTokens;
+	QString m_savePath;
+	QString m_pendingSavePath;
 	FormatMode m_mode;
 
 signals:
@@ -142,6 +172,7 @@ signals:
 	void bookmarkRestored(BookmarksItem *bookmark);
 	void bookmarkRemoved(BookmarksItem *bookmark);
 	void modelModified();
+	void searchIndexModified();
 
 friend class BookmarksItem;
 };
@@ -36,6 +36,14 @@ namespace Otter
 
 ContentBlockingManager* ContentBlockingManager::m_instance(nullptr);
 QVector<ContentBlockingProfile*> ContentBlockingManager::m_profiles;
+QReadWriteLock ContentBlockingManager::m_profilesLock;
+QCache<QString, ContentBlockingManager::CheckResult> ContentBlockingManager::m_verdictCache(2000);
+QCache<QString, ContentBlockingManager::CosmeticFilters> ContentBlockingManager::m_cosmeticFiltersCache(200);
+QHash<QString, ContentBlockingManager::CosmeticFilters> ContentBlockingManager::m_genericCosmeticFilters;
+QMutex ContentBlockingManager::m_cachesMutex;
+quint64 ContentBlockingManager::m_cachesGeneration(0);
+quint64 ContentBlockingManager::m_verdictCacheHits(0);
+quint64 ContentBlockingManager::m_verdictCacheMisses(0);
 ContentBlockingManager::CosmeticFiltersMode ContentBlockingManager::m_cosmeticFiltersMode(AllFiltersMode);
 bool ContentBlockingManager::m_areWildcardsEnabled(true);
 
@@ -47,6 +55,7 @@ ContentBlockingManager::ContentBlockingManager(QObject *parent) : QObject(parent
 	optionChanged(SettingsManager::ContentBlocking_CosmeticFiltersModeOption, SettingsManager::getValue(SettingsManager::ContentBlocking_CosmeticFiltersModeOption).toString());
 
 	connect(SettingsManager::getInstance(), SIGNAL(valueChanged(int,QVariant)), this, SLOT(optionChanged(int,QVariant)));
+	connect(this, SIGNAL(profileModified(QString)), this, SLOT(clearCaches()));
 }
 
 void ContentBlockingManager::createInstance(QObject *parent)
@@ -162,6 +171,19 @@ void ContentBlockingManager::optionChanged(int identifier, const QVariant &value
 	{
 		m_profiles[i]->clear();
 	}
+
+	clearCaches();
+}
+
+void ContentBlockingManager::clearCaches()
+{
+	QMutexLocker locker(&m_cachesMutex);
+
+	m_verdictCache.clear();
+	m_cosmeticFiltersCache.clear();
+	m_genericCosmeticFilters.clear();
+
+	++m_cachesGeneration;
 }
 
 void ContentBlockingManager::scheduleSave()
@@ -176,11 +198,18 @@ void ContentBlockingManager::addProfile(ContentBlockingProfile *profile)
 {
 	if (profile)
 	{
+		m_profilesLock.lockForWrite();
+
 		m_profiles.append(profile);
 
-		getInstance()->scheduleSave();
+		m_profilesLock.unlock();
+
+		m_instance->clearCaches();
+		m_instance->scheduleSave();
 
+		connect(profile, SIGNAL(profileModified(QString)), m_instance, SIGNAL(profileModified(QString)));
 		connect(profile, SIGNAL(profileModified(QString)), m_instance, SLOT(scheduleSave()));
+		connect(profile, SIGNAL(rulesModified(QString)), m_instance, SLOT(clearCaches()));
 	}
 }
 
@@ -296,8 +325,33 @@ ContentBlockingManager::CheckResult ContentBlockingManager::checkUrl(const QVect
 		return CheckResult();
 	}
 
+	const QString key(QString::number(resourceType) + QLatin1Char(' ') + createProfilesKey(profiles) + QLatin1Char(' ') + baseUrl.host() + QLatin1Char(' ') + requestUrl.url());
+
+	m_cachesMutex.lock();
+
+	const CheckResult *cachedResult(m_verdictCache.object(key));
+
+	if (cachedResult)
+	{
+		const CheckResult result(*cachedResult);
+
+		++m_verdictCacheHits;
+
+		m_cachesMutex.unlock();
+
+		return result;
+	}
+
+	++m_verdictCacheMisses;
+
+	const quint64 generation(m_cachesGeneration);
+
+	m_cachesMutex.unlock();
+
 	CheckResult result;
 
+	m_profilesLock.lockForRead();
+
 	for (int i = 0; i < profiles.count(); ++i)
 	{
 		if (profiles[i] >= 0 && profiles[i] < m_profiles.count())
@@ -310,11 +364,22 @@ ContentBlockingManager::CheckResult ContentBlockingManager::checkUrl(const QVect
 			}
 			else if (currentResult.isException)
 			{
-				return currentResult;
+				result = currentResult;
+
+				break;
 			}
 		}
 	}
 
+	m_profilesLock.unlock();
+
+	QMutexLocker locker(&m_cachesMutex);
+
+	if (generation == m_cachesGeneration)
+	{
+		m_verdictCache.insert(key, new CheckResult(result));
+	}
+
 	return result;
 }
 
@@ -336,49 +401,176 @@ QStringList ContentBlockingManager::createSubdomainList(const QString &domain)
 	return subdomainList;
 }
 
-QStringList ContentBlockingManager::getStyleSheet(const QVector<int> &profiles)
+QString ContentBlockingManager::createStyleSheet(const QStringList &rules)
 {
-	QStringList styleSheet;
+	QString styleSheet;
 
-	for (int i = 0; i < profiles.count(); ++i)
+	for (int i = 0; i < rules.count(); ++i)
 	{
-		if (profiles[i] >= 0 && profiles[i] < m_profiles.count())
-		{
-			styleSheet += m_profiles.at(profiles[i])->getStyleSheet();
-		}
+		styleSheet.append(rules.at(i) + QLatin1String("{display:none !important;}"));
 	}
 
 	return styleSheet;
 }
 
-QStringList ContentBlockingManager::getStyleSheetBlackList(const QString &domain, const QVector<int> &profiles)
+QString ContentBlockingManager::createProfilesKey(const QVector<int> &profiles)
 {
-	QStringList data;
+	QString key;
+
+	for (int i = 0; i < profiles.count(); ++i)
+	{
+		key.append(QString::number(profiles.at(i)) + QLatin1Char(','));
+	}
+
+	return key;
+}
+
+ContentBlockingManager::CosmeticFilters ContentBlockingManager::getCosmeticFilters(const QVector<int> &profiles, const QUrl &requestUrl)
+{
+	if (profiles.isEmpty() || m_cosmeticFiltersMode == NoFiltersMode)
+	{
+		return CosmeticFilters();
+	}
+
+	const CosmeticFiltersMode mode(checkUrl(profiles, requestUrl, requestUrl, NetworkManager::OtherType).comesticFiltersMode);
+
+	if (mode == NoFiltersMode)
+	{
+		return CosmeticFilters();
+	}
+
+	const QString profilesKey(createProfilesKey(profiles));
+	const QString domain(requestUrl.host());
+	const QString key(QString::number(mode) + QLatin1Char(' ') + profilesKey + QLatin1Char(' ') + domain);
+
+	m_cachesMutex.lock();
+
+	const CosmeticFilters *cachedFilters(m_cosmeticFiltersCache.object(key));
+
+	if (cachedFilters)
+	{
+		const CosmeticFilters filters(*cachedFilters);
+
+		m_cachesMutex.unlock();
+
+		return filters;
+	}
+
+	const quint64 generation(m_cachesGeneration);
+
+	m_cachesMutex.unlock();
+
+	const QStringList domainList(createSubdomainList(domain));
+	QStringList blackList;
+	QStringList whiteList;
+
+	m_profilesLock.lockForRead();
 
 	for (int i = 0; i < profiles.count(); ++i)
 	{
 		if (profiles[i] >= 0 && profiles[i] < m_profiles.count())
 		{
-			data.append(m_profiles.at(profiles[i])->getStyleSheetBlackList(domain));
+			for (int j = 0; j < domainList.count(); ++j)
+			{
+				blackList.append(m_profiles.at(profiles[i])->getStyleSheetBlackList(domainList.at(j)));
+				whiteList.append(m_profiles.at(profiles[i])->getStyleSheetWhiteList(domainList.at(j)));
+			}
 		}
 	}
 
-	return data;
+	m_profilesLock.unlock();
+
+	CosmeticFilters filters;
+
+	if (mode == AllFiltersMode)
+	{
+		filters = getGenericCosmeticFilters(profiles, profilesKey);
+
+		bool hasExceptions(false);
+
+		for (int i = 0; i < whiteList.count(); ++i)
+		{
+			if (filters.genericRules.contains(whiteList.at(i)))
+			{
+				hasExceptions = true;
+
+				break;
+			}
+		}
+
+		if (hasExceptions)
+		{
+			for (int i = 0; i < whiteList.count(); ++i)
+			{
+				filters.genericRules.removeAll(whiteList.at(i));
+			}
+
+			filters.genericStyleSheet = createStyleSheet(filters.genericRules);
+		}
+	}
+
+	for (int i = 0; i < whiteList.count(); ++i)
+	{
+		blackList.removeAll(whiteList.at(i));
+	}
+
+	blackList.removeDuplicates();
+
+	filters.domainRules = blackList;
+	filters.domainStyleSheet = createStyleSheet(blackList);
+
+	QMutexLocker locker(&m_cachesMutex);
+
+	if (generation == m_cachesGeneration)
+	{
+		m_cosmeticFiltersCache.insert(key, new CosmeticFilters(filters));
+	}
+
+	return filters;
 }
 
-QStringList ContentBlockingManager::getStyleSheetWhiteList(const QString &domain, const QVector<int> &profiles)
+ContentBlockingManager::CosmeticFilters ContentBlockingManager::getGenericCosmeticFilters(const QVector<int> &profiles, const QString &key)
 {
-	QStringList data;
+	m_cachesMutex.lock();
+
+	if (m_genericCosmeticFilters.contains(key))
+	{
+		const CosmeticFilters filters(m_genericCosmeticFilters.value(key));
+
+		m_cachesMutex.unlock();
+
+		return filters;
+	}
+
+	const quint64 generation(m_cachesGeneration);
+
+	m_cachesMutex.unlock();
+
+	CosmeticFilters filters;
+
+	m_profilesLock.lockForRead();
 
 	for (int i = 0; i < profiles.count(); ++i)
 	{
 		if (profiles[i] >= 0 && profiles[i] < m_profiles.count())
 		{
-			data.append(m_profiles.at(profiles[i])->getStyleSheetWhiteList(domain));
+			filters.genericRules.append(m_profiles.at(profiles[i])->getStyleSheet());
 		}
 	}
 
-	return data;
+	m_profilesLock.unlock();
+
+	filters.genericRules.removeDuplicates();
+	filters.genericStyleSheet = createStyleSheet(filters.genericRules);
+
+	QMutexLocker locker(&m_cachesMutex);
+
+	if (generation == m_cachesGeneration)
+	{
+		m_genericCosmeticFilters[key] = filters;
+	}
+
+	return filters;
 }
 
 QVector<ContentBlockingProfile*> ContentBlockingManager::getProfiles()
@@ -421,8 +613,12 @@ QVector<ContentBlockingProfile*> ContentBlockingManager::getProfiles()
 
 		profiles.sort();
 
+		m_profilesLock.lockForWrite();
+
 		m_profiles.reserve(profiles.count());
 
+		m_profilesLock.unlock();
+
 		QJsonObject settingsObject;
 		QFile file(SessionsManager::getWritableDataPath(QLatin1String("contentBlocking.json")));
 
@@ -487,10 +683,15 @@ QVector<ContentBlockingProfile*> ContentBlockingManager::getProfiles()
 
 			ContentBlockingProfile *profile(new ContentBlockingProfile(profiles.at(i), title, updateUrl, QDateTime::fromString(profileObject.value(QLatin1String("lastUpdate")).toString(), Qt::ISODate), parsedLanguages, profileObject.value(QLatin1String("updateInterval")).toInt(), categoryTitles.value(profileObject.value(QLatin1String("category")).toString()), flags, m_instance));
 
+			m_profilesLock.lockForWrite();
+
 			m_profiles.append(profile);
 
+			m_profilesLock.unlock();
+
 			connect(profile, SIGNAL(profileModified(QString)), m_instance, SIGNAL(profileModified(QString)));
 			connect(profile, SIGNAL(profileModified(QString)), m_instance, SLOT(scheduleSave()));
+			connect(profile, SIGNAL(rulesModified(QString)), m_instance, SLOT(clearCaches()));
 		}
 	}
 
@@ -507,6 +708,8 @@ QVector<int> ContentBlockingManager::getProfileList(const QStringList &names)
 		getProfiles();
 	}
 
+	QReadLocker locker(&m_profilesLock);
+
 	for (int i = 0; i < m_profiles.count(); ++i)
 	{
 		if (names.contains(m_profiles.at(i)->getName()))
@@ -523,6 +726,27 @@ ContentBlockingManager::CosmeticFiltersMode ContentBlockingManager::getCosmeticF
 	return m_cosmeticFiltersMode;
 }
 
+quint64 ContentBlockingManager::getCachesGeneration()
+{
+	QMutexLocker locker(&m_cachesMutex);
+
+	return m_cachesGeneration;
+}
+
+quint64 ContentBlockingManager::getVerdictCacheHits()
+{
+	QMutexLocker locker(&m_cachesMutex);
+
+	return m_verdictCacheHits;
+}
+
+quint64 ContentBlockingManager::getVerdictCacheMisses()
+{
+	QMutexLocker locker(&m_cachesMutex);
+
+	return m_verdictCacheMisses;
+}
+
 bool ContentBlockingManager::areWildcardsEnabled()
 {
 	return m_areWildcardsEnabled;
@@ -23,6 +23,9 @@
 
 #include "NetworkManager.h"
 
+#include <QtCore/QCache>
+#include <QtCore/QMutex>
+#include <QtCore/QReadWriteLock>
 #include <QtCore/QUrl>
 #include <QtGui/QStandardItemModel>
 
@@ -52,6 +55,14 @@ public:
 		bool isException = false;
 	};
 
+	struct CosmeticFilters
+	{
+		QStringList genericRules;
+		QStringList domainRules;
+		QString genericStyleSheet;
+		QString domainStyleSheet;
+	};
+
 	static void createInstance(QObject *parent = nullptr);
 	static void addProfile(ContentBlockingProfile *profile);
 	static QStandardItemModel* createModel(QObject *parent, const QStringList &profiles);
@@ -59,12 +70,13 @@ public:
 	static ContentBlockingProfile* getProfile(const QString &profile);
 	static CheckResult checkUrl(const QVector<int> &profiles, const QUrl &baseUrl, const QUrl &requestUrl, NetworkManager::ResourceType resourceType);
 	static QStringList createSubdomainList(const QString &domain);
-	static QStringList getStyleSheet(const QVector<int> &profiles);
-	static QStringList getStyleSheetBlackList(const QString &domain, const QVector<int> &profiles);
-	static QStringList getStyleSheetWhiteList(const QString &domain, const QVector<int> &profiles);
+	static CosmeticFilters getCosmeticFilters(const QVector<int> &profiles, const QUrl &requestUrl);
 	static QVector<ContentBlockingProfile*> getProfiles();
 	static QVector<int> getProfileList(const QStringList &names);
 	static CosmeticFiltersMode getCosmeticFiltersMode();
+	static quint64 getCachesGeneration();
+	static quint64 getVerdictCacheHits();
+	static quint64 getVerdictCacheMisses();
 	static bool areWildcardsEnabled();
 	static bool updateProfile(const QString &profile);
 
@@ -75,15 +87,27 @@ protected:
 	explicit ContentBlockingManager(QObject *parent = nullptr);
 
 	void timerEvent(QTimerEvent *event) override;
+	static QString createStyleSheet(const QStringList &rules);
+	static QString createProfilesKey(const QVector<int> &profiles);
+	static CosmeticFilters getGenericCosmeticFilters(const QVector<int> &profiles, const QString &key);
 
 protected slots:
 	void optionChanged(int identifier, const QVariant &value);
+	void clearCaches();
 
 private:
 	int m_saveTimer;
 
 	static ContentBlockingManager *m_instance;
 	static QVector<ContentBlockingProfile*> m_profiles;
+	static QReadWriteLock m_profilesLock;
+	static QCache<QString, CheckResult> m_verdictCache;
+	static QCache<QString, CosmeticFilters> m_cosmeticFiltersCache;
+	static QHash<QString, CosmeticFilters> m_genericCosmeticFilters;
+	static QMutex m_cachesMutex;
+	static quint64 m_cachesGeneration;
+	static quint64 m_verdictCacheHits;
+	static quint64 m_verdictCacheMisses;
 	static CosmeticFiltersMode m_cosmeticFiltersMode;
 	static bool m_areWildcardsEnabled;
 
@@ -21,6 +21,7 @@
 
 #include "ContentBlockingProfile.h"
 #include "Console.h"
+#include "ContentBlockingRuleSet.h"
 #include "NetworkManager.h"
 #include "NetworkManagerFactory.h"
 #include "SessionsManager.h"
@@ -28,6 +29,7 @@
 #include <QtConcurrent/QtConcurrentRun>
 #include <QtCore/QCoreApplication>
 #include <QtCore/QDir>
+#include <QtCore/QSaveFile>
 #include <QtCore/QTextStream>
 #include <QtNetwork/QNetworkReply>
 #include <QtNetwork/QNetworkRequest>
@@ -35,13 +37,10 @@
 namespace Otter
 {
 
-QList<QChar> ContentBlockingProfile::m_separators(QList<QChar>({QLatin1Char('_'), QLatin1Char('-'), QLatin1Char('.'), QLatin1Char('%')}));
-QHash<QString, ContentBlockingProfile::RuleOption> ContentBlockingProfile::m_options({{QLatin1String("third-party"), ThirdPartyOption}, {QLatin1String("stylesheet"), StyleSheetOption}, {QLatin1String("image"), ImageOption}, {QLatin1String("script"), ScriptOption}, {QLatin1String("object"), ObjectOption}, {QLatin1String("object-subrequest"), ObjectSubRequestOption}, {QLatin1String("object_subrequest"), ObjectSubRequestOption}, {QLatin1String("subdocument"), SubDocumentOption}, {QLatin1String("xmlhttprequest"), XmlHttpRequestOption}, {QLatin1String("websocket"), WebSocketOption}, {QLatin1String("elemhide"), ElementHideOption}, {QLatin1String("generichide"), GenericHideOption}});
-QHash<NetworkManager::ResourceType, ContentBlockingProfile::RuleOption> ContentBlockingProfile::m_resourceTypes({{NetworkManager::ImageType, ImageOption}, {NetworkManager::ScriptType, ScriptOption}, {NetworkManager::StyleSheetType, StyleSheetOption}, {NetworkManager::ObjectType, ObjectOption}, {NetworkManager::XmlHttpRequestType, XmlHttpRequestOption}, {NetworkManager::SubFrameType, SubDocumentOption}, {NetworkManager::ObjectSubrequestType, ObjectSubRequestOption}, {NetworkManager::WebSocketType, WebSocketOption}});
-
 ContentBlockingProfile::ContentBlockingProfile(const QString &name, const QString &title, const QUrl &updateUrl, const QDateTime lastUpdate, const QList<QString> languages, int updateInterval, const ProfileCategory &category, const ProfileFlags &flags, QObject *parent) : QObject(parent),
-	m_root(nullptr),
 	m_networkReply(nullptr),
+	m_loadWatcher(nullptr),
+	m_updateWatcher(nullptr),
 	m_name(name),
 	m_title(title),
 	m_updateUrl(updateUrl),
@@ -52,7 +51,7 @@ ContentBlockingProfile::ContentBlockingProfile(const QString &name, const QStrin
 	m_updateInterval(updateInterval),
 	m_isUpdating(false),
 	m_isEmpty(true),
-	m_wasLoaded(false)
+	m_isLoadRequested(0)
 {
 	if (!languages.isEmpty())
 	{
@@ -69,21 +68,36 @@ ContentBlockingProfile::ContentBlockingProfile(const QString &name, const QStrin
 
 void ContentBlockingProfile::clear()
 {
-	if (!m_wasLoaded)
+	if (m_loadWatcher)
 	{
-		return;
+		m_loadWatcher->disconnect(this);
+		m_loadWatcher->deleteLater();
+		m_loadWatcher = nullptr;
 	}
 
-	if (m_root)
+	if (m_updateWatcher)
 	{
-		QtConcurrent::run(this, &ContentBlockingProfile::deleteNode, m_root);
+		m_updateWatcher->disconnect(this);
+		m_updateWatcher->deleteLater();
+		m_updateWatcher = nullptr;
+
+		m_isUpdating = false;
 	}
 
-	m_styleSheet.clear();
-	m_styleSheetWhiteList.clear();
-	m_styleSheetBlackList.clear();
+	m_rulesMutex.lock();
+
+	const bool wasLoaded(!m_rules.isNull());
 
-	m_wasLoaded = false;
+	m_rules.clear();
+
+	m_rulesMutex.unlock();
+
+	m_isLoadRequested.store(0);
+
+	if (wasLoaded)
+	{
+		emit rulesModified(m_name);
+	}
 }
 
 void ContentBlockingProfile::loadHeader(const QString &path)
@@ -140,443 +154,54 @@ void ContentBlockingProfile::loadHeader(const QString &path)
 	}
 }
 
-void ContentBlockingProfile::parseRuleLine(QString line)
+void ContentBlockingProfile::loadRules()
 {
-	if (line.indexOf(QLatin1Char('!')) == 0 || line.isEmpty())
-	{
-		return;
-	}
-
-	if (line.startsWith(QLatin1String("##")))
-	{
-		if (ContentBlockingManager::getCosmeticFiltersMode() == ContentBlockingManager::AllFiltersMode)
-		{
-			m_styleSheet.append(line.mid(2));
-		}
-
-		return;
-	}
-
-	if (line.contains(QLatin1String("##")))
-	{
-		if (ContentBlockingManager::getCosmeticFiltersMode() != ContentBlockingManager::NoFiltersMode)
-		{
-			parseStyleSheetRule(line.split(QLatin1String("##")), m_styleSheetBlackList);
-		}
-
-		return;
-	}
-
-	if (line.contains(QLatin1String("#@#")))
+	if (m_loadWatcher)
 	{
-		if (ContentBlockingManager::getCosmeticFiltersMode() != ContentBlockingManager::NoFiltersMode)
-		{
-			parseStyleSheetRule(line.split(QLatin1String("#@#")), m_styleSheetWhiteList);
-		}
-
 		return;
 	}
 
-	const QString rule(line);
-	QStringList options;
-	const int optionSeparator(line.indexOf(QLatin1Char('$')));
-
-	if (optionSeparator >= 0)
-	{
-		options = line.mid(optionSeparator + 1).split(QLatin1Char(','), QString::SkipEmptyParts);
-
-		line = line.left(optionSeparator);
-	}
-
-	if (line.endsWith(QLatin1Char('*')))
-	{
-		line = line.left(line.length() - 1);
-	}
-
-	if (line.startsWith(QLatin1Char('*')))
+	if (m_isEmpty && !m_updateUrl.isEmpty())
 	{
-		line = line.mid(1);
-	}
+		downloadRules();
 
-	if (!ContentBlockingManager::areWildcardsEnabled() && line.contains(QLatin1Char('*')))
-	{
 		return;
 	}
 
-	QStringList allowedDomains;
-	QStringList blockedDomains;
-	RuleOptions ruleOptions;
-	RuleMatch ruleMatch(ContainsMatch);
-	bool isException(false);
-	bool needsDomainCheck(false);
-
-	if (line.startsWith(QLatin1String("@@")))
-	{
-		line = line.mid(2);
-
-		isException = true;
-	}
-
-	if (line.startsWith(QLatin1String("||")))
-	{
-		line = line.mid(2);
-
-		needsDomainCheck = true;
-	}
-
-	if (line.startsWith(QLatin1Char('|')))
-	{
-		ruleMatch = StartMatch;
-
-		line = line.mid(1);
-	}
-
-	if (line.endsWith(QLatin1Char('|')))
-	{
-		ruleMatch = (ruleMatch == StartMatch ? ExactMatch : EndMatch);
-
-		line = line.left(line.length() - 1);
-	}
-
-	for (int i = 0; i < options.count(); ++i)
-	{
-		const bool optionException(options.at(i).startsWith(QLatin1Char('~')));
-		const QString optionName(optionException ? options.at(i).mid(1) : options.at(i));
-
-		if (m_options.contains(optionName))
-		{
-			const RuleOption option(m_options.value(optionName));
-
-			if ((!isException || optionException) && (option == ElementHideOption || option == GenericHideOption))
-			{
-				continue;
-			}
-			else if (!optionException)
-			{
-				ruleOptions |= option;
-			}
-			else if (option != WebSocketOption)
-			{
-				ruleOptions |= static_cast<RuleOption>(option * 2);
-			}
-		}
-		else if (optionName.startsWith(QLatin1String("domain")))
-		{
-			const QStringList parsedDomains(options.at(i).mid(options.at(i).indexOf(QLatin1Char('=')) + 1).split(QLatin1Char('|'), QString::SkipEmptyParts));
-
-			for (int j = 0; j < parsedDomains.count(); ++j)
-			{
-				if (parsedDomains.at(j).startsWith(QLatin1Char('~')))
-				{
-					allowedDomains.append(parsedDomains.at(j).mid(1));
-
-					continue;
-				}
-
-				blockedDomains.append(parsedDomains.at(j));
-			}
-		}
-		else
-		{
-			return;
-		}
-	}
-
-	addRule(new ContentBlockingRule(rule, blockedDomains, allowedDomains, ruleOptions, ruleMatch, isException, needsDomainCheck), line);
-}
-
-void ContentBlockingProfile::parseStyleSheetRule(const QStringList &line, QMultiHash<QString, QString> &list)
-{
-	const QStringList domains(line.at(0).split(QLatin1Char(',')));
-
-	for (int i = 0; i < domains.count(); ++i)
-	{
-		list.insert(domains.at(i), line.at(1));
-	}
-}
-
-void ContentBlockingProfile::addRule(ContentBlockingRule *rule, const QString &ruleString)
-{
-	Node *node(m_root);
-
-	for (int i = 0; i < ruleString.length(); ++i)
-	{
-		const QChar value(ruleString.at(i));
-		bool childrenExists(false);
-
-		for (int j = 0; j < node->children.count(); ++j)
-		{
-			Node *nextNode(node->children.at(j));
-
-			if (nextNode->value == value)
-			{
-				node = nextNode;
-
-				childrenExists = true;
-
-				break;
-			}
-		}
-
-		if (!childrenExists)
-		{
-			Node *newNode(new Node());
-			newNode->value = value;
-
-			if (value == QLatin1Char('^'))
-			{
-				node->children.insert(0, newNode);
-			}
-			else
-			{
-				node->children.append(newNode);
-			}
-
-			node = newNode;
-		}
-	}
-
-	node->rules.append(rule);
-}
-
-void ContentBlockingProfile::deleteNode(Node *node)
-{
-	for (int i = 0; i < node->children.count(); ++i)
-	{
-		deleteNode(node->children.at(i));
-	}
+	m_loadWatcher = new QFutureWatcher<QSharedPointer<ContentBlockingRuleSet> >(this);
 
-	for (int i = 0; i < node->rules.count(); ++i)
-	{
-		delete node->rules.at(i);
-	}
+	connect(m_loadWatcher, SIGNAL(finished()), this, SLOT(loadFinished()));
 
-	delete node;
+	m_loadWatcher->setFuture(QtConcurrent::run(&ContentBlockingRuleSet::load, getPath(), getSnapshotPath(), ContentBlockingManager::getCosmeticFiltersMode(), ContentBlockingManager::areWildcardsEnabled()));
 }
 
-ContentBlockingManager::CheckResult ContentBlockingProfile::checkUrlSubstring(Node *node, const QString &subString, QString currentRule, NetworkManager::ResourceType resourceType)
+void ContentBlockingProfile::loadFinished()
 {
-	ContentBlockingManager::CheckResult result;
-	ContentBlockingManager::CheckResult currentResult;
-
-	for (int i = 0; i < subString.length(); ++i)
-	{
-		const QChar treeChar(subString.at(i));
-		bool childrenExists(false);
-
-		currentResult = evaluateRulesInNode(node, currentRule, resourceType);
-
-		if (currentResult.isBlocked)
-		{
-			result = currentResult;
-		}
-		else if (currentResult.isException)
-		{
-			return currentResult;
-		}
-
-		for (int j = 0; j < node->children.count(); ++j)
-		{
-			Node *nextNode(node->children.at(j));
-
-			if (nextNode->value == QLatin1Char('*'))
-			{
-				const QString wildcardSubString(subString.mid(i));
-
-				for (int k = 0; k < wildcardSubString.length(); ++k)
-				{
-					currentResult = checkUrlSubstring(nextNode, wildcardSubString.right(wildcardSubString.length() - k), currentRule + wildcardSubString.left(k), resourceType);
-
-					if (currentResult.isBlocked)
-					{
-						result = currentResult;
-					}
-					else if (currentResult.isException)
-					{
-						return currentResult;
-					}
-				}
-			}
-
-			if (nextNode->value == QLatin1Char('^') && !treeChar.isDigit() && !treeChar.isLetter() && !m_separators.contains(treeChar))
-			{
-				currentResult = checkUrlSubstring(nextNode, subString.mid(i), currentRule, resourceType);
-
-				if (currentResult.isBlocked)
-				{
-					result = currentResult;
-				}
-				else if (currentResult.isException)
-				{
-					return currentResult;
-				}
-			}
-
-			if (nextNode->value == treeChar)
-			{
-				node = nextNode;
-
-				childrenExists = true;
-
-				break;
-			}
-		}
-
-		if (!childrenExists)
-		{
-			return result;
-		}
-
-		currentRule += treeChar;
-	}
-
-	currentResult = evaluateRulesInNode(node, currentRule, resourceType);
-
-	if (currentResult.isBlocked)
+	if (!m_loadWatcher)
 	{
-		result = currentResult;
-	}
-	else if (currentResult.isException)
-	{
-		return currentResult;
-	}
-
-	for (int i = 0; i < node->children.count(); ++i)
-	{
-		if (node->children.at(i)->value == QLatin1Char('^'))
-		{
-			currentResult = evaluateRulesInNode(node, currentRule, resourceType);
-
-			if (currentResult.isBlocked)
-			{
-				result = currentResult;
-			}
-			else if (currentResult.isException)
-			{
-				return currentResult;
-			}
-		}
-	}
-
-	return result;
-}
-
-ContentBlockingManager::CheckResult ContentBlockingProfile::checkRuleMatch(ContentBlockingRule *rule, const QString &currentRule, NetworkManager::ResourceType resourceType)
-{
-	switch (rule->ruleMatch)
-	{
-		case StartMatch:
-			if (!m_requestUrl.startsWith(currentRule))
-			{
-				return ContentBlockingManager::CheckResult();
-			}
-
-			break;
-		case EndMatch:
-			if (!m_requestUrl.endsWith(currentRule))
-			{
-				return ContentBlockingManager::CheckResult();
-			}
-
-			break;
-		case ExactMatch:
-			if (m_requestUrl != currentRule)
-			{
-				return ContentBlockingManager::CheckResult();
-			}
-
-			break;
-		default:
-			if (!m_requestUrl.contains(currentRule))
-			{
-				return ContentBlockingManager::CheckResult();
-			}
-
-			break;
-	}
-
-	const QStringList requestSubdomainList(ContentBlockingManager::createSubdomainList(m_requestHost));
-
-	if (rule->needsDomainCheck && !requestSubdomainList.contains(currentRule.left(currentRule.indexOf(m_domainExpression))))
-	{
-		return ContentBlockingManager::CheckResult();
-	}
-
-	const bool hasBlockedDomains(!rule->blockedDomains.isEmpty());
-	const bool hasAllowedDomains(!rule->allowedDomains.isEmpty());
-	bool isBlocked(hasBlockedDomains ? resolveDomainExceptions(m_baseUrlHost, rule->blockedDomains) : true);
-	isBlocked = (hasAllowedDomains ? !resolveDomainExceptions(m_baseUrlHost, rule->allowedDomains) : isBlocked);
-
-	if (rule->ruleOptions.testFlag(ThirdPartyExceptionOption) || rule->ruleOptions.testFlag(ThirdPartyOption))
-	{
-		if (m_baseUrlHost.isEmpty() || requestSubdomainList.contains(m_baseUrlHost))
-		{
-			isBlocked = rule->ruleOptions.testFlag(ThirdPartyExceptionOption);
-		}
-		else if (!hasBlockedDomains && !hasAllowedDomains)
-		{
-			isBlocked = rule->ruleOptions.testFlag(ThirdPartyOption);
-		}
+		return;
 	}
 
-	if (rule->ruleOptions != NoOption)
-	{
-		QHash<NetworkManager::ResourceType, RuleOption>::const_iterator iterator;
-
-		for (iterator = m_resourceTypes.begin(); iterator != m_resourceTypes.end(); ++iterator)
-		{
-			const bool supportsException(iterator.value() != WebSocketOption);
-
-			if (rule->ruleOptions.testFlag(iterator.value()) || (supportsException && rule->ruleOptions.testFlag(static_cast<RuleOption>(iterator.value() * 2))))
-			{
-				if (resourceType == iterator.key())
-				{
-					isBlocked = (isBlocked ? rule->ruleOptions.testFlag(iterator.value()) : isBlocked);
-				}
-				else if (supportsException)
-				{
-					isBlocked = (isBlocked ? rule->ruleOptions.testFlag(static_cast<RuleOption>(iterator.value() * 2)) : isBlocked);
-				}
-			}
-		}
-	}
+	const QSharedPointer<ContentBlockingRuleSet> rules(m_loadWatcher->result());
 
-	if (isBlocked)
-	{
-		ContentBlockingManager::CheckResult result;
-		result.rule = rule->rule;
+	m_loadWatcher->deleteLater();
+	m_loadWatcher = nullptr;
 
-		if (rule->isException)
-		{
-			result.isBlocked = false;
-			result.isException = true;
-
-			if (rule->ruleOptions.testFlag(ElementHideOption))
-			{
-				result.comesticFiltersMode = ContentBlockingManager::NoFiltersMode;
-			}
-			else if (rule->ruleOptions.testFlag(GenericHideOption))
-			{
-				result.comesticFiltersMode = ContentBlockingManager::DomainOnlyFiltersMode;
-			}
-
-			return result;
-		}
+	m_rulesMutex.lock();
 
-		result.isBlocked = true;
+	m_rules = rules;
 
-		return result;
-	}
+	m_rulesMutex.unlock();
 
-	return ContentBlockingManager::CheckResult();
+	emit rulesModified(m_name);
 }
 
 void ContentBlockingProfile::replyFinished()
 {
-	m_isUpdating = false;
-
 	if (!m_networkReply)
 	{
+		m_isUpdating = false;
+
 		return;
 	}
 
@@ -588,54 +213,54 @@ void ContentBlockingProfile::replyFinished()
 
 	if (m_networkReply->error() != QNetworkReply::NoError || !downloadedDataHeader.trimmed().startsWith(QByteArray("[Adblock Plus")))
 	{
+		m_isUpdating = false;
+
 		Console::addMessage(QCoreApplication::translate("main", "Failed to update content blocking profile: %1").arg(m_networkReply->errorString()), Console::OtherCategory, Console::ErrorLevel, getPath());
 
 		return;
 	}
 
-	if (downloadedDataChecksum.contains(QByteArray("! Checksum: ")))
-	{
-		QByteArray checksum(downloadedDataChecksum);
-		const QByteArray verifiedChecksum(QCryptographicHash::hash(downloadedDataHeader + QString(downloadedData).replace(QRegExp(QLatin1String("^*\n{2,}")), QLatin1String("\n")).toStdString().c_str(), QCryptographicHash::Md5));
+	m_updateWatcher = new QFutureWatcher<RulesUpdate>(this);
 
-		if (verifiedChecksum.toBase64().replace(QByteArray("="), QByteArray()) != checksum.replace(QByteArray("! Checksum: "), QByteArray()).replace(QByteArray("\n"), QByteArray()))
-		{
-			Console::addMessage(QCoreApplication::translate("main", "Failed to update content blocking profile: checksum mismatch"), Console::OtherCategory, Console::ErrorLevel, getPath());
+	connect(m_updateWatcher, SIGNAL(finished()), this, SLOT(updateFinished()));
 
-			return;
-		}
-	}
+	const QString path(getPath());
+	const QString snapshotPath(getSnapshotPath());
+	const ContentBlockingManager::CosmeticFiltersMode cosmeticFiltersMode(ContentBlockingManager::getCosmeticFiltersMode());
+	const bool areWildcardsEnabled(ContentBlockingManager::areWildcardsEnabled());
 
-	QDir().mkpath(SessionsManager::getWritableDataPath(QLatin1String("contentBlocking")));
+	m_updateWatcher->setFuture(QtConcurrent::run([=]()
+	{
+		return updateRules(downloadedDataHeader, downloadedDataChecksum, downloadedData, path, snapshotPath, cosmeticFiltersMode, areWildcardsEnabled);
+	}));
+}
 
-	QFile file(SessionsManager::getWritableDataPath(QLatin1String("contentBlocking/%1.txt")).arg(m_name));
+void ContentBlockingProfile::updateFinished()
+{
+	m_isUpdating = false;
 
-	if (!file.open(QIODevice::ReadWrite | QIODevice::Truncate))
+	if (!m_updateWatcher)
 	{
-		Console::addMessage(QCoreApplication::translate("main", "Failed to update content blocking profile: %1").arg(file.errorString()), Console::OtherCategory, Console::ErrorLevel, file.fileName());
-
 		return;
 	}
 
-	file.write(downloadedDataHeader);
-	file.write(downloadedDataChecksum);
-	file.write(downloadedData);
-	file.close();
+	const RulesUpdate update(m_updateWatcher->result());
 
-	m_lastUpdate = QDateTime::currentDateTime();
+	m_updateWatcher->deleteLater();
+	m_updateWatcher = nullptr;
 
-	if (file.error() != QFile::NoError)
+	if (!update.errorString.isEmpty())
 	{
-// TODO
+		Console::addMessage(update.errorString, Console::OtherCategory, Console::ErrorLevel, update.errorPath);
+
+		return;
 	}
 
-	clear();
+	m_lastUpdate = QDateTime::currentDateTime();
+
 	loadHeader(getPath());
 
-	if (m_wasLoaded)
-	{
-		loadRules();
-	}
+	setRules(update.rules);
 
 	emit profileModified(m_name);
 }
@@ -682,6 +307,29 @@ void ContentBlockingProfile::setTitle(const QString &title)
 	}
 }
 
+void ContentBlockingProfile::setRules(const QSharedPointer<ContentBlockingRuleSet> &rules)
+{
+	if (m_isLoadRequested.load() == 0)
+	{
+		return;
+	}
+
+	if (m_loadWatcher)
+	{
+		m_loadWatcher->disconnect(this);
+		m_loadWatcher->deleteLater();
+		m_loadWatcher = nullptr;
+	}
+
+	m_rulesMutex.lock();
+
+	m_rules = rules;
+
+	m_rulesMutex.unlock();
+
+	emit rulesModified(m_name);
+}
+
 QString ContentBlockingProfile::getName() const
 {
 	return m_name;
@@ -697,79 +345,63 @@ QString ContentBlockingProfile::getPath() const
 	return SessionsManager::getWritableDataPath(QLatin1String("contentBlocking/%1.txt")).arg(m_name);
 }
 
-QDateTime ContentBlockingProfile::getLastUpdate() const
+QString ContentBlockingProfile::getSnapshotPath() const
 {
-	return m_lastUpdate;
+	return SessionsManager::getWritableDataPath(QLatin1String("contentBlocking/%1.dat")).arg(m_name);
 }
 
-QUrl ContentBlockingProfile::getUpdateUrl() const
+QSharedPointer<ContentBlockingRuleSet> ContentBlockingProfile::getRules()
 {
-	return m_updateUrl;
-}
+	m_rulesMutex.lock();
 
-ContentBlockingManager::CheckResult ContentBlockingProfile::checkUrl(const QUrl &baseUrl, const QUrl &requestUrl, NetworkManager::ResourceType resourceType)
-{
-	ContentBlockingManager::CheckResult result;
+	const QSharedPointer<ContentBlockingRuleSet> rules(m_rules);
 
-	if (!m_wasLoaded && !loadRules())
+	m_rulesMutex.unlock();
+
+	if (!rules && m_isLoadRequested.testAndSetOrdered(0, 1))
 	{
-		return result;
+		QMetaObject::invokeMethod(this, "loadRules", Qt::QueuedConnection);
 	}
 
-	m_baseUrlHost = baseUrl.host();
-	m_requestUrl = requestUrl.url();
-	m_requestHost = requestUrl.host();
+	return rules;
+}
 
-	if (m_requestUrl.startsWith(QLatin1String("//")))
-	{
-		m_requestUrl = m_requestUrl.mid(2);
-	}
+QDateTime ContentBlockingProfile::getLastUpdate() const
+{
+	return m_lastUpdate;
+}
 
-	for (int i = 0; i < m_requestUrl.length(); ++i)
-	{
-		ContentBlockingManager::CheckResult currentResult(checkUrlSubstring(m_root, m_requestUrl.right(m_requestUrl.length() - i), QString(), resourceType));
+QUrl ContentBlockingProfile::getUpdateUrl() const
+{
+	return m_updateUrl;
+}
 
-		if (currentResult.isBlocked)
-		{
-			result = currentResult;
-		}
-		else if (currentResult.isException)
-		{
-			return currentResult;
-		}
-	}
+ContentBlockingManager::CheckResult ContentBlockingProfile::checkUrl(const QUrl &baseUrl, const QUrl &requestUrl, NetworkManager::ResourceType resourceType)
+{
+	const QSharedPointer<ContentBlockingRuleSet> rules(getRules());
 
-	return result;
+	return (rules ? rules->checkUrl(baseUrl, requestUrl, resourceType) : ContentBlockingManager::CheckResult());
 }
 
 QStringList ContentBlockingProfile::getStyleSheet()
 {
-	if (!m_wasLoaded)
-	{
-		loadRules();
-	}
+	const QSharedPointer<ContentBlockingRuleSet> rules(getRules());
 
-	return m_styleSheet;
+	return (rules ? rules->getStyleSheet() : QStringList());
 }
 
 QStringList ContentBlockingProfile::getStyleSheetBlackList(const QString &domain)
 {
-	if (!m_wasLoaded)
-	{
-		loadRules();
-	}
+	const QSharedPointer<ContentBlockingRuleSet> rules(getRules());
 
-	return m_styleSheetBlackList.values(domain);
+	return (rules ? rules->getStyleSheetBlackList(domain) : QStringList());
 }
 
 QStringList ContentBlockingProfile::getStyleSheetWhiteList(const QString &domain)
 {
-	if (!m_wasLoaded)
-	{
-		loadRules();
-	}
+	const QSharedPointer<ContentBlockingRuleSet> rules(getRules());
 
-	return m_styleSheetWhiteList.values(domain);
+	return (rules ? rules->getStyleSheetWhiteList(domain) : QStringList());
 }
 
 QList<QLocale::Language> ContentBlockingProfile::getLanguages() const
@@ -827,76 +459,50 @@ bool ContentBlockingProfile::downloadRules()
 	return true;
 }
 
-ContentBlockingManager::CheckResult ContentBlockingProfile::evaluateRulesInNode(Node *node, const QString &currentRule, NetworkManager::ResourceType resourceType)
+ContentBlockingProfile::RulesUpdate ContentBlockingProfile::updateRules(const QByteArray &header, const QByteArray &checksum, const QByteArray &data, const QString &path, const QString &snapshotPath, ContentBlockingManager::CosmeticFiltersMode cosmeticFiltersMode, bool areWildcardsEnabled)
 {
-	ContentBlockingManager::CheckResult result;
+	RulesUpdate update;
 
-	for (int i = 0; i < node->rules.count(); ++i)
+	if (checksum.contains(QByteArray("! Checksum: ")))
 	{
-		if (node->rules.at(i))
+		const QByteArray verifiedChecksum(QCryptographicHash::hash(header + QString(data).replace(QRegExp(QLatin1String("^*\n{2,}")), QLatin1String("\n")).toStdString().c_str(), QCryptographicHash::Md5));
+
+		if (verifiedChecksum.toBase64().replace(QByteArray("="), QByteArray()) != QByteArray(checksum).replace(QByteArray("! Checksum: "), QByteArray()).replace(QByteArray("\n"), QByteArray()))
 		{
-			ContentBlockingManager::CheckResult currentResult(checkRuleMatch(node->rules.at(i), currentRule, resourceType));
-
-			if (currentResult.isBlocked)
-			{
-				result = currentResult;
-			}
-			else if (currentResult.isException)
-			{
-				return currentResult;
-			}
+			update.errorString = QCoreApplication::translate("main", "Failed to update content blocking profile: checksum mismatch");
+			update.errorPath = path;
+
+			return update;
 		}
 	}
 
-	return result;
-}
+	QDir().mkpath(QFileInfo(path).absolutePath());
 
-bool ContentBlockingProfile::loadRules()
-{
-	if (m_isEmpty && !m_updateUrl.isEmpty())
+	QSaveFile file(path);
+
+	if (!file.open(QIODevice::WriteOnly))
 	{
-		downloadRules();
+		update.errorString = QCoreApplication::translate("main", "Failed to update content blocking profile: %1").arg(file.errorString());
+		update.errorPath = file.fileName();
 
-		return false;
+		return update;
 	}
 
-	m_wasLoaded = true;
+	file.write(header);
+	file.write(checksum);
+	file.write(data);
 
-	if (m_domainExpression.pattern().isEmpty())
+	if (!file.commit())
 	{
-		m_domainExpression = QRegularExpression(QLatin1String("[:\?&/=]"));
-		m_domainExpression.optimize();
-	}
-
-	QFile file(getPath());
-	file.open(QIODevice::ReadOnly | QIODevice::Text);
+		update.errorString = QCoreApplication::translate("main", "Failed to update content blocking profile: %1").arg(file.errorString());
+		update.errorPath = path;
 
-	QTextStream stream(&file);
-	stream.readLine(); // header
-
-	m_root = new Node();
-
-	while (!stream.atEnd())
-	{
-		parseRuleLine(stream.readLine());
+		return update;
 	}
 
-	file.close();
-
-	return true;
-}
-
-bool ContentBlockingProfile::resolveDomainExceptions(const QString &url, const QStringList &ruleList)
-{
-	for (int i = 0; i < ruleList.count(); ++i)
-	{
-		if (url.contains(ruleList.at(i)))
-		{
-			return true;
-		}
-	}
+	update.rules = ContentBlockingRuleSet::load(path, snapshotPath, cosmeticFiltersMode, areWildcardsEnabled);
 
-	return false;
+	return update;
 }
 
 }
@@ -24,11 +24,16 @@
 
 #include "ContentBlockingManager.h"
 
-#include <QtCore/QRegularExpression>
+#include <QtCore/QAtomicInt>
+#include <QtCore/QFutureWatcher>
+#include <QtCore/QMutex>
+#include <QtCore/QSharedPointer>
 
 namespace Otter
 {
 
+class ContentBlockingRuleSet;
+
 class ContentBlockingProfile : public QObject
 {
 	Q_OBJECT
@@ -72,108 +77,53 @@ public:
 	ProfileCategory getCategory() const;
 	ProfileFlags getFlags() const;
 	int getUpdateInterval() const;
+
+public slots:
 	bool downloadRules();
 
 protected:
-	enum RuleOption : quint32
-	{
-		NoOption = 0,
-		ThirdPartyOption = 1,
-		ThirdPartyExceptionOption = 2,
-		StyleSheetOption = 4,
-		StyleSheetExceptionOption = 8,
-		ScriptOption = 16,
-		ScriptExceptionOption = 32,
-		ImageOption = 64,
-		ImageExceptionOption = 128,
-		ObjectOption = 256,
-		ObjectExceptionOption = 512,
-		ObjectSubRequestOption = 1024,
-		ObjectSubRequestExceptionOption = 2048,
-		SubDocumentOption = 4096,
-		SubDocumentExceptionOption = 8192,
-		XmlHttpRequestOption = 16384,
-		XmlHttpRequestExceptionOption = 32768,
-		WebSocketOption = 65536,
-		ElementHideOption = 131072,
-		GenericHideOption = 262144
-	};
-
-	Q_DECLARE_FLAGS(RuleOptions, RuleOption)
-
-	enum RuleMatch
-	{
-		ContainsMatch = 0,
-		StartMatch,
-		EndMatch,
-		ExactMatch
-	};
-
-	struct ContentBlockingRule
+	struct RulesUpdate
 	{
-		QString rule;
-		QStringList blockedDomains;
-		QStringList allowedDomains;
-		RuleOptions ruleOptions = NoOption;
-		RuleMatch ruleMatch = ContainsMatch;
-		bool isException = false;
-		bool needsDomainCheck = false;
-
-		explicit ContentBlockingRule(QString ruleValue, QStringList blockedDomainsValue, QStringList allowedDomainsValue, RuleOptions ruleOptionsValue, RuleMatch ruleMatchValue, bool isExceptionValue, bool needsDomainCheckValue) : rule(ruleValue), blockedDomains(blockedDomainsValue), allowedDomains(allowedDomainsValue), ruleOptions(ruleOptionsValue), ruleMatch(ruleMatchValue), isException(isExceptionValue), needsDomainCheck(needsDomainCheckValue)
-		{
-		}
+		QSharedPointer<ContentBlockingRuleSet> rules;
+		QString errorString;
+		QString errorPath;
 	};
 
-	struct Node
-	{
-		QChar value = 0;
-		QVarLengthArray<Node*, 1> children;
-		QVarLengthArray<ContentBlockingRule*, 1> rules;
-	};
-
-	QString getPath() const;
 	void loadHeader(const QString &path);
-	void parseRuleLine(QString line);
-	void parseStyleSheetRule(const QStringList &line, QMultiHash<QString, QString> &list);
-	void addRule(ContentBlockingRule *rule, const QString &ruleString);
-	void deleteNode(Node *node);
-	ContentBlockingManager::CheckResult checkUrlSubstring(Node *node, const QString &subString, QString currentRule, NetworkManager::ResourceType resourceType);
-	ContentBlockingManager::CheckResult checkRuleMatch(ContentBlockingRule *rule, const QString &currentRule, NetworkManager::ResourceType resourceType);
-	ContentBlockingManager::CheckResult evaluateRulesInNode(Node *node, const QString &currentRule, NetworkManager::ResourceType resourceType);
-	bool loadRules();
-	bool resolveDomainExceptions(const QString &url, const QStringList &ruleList);
+	void setRules(const QSharedPointer<ContentBlockingRuleSet> &rules);
+	QString getPath() const;
+	QString getSnapshotPath() const;
+	QSharedPointer<ContentBlockingRuleSet> getRules();
+	static RulesUpdate updateRules(const QByteArray &header, const QByteArray &checksum, const QByteArray &data, const QString &path, const QString &snapshotPath, ContentBlockingManager::CosmeticFiltersMode cosmeticFiltersMode, bool areWildcardsEnabled);
 
 protected slots:
+	void loadRules();
+	void loadFinished();
 	void replyFinished();
+	void updateFinished();
 
 private:
-	Node *m_root;
+	QSharedPointer<ContentBlockingRuleSet> m_rules;
 	QNetworkReply *m_networkReply;
-	QString m_requestUrl;
-	QString m_requestHost;
-	QString m_baseUrlHost;
+	QFutureWatcher<QSharedPointer<ContentBlockingRuleSet> > *m_loadWatcher;
+	QFutureWatcher<RulesUpdate> *m_updateWatcher;
 	QString m_name;
 	QString m_title;
 	QUrl m_updateUrl;
 	QDateTime m_lastUpdate;
-	QRegularExpression m_domainExpression;
-	QStringList m_styleSheet;
 	QList<QLocale::Language> m_languages;
-	QMultiHash<QString, QString> m_styleSheetBlackList;
-	QMultiHash<QString, QString> m_styleSheetWhiteList;
 	ProfileCategory m_category;
 	ProfileFlags m_flags;
 	int m_updateInterval;
 	bool m_isUpdating;
 	bool m_isEmpty;
-	bool m_wasLoaded;
 
-	static QList<QChar> m_separators;
-	static QHash<QString, RuleOption> m_options;
-	static QHash<NetworkManager::ResourceType, RuleOption> m_resourceTypes;
+	QAtomicInt m_isLoadRequested;
+	QMutex m_rulesMutex;
 
 signals:
 	void profileModified(const QString &profile);
+	void rulesModified(const QString &profile);
 };
 
 }
@@ -0,0 +1,985 @@
+/**************************************************************************
+* Otter Browser: Web browser controlled by the user, not vice-versa.
+* Copyright (C) 2014 - 2016 Jan Bajer aka bajasoft <jbajer@gmail.com>
+* Copyright (C) 2015 - 2016 Michal Dutkiewicz aka Emdek <michal@emdek.pl>
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program. If not, see <http://www.gnu.org/licenses/>.
+*
+**************************************************************************/
+
+#include "ContentBlockingRuleSet.h"
+
+#include <QtCore/QCryptographicHash>
+#include <QtCore/QSaveFile>
+#include <QtCore/QTextStream>
+
+#include <algorithm>
+#include <cstring>
+
+namespace Otter
+{
+
+QHash<QString, ContentBlockingRuleSet::RuleOption> ContentBlockingRuleSet::m_options({{QLatin1String("third-party"), ThirdPartyOption}, {QLatin1String("stylesheet"), StyleSheetOption}, {QLatin1String("image"), ImageOption}, {QLatin1String("script"), ScriptOption}, {QLatin1String("object"), ObjectOption}, {QLatin1String("object-subrequest"), ObjectSubRequestOption}, {QLatin1String("object_subrequest"), ObjectSubRequestOption}, {QLatin1String("subdocument"), SubDocumentOption}, {QLatin1String("xmlhttprequest"), XmlHttpRequestOption}, {QLatin1String("websocket"), WebSocketOption}, {QLatin1String("elemhide"), ElementHideOption}, {QLatin1String("generichide"), GenericHideOption}});
+QHash<NetworkManager::ResourceType, ContentBlockingRuleSet::RuleOption> ContentBlockingRuleSet::m_resourceTypes({{NetworkManager::ImageType, ImageOption}, {NetworkManager::ScriptType, ScriptOption}, {NetworkManager::StyleSheetType, StyleSheetOption}, {NetworkManager::ObjectType, ObjectOption}, {NetworkManager::XmlHttpRequestType, XmlHttpRequestOption}, {NetworkManager::SubFrameType, SubDocumentOption}, {NetworkManager::ObjectSubrequestType, ObjectSubRequestOption}, {NetworkManager::WebSocketType, WebSocketOption}});
+const int ContentBlockingRuleSet::m_keyLength(4);
+const quint32 ContentBlockingRuleSet::m_snapshotMagic(0x4f434252);
+const quint32 ContentBlockingRuleSet::m_snapshotVersion(3);
+
+ContentBlockingRuleSet::ContentBlockingRuleSet(ContentBlockingManager::CosmeticFiltersMode cosmeticFiltersMode, bool areWildcardsEnabled) : m_snapshotFile(nullptr),
+	m_header(nullptr),
+	m_index(nullptr),
+	m_rules(nullptr),
+	m_unindexedRules(nullptr),
+	m_styleSheet(nullptr),
+	m_styleSheetBlackList(nullptr),
+	m_styleSheetWhiteList(nullptr),
+	m_strings(nullptr),
+	m_cosmeticFiltersMode(cosmeticFiltersMode),
+	m_areWildcardsEnabled(areWildcardsEnabled)
+{
+}
+
+ContentBlockingRuleSet::~ContentBlockingRuleSet()
+{
+	m_data.clear();
+
+	if (m_snapshotFile)
+	{
+		m_snapshotFile->close();
+
+		delete m_snapshotFile;
+	}
+}
+
+void ContentBlockingRuleSet::parseRuleLine(QString line)
+{
+	if (line.indexOf(QLatin1Char('!')) == 0 || line.isEmpty())
+	{
+		return;
+	}
+
+	if (line.startsWith(QLatin1String("##")))
+	{
+		if (m_cosmeticFiltersMode == ContentBlockingManager::AllFiltersMode && isValidSelector(line.mid(2)))
+		{
+			m_parsedStyleSheet.append(line.mid(2));
+		}
+
+		return;
+	}
+
+	if (line.contains(QLatin1String("##")))
+	{
+		if (m_cosmeticFiltersMode != ContentBlockingManager::NoFiltersMode)
+		{
+			parseStyleSheetRule(line.split(QLatin1String("##")), m_parsedStyleSheetBlackList);
+		}
+
+		return;
+	}
+
+	if (line.contains(QLatin1String("#@#")))
+	{
+		if (m_cosmeticFiltersMode != ContentBlockingManager::NoFiltersMode)
+		{
+			parseStyleSheetRule(line.split(QLatin1String("#@#")), m_parsedStyleSheetWhiteList);
+		}
+
+		return;
+	}
+
+	parseNetworkRule(line);
+}
+
+void ContentBlockingRuleSet::parseNetworkRule(QString line)
+{
+	const QString rule(line);
+	QStringList options;
+	const int optionSeparator(line.indexOf(QLatin1Char('$')));
+
+	if (optionSeparator >= 0)
+	{
+		options = line.mid(optionSeparator + 1).split(QLatin1Char(','), QString::SkipEmptyParts);
+
+		line = line.left(optionSeparator);
+	}
+
+	if (line.endsWith(QLatin1Char('*')))
+	{
+		line = line.left(line.length() - 1);
+	}
+
+	if (line.startsWith(QLatin1Char('*')))
+	{
+		line = line.mid(1);
+	}
+
+	if (!m_areWildcardsEnabled && line.contains(QLatin1Char('*')))
+	{
+		return;
+	}
+
+	ContentBlockingRule contentBlockingRule;
+	contentBlockingRule.rule = rule;
+
+	if (line.startsWith(QLatin1String("@@")))
+	{
+		line = line.mid(2);
+
+		contentBlockingRule.isException = true;
+	}
+
+	if (line.startsWith(QLatin1String("||")))
+	{
+		line = line.mid(2);
+
+		contentBlockingRule.needsDomainCheck = true;
+	}
+
+	if (line.startsWith(QLatin1Char('|')))
+	{
+		contentBlockingRule.ruleMatch = StartMatch;
+
+		line = line.mid(1);
+	}
+
+	if (line.endsWith(QLatin1Char('|')))
+	{
+		contentBlockingRule.ruleMatch = ((contentBlockingRule.ruleMatch == StartMatch) ? ExactMatch : EndMatch);
+
+		line = line.left(line.length() - 1);
+	}
+
+	for (int i = 0; i < options.count(); ++i)
+	{
+		const bool optionException(options.at(i).startsWith(QLatin1Char('~')));
+		const QString optionName(optionException ? options.at(i).mid(1) : options.at(i));
+
+		if (m_options.contains(optionName))
+		{
+			const RuleOption option(m_options.value(optionName));
+
+			if ((!contentBlockingRule.isException || optionException) && (option == ElementHideOption || option == GenericHideOption))
+			{
+				continue;
+			}
+			else if (!optionException)
+			{
+				contentBlockingRule.ruleOptions |= option;
+			}
+			else if (option != WebSocketOption)
+			{
+				contentBlockingRule.ruleOptions |= static_cast<RuleOption>(option * 2);
+			}
+		}
+		else if (optionName.startsWith(QLatin1String("domain")))
+		{
+			const QStringList parsedDomains(options.at(i).mid(options.at(i).indexOf(QLatin1Char('=')) + 1).split(QLatin1Char('|'), QString::SkipEmptyParts));
+
+			for (int j = 0; j < parsedDomains.count(); ++j)
+			{
+				if (parsedDomains.at(j).startsWith(QLatin1Char('~')))
+				{
+					contentBlockingRule.allowedDomains.append(parsedDomains.at(j).mid(1));
+
+					continue;
+				}
+
+				contentBlockingRule.blockedDomains.append(parsedDomains.at(j));
+			}
+		}
+		else
+		{
+			return;
+		}
+	}
+
+	contentBlockingRule.pattern = line;
+
+	m_parsedRules.append(contentBlockingRule);
+}
+
+void ContentBlockingRuleSet::parseStyleSheetRule(const QStringList &line, QMultiHash<QString, QString> &list)
+{
+	if (!isValidSelector(line.at(1)))
+	{
+		return;
+	}
+
+	const QStringList domains(line.at(0).split(QLatin1Char(',')));
+
+	for (int i = 0; i < domains.count(); ++i)
+	{
+		list.insert(domains.at(i), line.at(1));
+	}
+}
+
+void ContentBlockingRuleSet::build()
+{
+	QHash<quint64, int> frequencies;
+
+	for (int i = 0; i < m_parsedRules.count(); ++i)
+	{
+		const QVector<quint64> keys(getPatternKeys(m_parsedRules.at(i).pattern));
+
+		for (int j = 0; j < keys.count(); ++j)
+		{
+			++frequencies[keys.at(j)];
+		}
+	}
+
+	QVector<IndexEntry> index;
+	index.reserve(m_parsedRules.count());
+
+	QVector<quint32> unindexedRules;
+
+	for (int i = 0; i < m_parsedRules.count(); ++i)
+	{
+		const QVector<quint64> keys(getPatternKeys(m_parsedRules.at(i).pattern));
+
+		if (keys.isEmpty())
+		{
+			unindexedRules.append(i);
+
+			continue;
+		}
+
+		IndexEntry entry;
+		entry.key = keys.at(0);
+		entry.rule = i;
+
+		int frequency(frequencies.value(entry.key));
+
+		for (int j = 1; j < keys.count(); ++j)
+		{
+			const int keyFrequency(frequencies.value(keys.at(j)));
+
+			if (keyFrequency < frequency)
+			{
+				entry.key = keys.at(j);
+
+				frequency = keyFrequency;
+			}
+		}
+
+		index.append(entry);
+	}
+
+	std::sort(index.begin(), index.end());
+
+	QString strings;
+	QHash<QString, StringReference> stringReferences;
+	QVector<RuleRecord> rules;
+	rules.reserve(m_parsedRules.count());
+
+	for (int i = 0; i < m_parsedRules.count(); ++i)
+	{
+		const ContentBlockingRule &rule(m_parsedRules.at(i));
+		RuleRecord record;
+		record.rule = addString(rule.rule, strings, stringReferences);
+		record.pattern = addString(rule.pattern, strings, stringReferences);
+		record.blockedDomains = addString(rule.blockedDomains.join(QLatin1Char('|')), strings, stringReferences);
+		record.allowedDomains = addString(rule.allowedDomains.join(QLatin1Char('|')), strings, stringReferences);
+		record.ruleOptions = static_cast<quint32>(rule.ruleOptions);
+		record.ruleMatch = static_cast<quint8>(rule.ruleMatch);
+		record.isException = (rule.isException ? 1 : 0);
+		record.needsDomainCheck = (rule.needsDomainCheck ? 1 : 0);
+
+		rules.append(record);
+	}
+
+	QVector<StringReference> styleSheet;
+	styleSheet.reserve(m_parsedStyleSheet.count());
+
+	for (int i = 0; i < m_parsedStyleSheet.count(); ++i)
+	{
+		styleSheet.append(addString(m_parsedStyleSheet.at(i), strings, stringReferences));
+	}
+
+	const QVector<StyleSheetEntry> styleSheetBlackList(createStyleSheetEntries(m_parsedStyleSheetBlackList, strings, stringReferences));
+	const QVector<StyleSheetEntry> styleSheetWhiteList(createStyleSheetEntries(m_parsedStyleSheetWhiteList, strings, stringReferences));
+	DataHeader header;
+	header.rulesAmount = rules.count();
+	header.indexAmount = index.count();
+	header.unindexedRulesAmount = unindexedRules.count();
+	header.styleSheetAmount = styleSheet.count();
+	header.styleSheetBlackListAmount = styleSheetBlackList.count();
+	header.styleSheetWhiteListAmount = styleSheetWhiteList.count();
+	header.stringsLength = strings.length();
+
+	m_data.clear();
+	m_data.reserve(sizeof(DataHeader) + (index.count() * sizeof(IndexEntry)) + (rules.count() * sizeof(RuleRecord)) + (unindexedRules.count() * sizeof(quint32)) + (styleSheet.count() * sizeof(StringReference)) + ((styleSheetBlackList.count() + styleSheetWhiteList.count()) * sizeof(StyleSheetEntry)) + (strings.length() * sizeof(QChar)));
+	m_data.append(reinterpret_cast<const char*>(&header), sizeof(DataHeader));
+	m_data.append(reinterpret_cast<const char*>(index.constData()), (index.count() * sizeof(IndexEntry)));
+	m_data.append(reinterpret_cast<const char*>(rules.constData()), (rules.count() * sizeof(RuleRecord)));
+	m_data.append(reinterpret_cast<const char*>(unindexedRules.constData()), (unindexedRules.count() * sizeof(quint32)));
+	m_data.append(reinterpret_cast<const char*>(styleSheet.constData()), (styleSheet.count() * sizeof(StringReference)));
+	m_data.append(reinterpret_cast<const char*>(styleSheetBlackList.constData()), (styleSheetBlackList.count() * sizeof(StyleSheetEntry)));
+	m_data.append(reinterpret_cast<const char*>(styleSheetWhiteList.constData()), (styleSheetWhiteList.count() * sizeof(StyleSheetEntry)));
+	m_data.append(reinterpret_cast<const char*>(strings.constData()), (strings.length() * sizeof(QChar)));
+
+	m_parsedRules.clear();
+	m_parsedStyleSheet.clear();
+	m_parsedStyleSheetBlackList.clear();
+	m_parsedStyleSheetWhiteList.clear();
+
+	attachData();
+}
+
+ContentBlockingManager::CheckResult ContentBlockingRuleSet::checkUrl(const QUrl &baseUrl, const QUrl &requestUrl, NetworkManager::ResourceType resourceType) const
+{
+	if (!m_header)
+	{
+		return ContentBlockingManager::CheckResult();
+	}
+
+	MatchContext context;
+	context.requestUrl = requestUrl.url();
+	context.baseUrlHost = baseUrl.host();
+	context.requestSubdomainList = ContentBlockingManager::createSubdomainList(requestUrl.host());
+	context.resourceType = resourceType;
+
+	if (context.requestUrl.startsWith(QLatin1String("//")))
+	{
+		context.requestUrl = context.requestUrl.mid(2);
+	}
+
+	QVector<quint32> candidates;
+	candidates.reserve(m_header->unindexedRulesAmount);
+
+	for (quint32 i = 0; i < m_header->unindexedRulesAmount; ++i)
+	{
+		candidates.append(m_unindexedRules[i]);
+	}
+
+	const IndexEntry *indexEnd(m_index + m_header->indexAmount);
+	const QChar *characters(context.requestUrl.constData());
+
+	for (int i = 0; i <= (context.requestUrl.length() - m_keyLength); ++i)
+	{
+		IndexEntry entry;
+		entry.key = createKey(characters + i);
+
+		const IndexEntry *iterator(std::lower_bound(m_index, indexEnd, entry));
+
+		while (iterator != indexEnd && iterator->key == entry.key)
+		{
+			candidates.append(iterator->rule);
+
+			++iterator;
+		}
+	}
+
+	std::sort(candidates.begin(), candidates.end());
+
+	candidates.erase(std::unique(candidates.begin(), candidates.end()), candidates.end());
+
+	ContentBlockingManager::CheckResult result;
+
+	for (int i = 0; i < candidates.count(); ++i)
+	{
+		const ContentBlockingManager::CheckResult currentResult(checkRuleMatch(m_rules[candidates.at(i)], context));
+
+		if (currentResult.isBlocked)
+		{
+			result = currentResult;
+		}
+		else if (currentResult.isException)
+		{
+			return currentResult;
+		}
+	}
+
+	return result;
+}
+
+ContentBlockingManager::CheckResult ContentBlockingRuleSet::checkRuleMatch(const RuleRecord &rule, const MatchContext &context) const
+{
+	const RuleMatch ruleMatch(static_cast<RuleMatch>(rule.ruleMatch));
+	bool hasMatch(false);
+
+	if (ruleMatch == StartMatch || ruleMatch == ExactMatch)
+	{
+		hasMatch = matchPattern(rule, context, 0, 0, 0);
+	}
+	else
+	{
+		for (int i = 0; i < context.requestUrl.length(); ++i)
+		{
+			if (matchPattern(rule, context, i, 0, i))
+			{
+				hasMatch = true;
+
+				break;
+			}
+		}
+	}
+
+	if (!hasMatch)
+	{
+		return ContentBlockingManager::CheckResult();
+	}
+
+	const RuleOptions ruleOptions(static_cast<RuleOption>(rule.ruleOptions));
+	const bool hasBlockedDomains(rule.blockedDomains.length > 0);
+	const bool hasAllowedDomains(rule.allowedDomains.length > 0);
+	bool isBlocked(hasBlockedDomains ? resolveDomainExceptions(context.baseUrlHost, rule.blockedDomains) : true);
+	isBlocked = (hasAllowedDomains ? !resolveDomainExceptions(context.baseUrlHost, rule.allowedDomains) : isBlocked);
+
+	if (ruleOptions.testFlag(ThirdPartyExceptionOption) || ruleOptions.testFlag(ThirdPartyOption))
+	{
+		if (context.baseUrlHost.isEmpty() || context.requestSubdomainList.contains(context.baseUrlHost))
+		{
+			isBlocked = ruleOptions.testFlag(ThirdPartyExceptionOption);
+		}
+		else if (!hasBlockedDomains && !hasAllowedDomains)
+		{
+			isBlocked = ruleOptions.testFlag(ThirdPartyOption);
+		}
+	}
+
+	if (ruleOptions != NoOption)
+	{
+		QHash<NetworkManager::ResourceType, RuleOption>::const_iterator iterator;
+
+		for (iterator = m_resourceTypes.constBegin(); iterator != m_resourceTypes.constEnd(); ++iterator)
+		{
+			const bool supportsException(iterator.value() != WebSocketOption);
+
+			if (ruleOptions.testFlag(iterator.value()) || (supportsException && ruleOptions.testFlag(static_cast<RuleOption>(iterator.value() * 2))))
+			{
+				if (context.resourceType == iterator.key())
+				{
+					isBlocked = (isBlocked ? ruleOptions.testFlag(iterator.value()) : isBlocked);
+				}
+				else if (supportsException)
+				{
+					isBlocked = (isBlocked ? ruleOptions.testFlag(static_cast<RuleOption>(iterator.value() * 2)) : isBlocked);
+				}
+			}
+		}
+	}
+
+	if (isBlocked)
+	{
+		ContentBlockingManager::CheckResult result;
+		result.rule = getString(rule.rule);
+
+		if (rule.isException)
+		{
+			result.isBlocked = false;
+			result.isException = true;
+
+			if (ruleOptions.testFlag(ElementHideOption))
+			{
+				result.comesticFiltersMode = ContentBlockingManager::NoFiltersMode;
+			}
+			else if (ruleOptions.testFlag(GenericHideOption))
+			{
+				result.comesticFiltersMode = ContentBlockingManager::DomainOnlyFiltersMode;
+			}
+
+			return result;
+		}
+
+		result.isBlocked = true;
+
+		return result;
+	}
+
+	return ContentBlockingManager::CheckResult();
+}
+
+QString ContentBlockingRuleSet::getString(const StringReference &reference) const
+{
+	return QString(m_strings + reference.offset, reference.length);
+}
+
+QStringList ContentBlockingRuleSet::getStyleSheet() const
+{
+	QStringList styleSheet;
+
+	if (!m_header)
+	{
+		return styleSheet;
+	}
+
+	styleSheet.reserve(m_header->styleSheetAmount);
+
+	for (quint32 i = 0; i < m_header->styleSheetAmount; ++i)
+	{
+		styleSheet.append(getString(m_styleSheet[i]));
+	}
+
+	return styleSheet;
+}
+
+QStringList ContentBlockingRuleSet::getStyleSheetBlackList(const QString &domain) const
+{
+	return (m_header ? getStyleSheetEntries(m_styleSheetBlackList, m_header->styleSheetBlackListAmount, domain) : QStringList());
+}
+
+QStringList ContentBlockingRuleSet::getStyleSheetWhiteList(const QString &domain) const
+{
+	return (m_header ? getStyleSheetEntries(m_styleSheetWhiteList, m_header->styleSheetWhiteListAmount, domain) : QStringList());
+}
+
+QStringList ContentBlockingRuleSet::getStyleSheetEntries(const StyleSheetEntry *entries, quint32 amount, const QString &domain) const
+{
+	const QChar *domainBegin(domain.constData());
+	const QChar *domainEnd(domainBegin + domain.length());
+	quint32 low(0);
+	quint32 high(amount);
+
+	while (low < high)
+	{
+		const quint32 middle(low + ((high - low) / 2));
+		const QChar *entryDomain(m_strings + entries[middle].domain.offset);
+
+		if (std::lexicographical_compare(entryDomain, (entryDomain + entries[middle].domain.length), domainBegin, domainEnd))
+		{
+			low = (middle + 1);
+		}
+		else
+		{
+			high = middle;
+		}
+	}
+
+	QStringList rules;
+
+	for (quint32 i = low; i < amount; ++i)
+	{
+		const QChar *entryDomain(m_strings + entries[i].domain.offset);
+
+		if (static_cast<int>(entries[i].domain.length) != domain.length() || !std::equal(domainBegin, domainEnd, entryDomain))
+		{
+			break;
+		}
+
+		rules.append(getString(entries[i].rule));
+	}
+
+	return rules;
+}
+
+QVector<quint64> ContentBlockingRuleSet::getPatternKeys(const QString &pattern) const
+{
+	QVector<quint64> keys;
+	int segmentStart(0);
+
+	for (int i = 0; i <= pattern.length(); ++i)
+	{
+		if (i < pattern.length() && pattern.at(i) != QLatin1Char('*') && pattern.at(i) != QLatin1Char('^'))
+		{
+			continue;
+		}
+
+		for (int j = segmentStart; j <= (i - m_keyLength); ++j)
+		{
+			keys.append(createKey(pattern.constData() + j));
+		}
+
+		segmentStart = (i + 1);
+	}
+
+	return keys;
+}
+
+QVector<ContentBlockingRuleSet::StyleSheetEntry> ContentBlockingRuleSet::createStyleSheetEntries(const QMultiHash<QString, QString> &list, QString &strings, QHash<QString, StringReference> &references) const
+{
+	QVector<StyleSheetEntry> entries;
+	entries.reserve(list.count());
+
+	QStringList domains(list.uniqueKeys());
+	domains.sort();
+
+	for (int i = 0; i < domains.count(); ++i)
+	{
+		const StringReference domain(addString(domains.at(i), strings, references));
+		const QStringList rules(list.values(domains.at(i)));
+
+		for (int j = 0; j < rules.count(); ++j)
+		{
+			StyleSheetEntry entry;
+			entry.domain = domain;
+			entry.rule = addString(rules.at(j), strings, references);
+
+			entries.append(entry);
+		}
+	}
+
+	return entries;
+}
+
+ContentBlockingRuleSet::StringReference ContentBlockingRuleSet::addString(const QString &string, QString &strings, QHash<QString, StringReference> &references)
+{
+	if (references.contains(string))
+	{
+		return references.value(string);
+	}
+
+	StringReference reference;
+	reference.offset = strings.length();
+	reference.length = string.length();
+
+	strings.append(string);
+
+	references[string] = reference;
+
+	return reference;
+}
+
+quint64 ContentBlockingRuleSet::createKey(const QChar *characters)
+{
+	return ((static_cast<quint64>(characters[0].unicode()) << 48) | (static_cast<quint64>(characters[1].unicode()) << 32) | (static_cast<quint64>(characters[2].unicode()) << 16) | static_cast<quint64>(characters[3].unicode()));
+}
+
+quint32 ContentBlockingRuleSet::getParserOptions() const
+{
+	return ((m_areWildcardsEnabled ? 1 : 0) | (static_cast<quint32>(m_cosmeticFiltersMode) << 1));
+}
+
+int ContentBlockingRuleSet::getRulesAmount() const
+{
+	return (m_header ? static_cast<int>(m_header->rulesAmount) : 0);
+}
+
+bool ContentBlockingRuleSet::loadSnapshot(const QString &path, const QFileInfo &source, const QByteArray &checksum)
+{
+	if (m_snapshotFile || !source.exists() || checksum.size() != static_cast<int>(sizeof(SnapshotHeader::sourceChecksum)))
+	{
+		return false;
+	}
+
+	QFile *file(new QFile(path));
+
+	if (!file->open(QIODevice::ReadOnly) || file->size() < static_cast<qint64>(sizeof(SnapshotHeader)))
+	{
+		delete file;
+
+		return false;
+	}
+
+	const uchar *data(file->map(0, file->size()));
+
+	if (!data)
+	{
+		delete file;
+
+		return false;
+	}
+
+	const SnapshotHeader *header(reinterpret_cast<const SnapshotHeader*>(data));
+
+	if (header->magic != m_snapshotMagic || header->version != m_snapshotVersion || header->sourceSize != source.size() || header->sourceModified != source.lastModified().toMSecsSinceEpoch() || std::memcmp(header->sourceChecksum, checksum.constData(), sizeof(header->sourceChecksum)) != 0 || header->parserOptions != getParserOptions() || static_cast<qint64>(header->dataSize) != (file->size() - static_cast<qint64>(sizeof(SnapshotHeader))))
+	{
+		delete file;
+
+		return false;
+	}
+
+	m_data = QByteArray::fromRawData(reinterpret_cast<const char*>(data + sizeof(SnapshotHeader)), header->dataSize);
+	m_snapshotFile = file;
+
+	if (!attachData())
+	{
+		m_data.clear();
+		m_snapshotFile = nullptr;
+
+		delete file;
+
+		return false;
+	}
+
+	return true;
+}
+
+bool ContentBlockingRuleSet::saveSnapshot(const QString &path, const QFileInfo &source, const QByteArray &checksum) const
+{
+	if (!m_header || !source.exists() || checksum.size() != static_cast<int>(sizeof(SnapshotHeader::sourceChecksum)))
+	{
+		return false;
+	}
+
+	SnapshotHeader header;
+	header.magic = m_snapshotMagic;
+	header.version = m_snapshotVersion;
+	header.sourceSize = source.size();
+	header.sourceModified = source.lastModified().toMSecsSinceEpoch();
+	std::memcpy(header.sourceChecksum, checksum.constData(), sizeof(header.sourceChecksum));
+	header.parserOptions = getParserOptions();
+	header.dataSize = m_data.size();
+
+	QSaveFile file(path);
+
+	if (!file.open(QIODevice::WriteOnly))
+	{
+		return false;
+	}
+
+	file.write(reinterpret_cast<const char*>(&header), sizeof(SnapshotHeader));
+	file.write(m_data);
+
+	return file.commit();
+}
+
+QSharedPointer<ContentBlockingRuleSet> ContentBlockingRuleSet::load(const QString &path, const QString &snapshotPath, ContentBlockingManager::CosmeticFiltersMode cosmeticFiltersMode, bool areWildcardsEnabled)
+{
+	const QFileInfo information(path);
+	QSharedPointer<ContentBlockingRuleSet> rules(new ContentBlockingRuleSet(cosmeticFiltersMode, areWildcardsEnabled));
+
+	QFile file(path);
+
+	if (!file.open(QIODevice::ReadOnly))
+	{
+		return rules;
+	}
+
+	const QByteArray data(file.readAll());
+
+	file.close();
+
+	const QByteArray checksum(QCryptographicHash::hash(data, QCryptographicHash::Md5));
+
+	if (rules->loadSnapshot(snapshotPath, information, checksum))
+	{
+		return rules;
+	}
+
+	QTextStream stream(data);
+	stream.readLine(); // header
+
+	while (!stream.atEnd())
+	{
+		rules->parseRuleLine(stream.readLine());
+	}
+
+	rules->build();
+	rules->saveSnapshot(snapshotPath, information, checksum);
+
+	return rules;
+}
+
+bool ContentBlockingRuleSet::attachData()
+{
+	m_header = nullptr;
+
+	if (m_data.size() < static_cast<int>(sizeof(DataHeader)))
+	{
+		return false;
+	}
+
+	const char *data(m_data.constData());
+	const DataHeader *header(reinterpret_cast<const DataHeader*>(data));
+	const quint64 indexOffset(sizeof(DataHeader));
+	const quint64 rulesOffset(indexOffset + (static_cast<quint64>(header->indexAmount) * sizeof(IndexEntry)));
+	const quint64 unindexedRulesOffset(rulesOffset + (static_cast<quint64>(header->rulesAmount) * sizeof(RuleRecord)));
+	const quint64 styleSheetOffset(unindexedRulesOffset + (static_cast<quint64>(header->unindexedRulesAmount) * sizeof(quint32)));
+	const quint64 styleSheetBlackListOffset(styleSheetOffset + (static_cast<quint64>(header->styleSheetAmount) * sizeof(StringReference)));
+	const quint64 styleSheetWhiteListOffset(styleSheetBlackListOffset + (static_cast<quint64>(header->styleSheetBlackListAmount) * sizeof(StyleSheetEntry)));
+	const quint64 stringsOffset(styleSheetWhiteListOffset + (static_cast<quint64>(header->styleSheetWhiteListAmount) * sizeof(StyleSheetEntry)));
+
+	if ((stringsOffset + (static_cast<quint64>(header->stringsLength) * sizeof(QChar))) != static_cast<quint64>(m_data.size()))
+	{
+		return false;
+	}
+
+	const IndexEntry *index(reinterpret_cast<const IndexEntry*>(data + indexOffset));
+	const RuleRecord *rules(reinterpret_cast<const RuleRecord*>(data + rulesOffset));
+	const quint32 *unindexedRules(reinterpret_cast<const quint32*>(data + unindexedRulesOffset));
+
+	for (quint32 i = 0; i < header->indexAmount; ++i)
+	{
+		if (index[i].rule >= header->rulesAmount)
+		{
+			return false;
+		}
+	}
+
+	for (quint32 i = 0; i < header->unindexedRulesAmount; ++i)
+	{
+		if (unindexedRules[i] >= header->rulesAmount)
+		{
+			return false;
+		}
+	}
+
+	for (quint32 i = 0; i < header->rulesAmount; ++i)
+	{
+		const StringReference references[4]({rules[i].rule, rules[i].pattern, rules[i].blockedDomains, rules[i].allowedDomains});
+
+		for (int j = 0; j < 4; ++j)
+		{
+			if ((static_cast<quint64>(references[j].offset) + references[j].length) > header->stringsLength)
+			{
+				return false;
+			}
+		}
+	}
+
+	const StringReference *styleSheet(reinterpret_cast<const StringReference*>(data + styleSheetOffset));
+
+	for (quint32 i = 0; i < header->styleSheetAmount; ++i)
+	{
+		if ((static_cast<quint64>(styleSheet[i].offset) + styleSheet[i].length) > header->stringsLength)
+		{
+			return false;
+		}
+	}
+
+	const StyleSheetEntry *styleSheetBlackList(reinterpret_cast<const StyleSheetEntry*>(data + styleSheetBlackListOffset));
+	const StyleSheetEntry *styleSheetWhiteList(reinterpret_cast<const StyleSheetEntry*>(data + styleSheetWhiteListOffset));
+	const quint32 styleSheetListsAmounts[2]({header->styleSheetBlackListAmount, header->styleSheetWhiteListAmount});
+	const StyleSheetEntry *styleSheetLists[2]({styleSheetBlackList, styleSheetWhiteList});
+
+	for (int i = 0; i < 2; ++i)
+	{
+		for (quint32 j = 0; j < styleSheetListsAmounts[i]; ++j)
+		{
+			const StyleSheetEntry &entry(styleSheetLists[i][j]);
+
+			if ((static_cast<quint64>(entry.domain.offset) + entry.domain.length) > header->stringsLength || (static_cast<quint64>(entry.rule.offset) + entry.rule.length) > header->stringsLength)
+			{
+				return false;
+			}
+		}
+	}
+
+	m_header = header;
+	m_index = index;
+	m_rules = rules;
+	m_unindexedRules = unindexedRules;
+	m_styleSheet = styleSheet;
+	m_styleSheetBlackList = styleSheetBlackList;
+	m_styleSheetWhiteList = styleSheetWhiteList;
+	m_strings = reinterpret_cast<const QChar*>(data + stringsOffset);
+
+	return true;
+}
+
+bool ContentBlockingRuleSet::matchPattern(const RuleRecord &rule, const MatchContext &context, int urlPosition, int patternPosition, int matchStart) const
+{
+	const QString &url(context.requestUrl);
+	const QChar *pattern(m_strings + rule.pattern.offset);
+	const int patternLength(static_cast<int>(rule.pattern.length));
+
+	while (patternPosition < patternLength)
+	{
+		const QChar patternCharacter(pattern[patternPosition]);
+
+		if (patternCharacter == QLatin1Char('*'))
+		{
+			while (patternPosition < patternLength && pattern[patternPosition] == QLatin1Char('*'))
+			{
+				++patternPosition;
+			}
+
+			for (int i = urlPosition; i <= url.length(); ++i)
+			{
+				if (matchPattern(rule, context, i, patternPosition, matchStart))
+				{
+					return true;
+				}
+			}
+
+			return false;
+		}
+
+		if (patternCharacter == QLatin1Char('^'))
+		{
+			if (urlPosition < url.length())
+			{
+				if (!isSeparator(url.at(urlPosition)))
+				{
+					return false;
+				}
+
+				++urlPosition;
+			}
+		}
+		else if (urlPosition >= url.length() || url.at(urlPosition) != patternCharacter)
+		{
+			return false;
+		}
+		else
+		{
+			++urlPosition;
+		}
+
+		++patternPosition;
+	}
+
+	if ((rule.ruleMatch == EndMatch || rule.ruleMatch == ExactMatch) && urlPosition != url.length())
+	{
+		return false;
+	}
+
+	if (rule.needsDomainCheck)
+	{
+		int domainLength(urlPosition - matchStart);
+
+		for (int i = matchStart; i < urlPosition; ++i)
+		{
+			const QChar character(url.at(i));
+
+			if (character == QLatin1Char(':') || character == QLatin1Char('?') || character == QLatin1Char('&') || character == QLatin1Char('/') || character == QLatin1Char('='))
+			{
+				domainLength = (i - matchStart);
+
+				break;
+			}
+		}
+
+		return context.requestSubdomainList.contains(url.mid(matchStart, domainLength));
+	}
+
+	return true;
+}
+
+bool ContentBlockingRuleSet::resolveDomainExceptions(const QString &url, const StringReference &domains) const
+{
+	const QChar *characters(m_strings + domains.offset);
+	const int length(static_cast<int>(domains.length));
+	int segmentStart(0);
+
+	for (int i = 0; i <= length; ++i)
+	{
+		if (i < length && characters[i] != QLatin1Char('|'))
+		{
+			continue;
+		}
+
+		if (i > segmentStart && url.contains(QString::fromRawData((characters + segmentStart), (i - segmentStart))))
+		{
+			return true;
+		}
+
+		segmentStart = (i + 1);
+	}
+
+	return false;
+}
+
+bool ContentBlockingRuleSet::isValidSelector(const QString &selector)
+{
+	return (!selector.isEmpty() && !selector.contains(QLatin1Char('{')) && !selector.contains(QLatin1Char('}')) && !selector.contains(QLatin1Char(';')));
+}
+
+bool ContentBlockingRuleSet::isSeparator(const QChar &character)
+{
+	return (!character.isDigit() && !character.isLetter() && character != QLatin1Char('_') && character != QLatin1Char('-') && character != QLatin1Char('.') && character != QLatin1Char('%'));
+}
+
+}
@@ -0,0 +1,208 @@
+/**************************************************************************
+* Otter Browser: Web browser controlled by the user, not vice-versa.
+* Copyright (C) 2014 - 2016 Jan Bajer aka bajasoft <jbajer@gmail.com>
+* Copyright (C) 2015 - 2016 Michal Dutkiewicz aka Emdek <michal@emdek.pl>
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program. If not, see <http://www.gnu.org/licenses/>.
+*
+**************************************************************************/
+
+#ifndef OTTER_CONTENTBLOCKINGRULESET_H
+#define OTTER_CONTENTBLOCKINGRULESET_H
+
+#include "ContentBlockingManager.h"
+
+#include <QtCore/QFile>
+#include <QtCore/QFileInfo>
+#include <QtCore/QSharedPointer>
+
+namespace Otter
+{
+
+class ContentBlockingRuleSet
+{
+public:
+	enum RuleOption : quint32
+	{
+		NoOption = 0,
+		ThirdPartyOption = 1,
+		ThirdPartyExceptionOption = 2,
+		StyleSheetOption = 4,
+		StyleSheetExceptionOption = 8,
+		ScriptOption = 16,
+		ScriptExceptionOption = 32,
+		ImageOption = 64,
+		ImageExceptionOption = 128,
+		ObjectOption = 256,
+		ObjectExceptionOption = 512,
+		ObjectSubRequestOption = 1024,
+		ObjectSubRequestExceptionOption = 2048,
+		SubDocumentOption = 4096,
+		SubDocumentExceptionOption = 8192,
+		XmlHttpRequestOption = 16384,
+		XmlHttpRequestExceptionOption = 32768,
+		WebSocketOption = 65536,
+		ElementHideOption = 131072,
+		GenericHideOption = 262144
+	};
+
+	Q_DECLARE_FLAGS(RuleOptions, RuleOption)
+
+	enum RuleMatch
+	{
+		ContainsMatch = 0,
+		StartMatch,
+		EndMatch,
+		ExactMatch
+	};
+
+	explicit ContentBlockingRuleSet(ContentBlockingManager::CosmeticFiltersMode cosmeticFiltersMode = ContentBlockingManager::AllFiltersMode, bool areWildcardsEnabled = true);
+	~ContentBlockingRuleSet();
+
+	void parseRuleLine(QString line);
+	void build();
+	ContentBlockingManager::CheckResult checkUrl(const QUrl &baseUrl, const QUrl &requestUrl, NetworkManager::ResourceType resourceType) const;
+	QStringList getStyleSheet() const;
+	QStringList getStyleSheetBlackList(const QString &domain) const;
+	QStringList getStyleSheetWhiteList(const QString &domain) const;
+	int getRulesAmount() const;
+	bool loadSnapshot(const QString &path, const QFileInfo &source, const QByteArray &checksum);
+	bool saveSnapshot(const QString &path, const QFileInfo &source, const QByteArray &checksum) const;
+	static QSharedPointer<ContentBlockingRuleSet> load(const QString &path, const QString &snapshotPath, ContentBlockingManager::CosmeticFiltersMode cosmeticFiltersMode, bool areWildcardsEnabled);
+
+protected:
+	struct ContentBlockingRule
+	{
+		QString rule;
+		QString pattern;
+		QStringList blockedDomains;
+		QStringList allowedDomains;
+		RuleOptions ruleOptions = NoOption;
+		RuleMatch ruleMatch = ContainsMatch;
+		bool isException = false;
+		bool needsDomainCheck = false;
+	};
+
+	struct StringReference
+	{
+		quint32 offset = 0;
+		quint32 length = 0;
+	};
+
+	struct SnapshotHeader
+	{
+		quint32 magic = 0;
+		quint32 version = 0;
+		qint64 sourceSize = 0;
+		qint64 sourceModified = 0;
+		char sourceChecksum[16] = {};
+		quint32 parserOptions = 0;
+		quint32 dataSize = 0;
+	};
+
+	struct DataHeader
+	{
+		quint32 rulesAmount = 0;
+		quint32 indexAmount = 0;
+		quint32 unindexedRulesAmount = 0;
+		quint32 styleSheetAmount = 0;
+		quint32 styleSheetBlackListAmount = 0;
+		quint32 styleSheetWhiteListAmount = 0;
+		quint32 stringsLength = 0;
+		quint32 reserved = 0;
+	};
+
+	struct IndexEntry
+	{
+		quint64 key = 0;
+		quint32 rule = 0;
+		quint32 reserved = 0;
+
+		bool operator<(const IndexEntry &other) const
+		{
+			return (key < other.key || (key == other.key && rule < other.rule));
+		}
+	};
+
+	struct RuleRecord
+	{
+		StringReference rule;
+		StringReference pattern;
+		StringReference blockedDomains;
+		StringReference allowedDomains;
+		quint32 ruleOptions = NoOption;
+		quint8 ruleMatch = ContainsMatch;
+		quint8 isException = 0;
+		quint8 needsDomainCheck = 0;
+		quint8 reserved = 0;
+	};
+
+	struct StyleSheetEntry
+	{
+		StringReference domain;
+		StringReference rule;
+	};
+
+	struct MatchContext
+	{
+		QString requestUrl;
+		QString baseUrlHost;
+		QStringList requestSubdomainList;
+		NetworkManager::ResourceType resourceType = NetworkManager::OtherType;
+	};
+
+	void parseNetworkRule(QString line);
+	void parseStyleSheetRule(const QStringList &line, QMultiHash<QString, QString> &list);
+	QString getString(const StringReference &reference) const;
+	ContentBlockingManager::CheckResult checkRuleMatch(const RuleRecord &rule, const MatchContext &context) const;
+	QStringList getStyleSheetEntries(const StyleSheetEntry *entries, quint32 amount, const QString &domain) const;
+	QVector<quint64> getPatternKeys(const QString &pattern) const;
+	QVector<StyleSheetEntry> createStyleSheetEntries(const QMultiHash<QString, QString> &list, QString &strings, QHash<QString, StringReference> &references) const;
+	quint32 getParserOptions() const;
+	bool attachData();
+	bool matchPattern(const RuleRecord &rule, const MatchContext &context, int urlPosition, int patternPosition, int matchStart) const;
+	bool resolveDomainExceptions(const QString &url, const StringReference &domains) const;
+	static StringReference addString(const QString &string, QString &strings, QHash<QString, StringReference> &references);
+	static quint64 createKey(const QChar *characters);
+	static bool isValidSelector(const QString &selector);
+	static bool isSeparator(const QChar &character);
+
+private:
+	QFile *m_snapshotFile;
+	QByteArray m_data;
+	QVector<ContentBlockingRule> m_parsedRules;
+	QStringList m_parsedStyleSheet;
+	QMultiHash<QString, QString> m_parsedStyleSheetBlackList;
+	QMultiHash<QString, QString> m_parsedStyleSheetWhiteList;
+	const DataHeader *m_header;
+	const IndexEntry *m_index;
+	const RuleRecord *m_rules;
+	const quint32 *m_unindexedRules;
+	const StringReference *m_styleSheet;
+	const StyleSheetEntry *m_styleSheetBlackList;
+	const StyleSheetEntry *m_styleSheetWhiteList;
+	const QChar *m_strings;
+	ContentBlockingManager::CosmeticFiltersMode m_cosmeticFiltersMode;
+	bool m_areWildcardsEnabled;
+
+	static QHash<QString, RuleOption> m_options;
+	static QHash<NetworkManager::ResourceType, RuleOption> m_resourceTypes;
+	static const int m_keyLength;
+	static const quint32 m_snapshotMagic;
+	static const quint32 m_snapshotVersion;
+};
+
+}
+
+#endif
@@ -22,6 +22,7 @@
 #include "SettingsManager.h"
 
 #include <QtCore/QDataStream>
+#include <QtCore/QDateTime>
 #include <QtCore/QFile>
 #include <QtCore/QSaveFile>
 #include <QtCore/QTimerEvent>
@@ -33,6 +34,7 @@ CookieJar::CookieJar(bool isPrivate, QObject *parent) : QNetworkCookieJar(parent
 	m_generalCookiesPolicy(AcceptAllCookies),
 	m_thirdPartyCookiesPolicy(AcceptAllCookies),
 	m_keepMode(KeepUntilExpiresMode),
+	m_journalRecords(0),
 	m_saveTimer(0),
 	m_isPrivate(isPrivate)
 {
@@ -41,42 +43,23 @@ CookieJar::CookieJar(bool isPrivate, QObject *parent) : QNetworkCookieJar(parent
 		return;
 	}
 
-	QFile file(SessionsManager::getWritableDataPath(QLatin1String("cookies.dat")));
-
-	if (!file.open(QIODevice::ReadOnly))
-	{
-		return;
-	}
-
-	QList<QNetworkCookie> allCookies;
-	QDataStream stream(&file);
-	quint32 amount;
+	readRecords(SessionsManager::getWritableDataPath(QLatin1String("cookies.dat")), false);
+	readRecords(SessionsManager::getWritableDataPath(QLatin1String("cookies.journal")), true);
+	optionChanged(SettingsManager::Network_CookiesPolicyOption, SettingsManager::getValue(SettingsManager::Network_CookiesPolicyOption));
 
-	stream >> amount;
+	connect(SettingsManager::getInstance(), SIGNAL(valueChanged(int,QVariant)), this, SLOT(optionChanged(int,QVariant)));
+}
 
-	for (quint32 i = 0; i < amount; ++i)
+CookieJar::~CookieJar()
+{
+	if (m_saveTimer != 0)
 	{
-		QByteArray value;
-
-		stream >> value;
+		killTimer(m_saveTimer);
 
-		const QList<QNetworkCookie> cookies(QNetworkCookie::parseCookies(value));
+		m_saveTimer = 0;
 
-		for (int j = 0; j < cookies.count(); ++j)
-		{
-			allCookies.append(cookies.at(j));
-		}
-
-		if (stream.atEnd())
-		{
-			break;
-		}
+		save();
 	}
-
-	optionChanged(SettingsManager::Network_CookiesPolicyOption, SettingsManager::getValue(SettingsManager::Network_CookiesPolicyOption));
-	setAllCookies(allCookies);
-
-	connect(SettingsManager::getInstance(), SIGNAL(valueChanged(int,QVariant)), this, SLOT(optionChanged(int,QVariant)));
 }
 
 void CookieJar::timerEvent(QTimerEvent *event)
@@ -124,16 +107,118 @@ void CookieJar::clearCookies(int period)
 {
 	Q_UNUSED(period)
 
-	const QList<QNetworkCookie> cookies(allCookies());
+	const QList<QNetworkCookie> cookies(getAllCookies());
+
+	m_cookies.clear();
+	m_journal.clear();
 
 	for (int i = 0; i < cookies.count(); ++i)
 	{
-		QNetworkCookieJar::deleteCookie(cookies.at(i));
-
 		emit cookieRemoved(cookies.at(i));
 	}
 
-	save();
+	writeSnapshot();
+}
+
+void CookieJar::readRecords(const QString &path, bool isJournal)
+{
+	QFile file(path);
+
+	if (!file.open(QIODevice::ReadOnly))
+	{
+		return;
+	}
+
+	QDataStream stream(&file);
+	quint32 amount(0);
+
+	if (!isJournal)
+	{
+		stream >> amount;
+	}
+
+	while (!stream.atEnd() && (isJournal || amount > 0))
+	{
+		CookieRecord record;
+
+		if (isJournal)
+		{
+			quint8 operation(InsertCookie);
+
+			stream >> operation;
+
+			record.operation = static_cast<CookieOperation>(operation);
+		}
+
+		stream >> record.data;
+
+		if (stream.status() != QDataStream::Ok)
+		{
+			break;
+		}
+
+		m_pendingCookies[getDomainKey(getRawDomain(record.data))].append(record);
+
+		if (isJournal)
+		{
+			++m_journalRecords;
+		}
+		else
+		{
+			--amount;
+		}
+	}
+
+	file.close();
+}
+
+void CookieJar::loadCookies(const QString &domain) const
+{
+	if (!m_pendingCookies.contains(domain))
+	{
+		return;
+	}
+
+	const QVector<CookieRecord> records(m_pendingCookies.take(domain));
+	QList<QNetworkCookie> &cookies(m_cookies[domain]);
+
+	for (int i = 0; i < records.count(); ++i)
+	{
+		const QList<QNetworkCookie> parsedCookies(QNetworkCookie::parseCookies(records.at(i).data));
+
+		for (int j = 0; j < parsedCookies.count(); ++j)
+		{
+			for (int k = 0; k < cookies.count(); ++k)
+			{
+				if (cookies.at(k).hasSameIdentifier(parsedCookies.at(j)))
+				{
+					cookies.removeAt(k);
+
+					break;
+				}
+			}
+
+			if (records.at(i).operation == InsertCookie)
+			{
+				cookies.append(parsedCookies.at(j));
+			}
+		}
+	}
+}
+
+void CookieJar::addRecord(CookieOperation operation, const QNetworkCookie &cookie)
+{
+	if (m_isPrivate)
+	{
+		return;
+	}
+
+	QDataStream stream(&m_journal, (QIODevice::WriteOnly | QIODevice::Append));
+	stream << quint8((operation == InsertCookie && !cookie.isSessionCookie()) ? InsertCookie : RemoveCookie) << cookie.toRawForm();
+
+	++m_journalRecords;
+
+	scheduleSave();
 }
 
 void CookieJar::scheduleSave()
@@ -146,8 +231,49 @@ void CookieJar::scheduleSave()
 
 void CookieJar::save()
 {
+	if (m_journalRecords > 1000)
+	{
+		writeSnapshot();
+	}
+	else
+	{
+		writeJournal();
+	}
+}
+
+void CookieJar::writeJournal()
+{
+	if (m_isPrivate || m_journal.isEmpty())
+	{
+		return;
+	}
+
 	if (SessionsManager::isReadOnly())
 	{
+		m_journal.clear();
+
+		return;
+	}
+
+	QFile file(SessionsManager::getWritableDataPath(QLatin1String("cookies.journal")));
+
+	if (!file.open(QIODevice::WriteOnly | QIODevice::Append))
+	{
+		return;
+	}
+
+	file.write(m_journal);
+	file.close();
+
+	m_journal.clear();
+}
+
+void CookieJar::writeSnapshot()
+{
+	if (m_isPrivate || SessionsManager::isReadOnly())
+	{
+		m_journal.clear();
+
 		return;
 	}
 
@@ -155,28 +281,55 @@ void CookieJar::save()
 
 	if (!file.open(QIODevice::WriteOnly))
 	{
+		writeJournal();
+
 		return;
 	}
 
-	const QList<QNetworkCookie> cookies(allCookies());
-	QDataStream stream(&file);
-	stream << quint32(cookies.count());
+	const QList<QNetworkCookie> cookies(getAllCookies());
+	const QDateTime currentDateTime(QDateTime::currentDateTimeUtc());
+	QList<QByteArray> records;
 
 	for (int i = 0; i < cookies.count(); ++i)
 	{
-		if (!cookies.at(i).isSessionCookie())
+		if (!cookies.at(i).isSessionCookie() && cookies.at(i).expirationDate() >= currentDateTime)
 		{
-			stream << cookies.at(i).toRawForm();
+			records.append(cookies.at(i).toRawForm());
 		}
 	}
 
-	file.commit();
+	QDataStream stream(&file);
+	stream << quint32(records.count());
+
+	for (int i = 0; i < records.count(); ++i)
+	{
+		stream << records.at(i);
+	}
+
+	if (file.commit())
+	{
+		QFile::remove(SessionsManager::getWritableDataPath(QLatin1String("cookies.journal")));
+
+		m_journal.clear();
+		m_journalRecords = 0;
+	}
+	else
+	{
+		writeJournal();
+	}
 }
 
 CookieJar* CookieJar::clone(QObject *parent)
 {
+	const QList<QNetworkCookie> cookies(getAllCookies());
 	CookieJar *cookieJar(new CookieJar(m_isPrivate, parent));
-	cookieJar->setAllCookies(allCookies());
+	cookieJar->m_cookies.clear();
+	cookieJar->m_pendingCookies.clear();
+
+	for (int i = 0; i < cookies.count(); ++i)
+	{
+		cookieJar->m_cookies[getDomainKey(cookies.at(i).domain())].append(cookies.at(i));
+	}
 
 	return cookieJar;
 }
@@ -188,20 +341,66 @@ QList<QNetworkCookie> CookieJar::cookiesForUrl(const QUrl &url) const
 		return QList<QNetworkCookie>();
 	}
 
-	return QNetworkCookieJar::cookiesForUrl(url);
+	return getCookiesForUrl(url);
 }
 
 QList<QNetworkCookie> CookieJar::getCookiesForUrl(const QUrl &url) const
 {
-	return QNetworkCookieJar::cookiesForUrl(url);
+	const QString host(url.host().toLower());
+	const QString path(url.path());
+	const QDateTime currentDateTime(QDateTime::currentDateTimeUtc());
+	const bool isEncrypted(url.scheme() == QLatin1String("https"));
+	QList<QNetworkCookie> cookies;
+	QString domain(host);
+
+	while (!domain.isEmpty())
+	{
+		loadCookies(domain);
+
+		const QList<QNetworkCookie> domainCookies(m_cookies.value(domain));
+
+		for (int i = 0; i < domainCookies.count(); ++i)
+		{
+			const QNetworkCookie cookie(domainCookies.at(i));
+
+			if (!isParentDomain(host, cookie.domain()) || !isParentPath(path, cookie.path()) || (!cookie.isSessionCookie() && cookie.expirationDate() < currentDateTime) || (cookie.isSecure() && !isEncrypted))
+			{
+				continue;
+			}
+
+			int position(0);
+
+			while (position < cookies.count() && cookies.at(position).path().length() >= cookie.path().length())
+			{
+				++position;
+			}
+
+			cookies.insert(position, cookie);
+		}
+
+		const int separator(domain.indexOf(QLatin1Char('.')));
+
+		domain = ((separator < 0) ? QString() : domain.mid(separator + 1));
+	}
+
+	return cookies;
 }
 
 QList<QNetworkCookie> CookieJar::getCookies(const QString &domain) const
 {
-	if (!domain.isEmpty())
+	if (domain.isEmpty())
 	{
-		const QList<QNetworkCookie> cookies(allCookies());
-		QList<QNetworkCookie> domainCookies;
+		return getAllCookies();
+	}
+
+	QList<QNetworkCookie> domainCookies;
+	QString key(getDomainKey(domain));
+
+	while (!key.isEmpty())
+	{
+		loadCookies(key);
+
+		const QList<QNetworkCookie> cookies(m_cookies.value(key));
 
 		for (int i = 0; i < cookies.count(); ++i)
 		{
@@ -211,75 +410,90 @@ QList<QNetworkCookie> CookieJar::getCookies(const QString &domain) const
 			}
 		}
 
-		return domainCookies;
+		const int separator(key.indexOf(QLatin1Char('.')));
+
+		key = ((separator < 0) ? QString() : key.mid(separator + 1));
 	}
 
-	return allCookies();
+	return domainCookies;
 }
 
-bool CookieJar::insertCookie(const QNetworkCookie &cookie)
+QList<QNetworkCookie> CookieJar::getAllCookies() const
 {
-	if (m_generalCookiesPolicy != AcceptAllCookies)
+	const QStringList domains(m_pendingCookies.keys());
+
+	for (int i = 0; i < domains.count(); ++i)
 	{
-		return false;
+		loadCookies(domains.at(i));
 	}
 
-	const bool result(QNetworkCookieJar::insertCookie(cookie));
+	QList<QNetworkCookie> cookies;
+	QHash<QString, QList<QNetworkCookie> >::const_iterator iterator;
 
-	if (result)
+	for (iterator = m_cookies.constBegin(); iterator != m_cookies.constEnd(); ++iterator)
 	{
-		scheduleSave();
-
-		emit cookieAdded(cookie);
+		cookies.append(iterator.value());
 	}
 
-	return result;
+	return cookies;
 }
 
-bool CookieJar::updateCookie(const QNetworkCookie &cookie)
+QString CookieJar::getDomainKey(const QString &domain)
 {
-	if (m_generalCookiesPolicy == IgnoreCookies || m_generalCookiesPolicy == ReadOnlyCookies)
+	return (domain.startsWith(QLatin1Char('.')) ? domain.mid(1) : domain).toLower();
+}
+
+QString CookieJar::getRawDomain(const QByteArray &data)
+{
+	const int position(data.lastIndexOf("; domain="));
+
+	if (position < 0)
 	{
-		return false;
+		return QString();
 	}
 
-	const bool result(QNetworkCookieJar::updateCookie(cookie));
+	const int start(position + 9);
+	const int end(data.indexOf(';', start));
 
-	if (result)
+	return QUrl::fromAce(data.mid(start, ((end < 0) ? -1 : (end - start))));
+}
+
+bool CookieJar::insertCookie(const QNetworkCookie &cookie)
+{
+	if (m_generalCookiesPolicy != AcceptAllCookies)
 	{
-		scheduleSave();
+		return false;
 	}
 
-	return result;
+	return forceInsertCookie(cookie);
 }
 
-bool CookieJar::deleteCookie(const QNetworkCookie &cookie)
+bool CookieJar::updateCookie(const QNetworkCookie &cookie)
 {
 	if (m_generalCookiesPolicy == IgnoreCookies || m_generalCookiesPolicy == ReadOnlyCookies)
 	{
 		return false;
 	}
 
-	const bool result(QNetworkCookieJar::deleteCookie(cookie));
+	return forceUpdateCookie(cookie);
+}
 
-	if (result)
+bool CookieJar::deleteCookie(const QNetworkCookie &cookie)
+{
+	if (m_generalCookiesPolicy == IgnoreCookies || m_generalCookiesPolicy == ReadOnlyCookies)
 	{
-		scheduleSave();
-
-		emit cookieRemoved(cookie);
+		return false;
 	}
 
-	return result;
+	return forceDeleteCookie(cookie);
 }
 
 bool CookieJar::forceInsertCookie(const QNetworkCookie &cookie)
 {
-	const bool result(QNetworkCookieJar::insertCookie(cookie));
+	const bool result(addCookie(cookie));
 
 	if (result)
 	{
-		scheduleSave();
-
 		emit cookieAdded(cookie);
 	}
 
@@ -288,30 +502,80 @@ bool CookieJar::forceInsertCookie(const QNetworkCookie &cookie)
 
 bool CookieJar::forceUpdateCookie(const QNetworkCookie &cookie)
 {
-	const bool result(QNetworkCookieJar::updateCookie(cookie));
-
-	if (result)
+	if (!removeCookie(cookie))
 	{
-		scheduleSave();
+		return false;
 	}
 
-	return result;
+	emit cookieRemoved(cookie);
+
+	return forceInsertCookie(cookie);
 }
 
 bool CookieJar::forceDeleteCookie(const QNetworkCookie &cookie)
 {
-	const bool result(QNetworkCookieJar::deleteCookie(cookie));
+	const bool result(removeCookie(cookie));
 
 	if (result)
 	{
-		scheduleSave();
-
 		emit cookieRemoved(cookie);
 	}
 
 	return result;
 }
 
+bool CookieJar::addCookie(const QNetworkCookie &cookie)
+{
+	if (removeCookie(cookie))
+	{
+		emit cookieRemoved(cookie);
+	}
+
+	if (!cookie.isSessionCookie() && cookie.expirationDate() < QDateTime::currentDateTimeUtc())
+	{
+		return false;
+	}
+
+	m_cookies[getDomainKey(cookie.domain())].append(cookie);
+
+	addRecord(InsertCookie, cookie);
+
+	return true;
+}
+
+bool CookieJar::removeCookie(const QNetworkCookie &cookie)
+{
+	const QString domain(getDomainKey(cookie.domain()));
+
+	loadCookies(domain);
+
+	if (!m_cookies.contains(domain))
+	{
+		return false;
+	}
+
+	QList<QNetworkCookie> &cookies(m_cookies[domain]);
+
+	for (int i = 0; i < cookies.count(); ++i)
+	{
+		if (cookies.at(i).hasSameIdentifier(cookie))
+		{
+			cookies.removeAt(i);
+
+			if (cookies.isEmpty())
+			{
+				m_cookies.remove(domain);
+			}
+
+			addRecord(RemoveCookie, cookie);
+
+			return true;
+		}
+	}
+
+	return false;
+}
+
 bool CookieJar::hasCookie(const QNetworkCookie &cookie) const
 {
 	QUrl url;
@@ -356,4 +620,24 @@ bool CookieJar::isDomainTheSame(const QUrl &first, const QUrl &second)
 	return false;
 }
 
+bool CookieJar::isParentDomain(const QString &host, const QString &domain)
+{
+	if (!domain.startsWith(QLatin1Char('.')))
+	{
+		return (host == domain);
+	}
+
+	return (host.endsWith(domain) || host == domain.mid(1));
+}
+
+bool CookieJar::isParentPath(const QString &path, const QString &reference)
+{
+	if ((path.isEmpty() && reference == QLatin1String("/")) || path.startsWith(reference))
+	{
+		return (path.length() == reference.length() || reference.endsWith(QLatin1Char('/')) || path.at(reference.length()) == QLatin1Char('/'));
+	}
+
+	return false;
+}
+
 }
@@ -54,6 +54,7 @@ public:
 	};
 
 	explicit CookieJar(bool isPrivate, QObject *parent = nullptr);
+	~CookieJar();
 
 	void clearCookies(int period = 0);
 	CookieJar* clone(QObject *parent = nullptr);
@@ -70,17 +71,39 @@ public:
 	static bool isDomainTheSame(const QUrl &first, const QUrl &second);
 
 protected:
+	struct CookieRecord
+	{
+		QByteArray data;
+		CookieOperation operation = InsertCookie;
+	};
+
 	void timerEvent(QTimerEvent *event) override;
+	void readRecords(const QString &path, bool isJournal);
+	void loadCookies(const QString &domain) const;
+	void addRecord(CookieOperation operation, const QNetworkCookie &cookie);
 	void scheduleSave();
 	void save();
+	void writeJournal();
+	void writeSnapshot();
+	QList<QNetworkCookie> getAllCookies() const;
+	bool addCookie(const QNetworkCookie &cookie);
+	bool removeCookie(const QNetworkCookie &cookie);
+	static QString getDomainKey(const QString &domain);
+	static QString getRawDomain(const QByteArray &data);
+	static bool isParentDomain(const QString &host, const QString &domain);
+	static bool isParentPath(const QString &path, const QString &reference);
 
 protected slots:
 	void optionChanged(int identifier, const QVariant &value);
 
 private:
+	mutable QHash<QString, QList<QNetworkCookie> > m_cookies;
+	mutable QHash<QString, QVector<CookieRecord> > m_pendingCookies;
+	QByteArray m_journal;
 	CookiesPolicy m_generalCookiesPolicy;
 	CookiesPolicy m_thirdPartyCookiesPolicy;
 	KeepMode m_keepMode;
+	int m_journalRecords;
 	int m_saveTimer;
 	bool m_isPrivate;
 
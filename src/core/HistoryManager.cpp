@@ -54,6 +54,9 @@ void HistoryManager::createInstance(QObject *parent)
 	if (!m_instance)
 	{
 		m_instance = new HistoryManager(parent);
+
+		getBrowsingHistoryModel();
+		getTypedHistoryModel();
 	}
 }
 
@@ -67,12 +70,12 @@ void HistoryManager::timerEvent(QTimerEvent *event)
 
 		if (m_browsingHistoryModel)
 		{
-			m_browsingHistoryModel->save(SessionsManager::getWritableDataPath(QLatin1String("browsingHistory.json")));
+			m_browsingHistoryModel->save();
 		}
 
 		if (m_typedHistoryModel)
 		{
-			m_typedHistoryModel->save(SessionsManager::getWritableDataPath(QLatin1String("typedHistory.json")));
+			m_typedHistoryModel->save();
 		}
 	}
 	else if (event->timerId() == m_dayTimer)
@@ -207,10 +210,7 @@ void HistoryManager::removeEntries(const QList<quint64> &identifiers)
 		getBrowsingHistoryModel();
 	}
 
-	for (int i = 0; i < identifiers.count(); ++i)
-	{
-		m_browsingHistoryModel->removeEntry(identifiers.at(i));
-	}
+	m_browsingHistoryModel->removeEntries(identifiers);
 
 	m_instance->scheduleSave();
 }
@@ -234,14 +234,7 @@ void HistoryManager::updateEntry(quint64 identifier, const QUrl &url, const QStr
 		getBrowsingHistoryModel();
 	}
 
-	HistoryEntryItem *item(m_browsingHistoryModel->getEntry(identifier));
-
-	if (item)
-	{
-		item->setData(url, HistoryModel::UrlRole);
-		item->setData(title, HistoryModel::TitleRole);
-		item->setIcon(icon);
-	}
+	m_browsingHistoryModel->updateEntry(identifier, url, title, icon);
 
 	m_instance->scheduleSave();
 }
@@ -298,7 +291,7 @@ QIcon HistoryManager::getIcon(const QUrl &url)
 	return ThemesManager::getIcon(QLatin1String("text-html"));
 }
 
-HistoryEntryItem* HistoryManager::getEntry(quint64 identifier)
+HistoryModel::HistoryEntry HistoryManager::getEntry(quint64 identifier)
 {
 	if (!m_browsingHistoryModel)
 	{
@@ -308,7 +301,7 @@ HistoryEntryItem* HistoryManager::getEntry(quint64 identifier)
 	return m_browsingHistoryModel->getEntry(identifier);
 }
 
-QList<HistoryModel::HistoryEntryMatch> HistoryManager::findEntries(const QString &prefix, bool isTypedInOnly)
+QList<HistoryModel::HistoryEntryMatch> HistoryManager::findEntries(const QString &prefix, bool isTypedInOnly, int limit)
 {
 	if (!m_typedHistoryModel)
 	{
@@ -321,11 +314,11 @@ QList<HistoryModel::HistoryEntryMatch> HistoryManager::findEntries(const QString
 	}
 
 	QList<HistoryModel::HistoryEntryMatch> entries;
-	entries.append(m_typedHistoryModel->findEntries(prefix, true));
+	entries.append(m_typedHistoryModel->findEntries(prefix, true, limit));
 
 	if (!isTypedInOnly)
 	{
-		entries.append(m_browsingHistoryModel->findEntries(prefix));
+		entries.append(m_browsingHistoryModel->findEntries(prefix, false, limit));
 	}
 
 	return entries;
@@ -343,7 +336,7 @@ quint64 HistoryManager::addEntry(const QUrl &url, const QString &title, const QI
 		getBrowsingHistoryModel();
 	}
 
-	const quint64 identifier(m_browsingHistoryModel->addEntry(url, title, icon, QDateTime::currentDateTime())->data(HistoryModel::IdentifierRole).toULongLong());
+	const quint64 identifier(m_browsingHistoryModel->addEntry(url, title, icon, QDateTime::currentDateTime()));
 
 	if (isTypedIn)
 	{
@@ -357,12 +350,9 @@ quint64 HistoryManager::addEntry(const QUrl &url, const QString &title, const QI
 
 	const int limit(SettingsManager::getValue(SettingsManager::History_BrowsingLimitAmountGlobalOption).toInt());
 
-	if (limit > 0 && m_browsingHistoryModel->rowCount() > limit)
+	if (limit > 0)
 	{
-		for (int i = (m_browsingHistoryModel->rowCount() - 1); i >= limit; --i)
-		{
-			m_browsingHistoryModel->removeEntry(m_browsingHistoryModel->index(i, 0).data(HistoryModel::IdentifierRole).toULongLong());
-		}
+		m_browsingHistoryModel->clearExcessEntries(limit);
 	}
 
 	m_instance->scheduleSave();
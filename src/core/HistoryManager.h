@@ -44,8 +44,8 @@ public:
 	static HistoryModel* getBrowsingHistoryModel();
 	static HistoryModel* getTypedHistoryModel();
 	static QIcon getIcon(const QUrl &url);
-	static HistoryEntryItem* getEntry(quint64 identifier);
-	static QList<HistoryModel::HistoryEntryMatch> findEntries(const QString &prefix, bool isTypedInOnly = false);
+	static HistoryModel::HistoryEntry getEntry(quint64 identifier);
+	static QList<HistoryModel::HistoryEntryMatch> findEntries(const QString &prefix, bool isTypedInOnly = false, int limit = 0);
 	static quint64 addEntry(const QUrl &url, const QString &title, const QIcon &icon, bool isTypedIn = false);
 	static bool hasEntry(const QUrl &url);
 
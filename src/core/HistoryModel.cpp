@@ -20,334 +20,1371 @@
 
 #include "HistoryModel.h"
 #include "Console.h"
-#include "JsonSettings.h"
 #include "SessionsManager.h"
 #include "Utils.h"
 
+#include <QtConcurrent/QtConcurrentRun>
+#include <QtCore/QDir>
 #include <QtCore/QFile>
+#include <QtCore/QFileInfo>
 #include <QtCore/QJsonArray>
-#include <QtCore/QJsonObject>
+#include <QtCore/QJsonDocument>
+#include <QtCore/QSaveFile>
+#include <QtCore/QSet>
+
+#include <algorithm>
+#include <iterator>
 
 namespace Otter
 {
 
-HistoryEntryItem::HistoryEntryItem() : QStandardItem()
+HistoryModel::HistoryModel(const QString &path, HistoryType type, QObject *parent) : QAbstractListModel(parent),
+	m_loadWatcher(new QFutureWatcher<LoadResult>(this)),
+	m_compactionWatcher(nullptr),
+	m_path(path),
+	m_type(type),
+	m_journalRecords(0)
 {
+	connect(m_loadWatcher, SIGNAL(finished()), this, SLOT(handleLoadFinished()));
+
+	m_loadWatcher->setFuture(QtConcurrent::run(&HistoryModel::loadEntries, path, QStringList({getJournalPath() + QLatin1String(".old"), getJournalPath()})));
 }
 
-void HistoryEntryItem::setData(const QVariant &value, int role)
+HistoryModel::~HistoryModel()
 {
-	if (model() && qobject_cast<HistoryModel*>(model()))
+	if (!m_pendingOperations.isEmpty())
 	{
-		model()->setData(index(), value, role);
+		ensureLoaded();
 	}
-	else
+
+	writeJournal();
+}
+
+void HistoryModel::clearExcessEntries(int limit)
+{
+	if (m_loadWatcher)
 	{
-		QStandardItem::setData(value, role);
+		m_pendingOperations.append([=]()
+		{
+			clearExcessEntries(limit);
+		});
+
+		return;
+	}
+
+	if (limit > 0 && m_table.identifiers.count() > limit)
+	{
+		removeEntries(0, (m_table.identifiers.count() - limit - 1));
 	}
 }
 
-void HistoryEntryItem::setItemData(const QVariant &value, int role)
+void HistoryModel::clearRecentEntries(uint period)
 {
-	QStandardItem::setData(value, role);
+	if (m_loadWatcher)
+	{
+		m_pendingOperations.append([=]()
+		{
+			clearRecentEntries(period);
+		});
+
+		return;
+	}
+
+	if (period == 0)
+	{
+		beginResetModel();
+
+		m_table.clear();
+
+		endResetModel();
+
+		addRecord(QLatin1String("clear"));
+
+		emit cleared();
+
+		return;
+	}
+
+	const qint64 time(QDateTime::currentMSecsSinceEpoch() - (static_cast<qint64>(period) * 3600000));
+	QBitArray entries(m_table.identifiers.count());
+
+	for (int i = 0; i < m_table.identifiers.count(); ++i)
+	{
+		entries.setBit(i, (m_table.timesVisited.at(i) > time));
+	}
+
+	removeEntries(entries);
 }
 
-HistoryModel::HistoryModel(const QString &path, HistoryType type, QObject *parent) : QStandardItemModel(parent),
-	m_type(type)
+void HistoryModel::clearOldestEntries(int period)
 {
-	QFile file(path);
+	if (period < 0)
+	{
+		return;
+	}
 
-	if (!file.open(QIODevice::ReadOnly | QIODevice::Text))
+	if (m_loadWatcher)
 	{
-		Console::addMessage(tr("Failed to open history file: %1").arg(file.errorString()), Console::OtherCategory, Console::ErrorLevel, path);
+		m_pendingOperations.append([=]()
+		{
+			clearOldestEntries(period);
+		});
 
 		return;
 	}
 
-	const QJsonArray historyArray(QJsonDocument::fromJson(file.readAll()).array());
+	const qint64 time(QDateTime(QDate::currentDate().addDays(-period), QTime(0, 0)).toMSecsSinceEpoch());
+	QBitArray entries(m_table.identifiers.count());
 
-	file.close();
+	for (int i = 0; i < m_table.identifiers.count(); ++i)
+	{
+		entries.setBit(i, (m_table.timesVisited.at(i) < time));
+	}
+
+	removeEntries(entries);
+}
 
-	for (int i = 0; i < historyArray.count(); ++i)
+void HistoryModel::removeEntry(quint64 identifier)
+{
+	if (m_loadWatcher)
 	{
-		const QJsonObject entryObject(historyArray.at(i).toObject());
+		m_pendingOperations.append([=]()
+		{
+			removeEntry(identifier);
+		});
+
+		return;
+	}
 
-		addEntry(QUrl(entryObject.value(QLatin1String("url")).toString()), entryObject.value(QLatin1String("title")).toString(), QIcon(), QDateTime::fromString(entryObject.value(QLatin1String("time")).toString(), QLatin1String("yyyy-MM-dd hh:mm:ss")));
+	const int position(m_table.getPosition(m_pendingIdentifiers.value(identifier, identifier)));
+
+	if (position < 0)
+	{
+		return;
 	}
 
-	setSortRole(TimeVisitedRole);
-	sort(0, Qt::DescendingOrder);
+	const HistoryEntry entry(m_table.getEntry(position));
+	const int row(m_table.identifiers.count() - position - 1);
+
+	emit entryRemoved(entry.identifier);
+
+	beginRemoveRows(QModelIndex(), row, row);
+
+	m_table.removeEntries(position, position);
+
+	endRemoveRows();
+
+	addRecord(QLatin1String("remove"), entry);
+
+	emit modelModified();
 }
 
-void HistoryModel::clearExcessEntries(int limit)
+void HistoryModel::removeEntries(const QList<quint64> &identifiers)
 {
-	if (limit > 0 && rowCount() > limit)
+	if (m_loadWatcher)
+	{
+		m_pendingOperations.append([=]()
+		{
+			removeEntries(identifiers);
+		});
+
+		return;
+	}
+
+	QBitArray entries(m_table.identifiers.count());
+
+	for (int i = 0; i < identifiers.count(); ++i)
 	{
-		for (int i = (rowCount() - 1); i >= limit; --i)
+		const int position(m_table.getPosition(m_pendingIdentifiers.value(identifiers.at(i), identifiers.at(i))));
+
+		if (position >= 0)
 		{
-			removeEntry(index(i, 0).data(HistoryModel::IdentifierRole).toULongLong());
+			entries.setBit(position);
 		}
 	}
+
+	removeEntries(entries);
 }
 
-void HistoryModel::clearRecentEntries(uint period)
+void HistoryModel::updateEntry(quint64 identifier, const QUrl &url, const QString &title, const QIcon &icon)
 {
-	if (period == 0)
+	if (m_loadWatcher)
 	{
-		clear();
+		m_pendingOperations.append([=]()
+		{
+			updateEntry(identifier, url, title, icon);
+		});
 
-		emit cleared();
+		return;
+	}
 
+	const int position(m_table.getPosition(m_pendingIdentifiers.value(identifier, identifier)));
+
+	if (position < 0)
+	{
 		return;
 	}
 
-	for (int i = (rowCount() - 1); i >= 0; --i)
+	m_table.updateEntry(position, url, title, icon);
+
+	const QModelIndex entryIndex(index(m_table.identifiers.count() - position - 1));
+
+	emit dataChanged(entryIndex, entryIndex);
+
+	addRecord(QLatin1String("update"), m_table.getEntry(position));
+
+	emit entryModified(m_table.identifiers.at(position));
+	emit modelModified();
+}
+
+void HistoryModel::addRecord(const QString &action, const HistoryEntry &entry)
+{
+	QJsonObject record;
+	record.insert(QLatin1String("action"), action);
+
+	if (entry.identifier > 0)
 	{
-		if (index(i, 0).data(TimeVisitedRole).toDateTime().secsTo(QDateTime::currentDateTime()) < (period * 3600))
+		record.insert(QLatin1String("identifier"), QJsonValue::fromVariant(entry.identifier));
+
+		if (action != QLatin1String("remove"))
 		{
-			removeEntry(index(i, 0).data(IdentifierRole).toULongLong());
+			record.insert(QLatin1String("url"), entry.url.toString());
+			record.insert(QLatin1String("title"), entry.title);
+			record.insert(QLatin1String("time"), entry.timeVisited.toString(QLatin1String("yyyy-MM-dd hh:mm:ss")));
 		}
 	}
+
+	addRecord(record);
 }
 
-void HistoryModel::clearOldestEntries(int period)
+void HistoryModel::addRecord(const QJsonObject &record)
 {
-	if (period < 0)
+	m_journal.append(QJsonDocument(record).toJson(QJsonDocument::Compact));
+	m_journal.append('\n');
+
+	++m_journalRecords;
+}
+
+void HistoryModel::removeEntries(int first, int last)
+{
+	if (first < 0 || last >= m_table.identifiers.count() || first > last)
 	{
 		return;
 	}
 
-	const QDateTime currentDateTime(QDateTime::currentDateTime());
+	const int amount(m_table.identifiers.count());
+
+	QJsonObject record;
+	record.insert(QLatin1String("action"), QLatin1String("removeRange"));
+	record.insert(QLatin1String("first"), QJsonValue::fromVariant(m_table.identifiers.at(first)));
+	record.insert(QLatin1String("last"), QJsonValue::fromVariant(m_table.identifiers.at(last)));
+
+	beginRemoveRows(QModelIndex(), (amount - last - 1), (amount - first - 1));
+
+	m_table.removeEntries(first, last);
+
+	endRemoveRows();
+
+	addRecord(record);
 
-	for (int i = (rowCount() - 1); i >= 0; --i)
+	emit modelModified();
+}
+
+void HistoryModel::removeEntries(const QBitArray &entries)
+{
+	int last(-1);
+
+	// entries are removed in continuous ranges, starting from the end to keep positions of remaining ones valid
+	for (int i = (entries.count() - 1); i >= -1; --i)
 	{
-		if (index(i, 0).data(TimeVisitedRole).toDateTime().daysTo(currentDateTime) > period)
+		const bool isMarked(i >= 0 && entries.testBit(i));
+
+		if (isMarked && last < 0)
+		{
+			last = i;
+		}
+		else if (!isMarked && last >= 0)
 		{
-			removeEntry(index(i, 0).data(IdentifierRole).toULongLong());
+			removeEntries((i + 1), last);
+
+			last = -1;
 		}
 	}
 }
 
-void HistoryModel::removeEntry(quint64 identifier)
+void HistoryModel::applyRecord(const QJsonObject &record, QMap<quint64, HistoryEntry> &entries)
 {
-	HistoryEntryItem *entry(getEntry(identifier));
+	const QString action(record.value(QLatin1String("action")).toString());
+	quint64 identifier(record.value(QLatin1String("identifier")).toVariant().toULongLong());
+
+	if (action == QLatin1String("clear"))
+	{
+		entries.clear();
+	}
+	else if (action == QLatin1String("remove"))
+	{
+		entries.remove(identifier);
+	}
+	else if (action == QLatin1String("removeRange"))
+	{
+		const quint64 last(record.value(QLatin1String("last")).toVariant().toULongLong());
+		QMap<quint64, HistoryEntry>::iterator iterator(entries.lowerBound(record.value(QLatin1String("first")).toVariant().toULongLong()));
+
+		while (iterator != entries.end() && iterator.key() <= last)
+		{
+			iterator = entries.erase(iterator);
+		}
+	}
+	else
+	{
+		// snapshots written by older versions have no identifiers, assign them in file order
+		if (identifier == 0 || (action.isEmpty() && entries.contains(identifier)))
+		{
+			identifier = (entries.isEmpty() ? 1 : (entries.lastKey() + 1));
+		}
 
-	if (!entry)
+		HistoryEntry entry;
+		entry.url = QUrl(record.value(QLatin1String("url")).toString());
+		entry.title = record.value(QLatin1String("title")).toString();
+		entry.timeVisited = QDateTime::fromString(record.value(QLatin1String("time")).toString(), QLatin1String("yyyy-MM-dd hh:mm:ss"));
+		entry.identifier = identifier;
+
+		entries[identifier] = entry;
+	}
+}
+
+void HistoryModel::compact()
+{
+	if (SessionsManager::isReadOnly())
 	{
 		return;
 	}
 
-	const QUrl url(Utils::normalizeUrl(entry->data(UrlRole).toUrl()));
+	const QString journalPath(getJournalPath());
+	QFile previousJournalFile(journalPath + QLatin1String(".old"));
 
-	if (m_urls.contains(url))
+	// records written before the snapshot are kept until it was saved, replaying them again is harmless
+	if (previousJournalFile.exists())
 	{
-		m_urls[url].removeAll(entry);
+		QFile journalFile(journalPath);
 
-		if (m_urls[url].isEmpty())
+		if (journalFile.open(QIODevice::ReadOnly) && previousJournalFile.open(QIODevice::WriteOnly | QIODevice::Append))
+		{
+			previousJournalFile.write(journalFile.readAll());
+			previousJournalFile.close();
+			journalFile.close();
+			journalFile.remove();
+		}
+		else
 		{
-			m_urls.remove(url);
+			return;
 		}
 	}
+	else if (QFile::exists(journalPath) && !QFile::rename(journalPath, previousJournalFile.fileName()))
+	{
+		return;
+	}
+
+	QVector<EntryRecord> records;
+	records.reserve(m_table.identifiers.count());
 
-	if (identifier > 0 && m_identifiers.contains(identifier))
+	for (int i = 0; i < m_table.identifiers.count(); ++i)
 	{
-		m_identifiers.remove(identifier);
+		EntryRecord record;
+		record.url = m_table.getString(m_table.urls.at(i));
+		record.title = m_table.getString(m_table.titles.at(i));
+		record.timeVisited = QDateTime::fromMSecsSinceEpoch(m_table.timesVisited.at(i)).toString(QLatin1String("yyyy-MM-dd hh:mm:ss"));
+		record.identifier = m_table.identifiers.at(i);
+
+		records.append(record);
 	}
 
-	emit entryRemoved(entry);
+	m_journalRecords = 0;
 
-	removeRow(entry->row());
+	m_compactionWatcher = new QFutureWatcher<bool>(this);
 
-	emit modelModified();
+	connect(m_compactionWatcher, SIGNAL(finished()), this, SLOT(handleCompactionFinished()));
+
+	m_compactionWatcher->setFuture(QtConcurrent::run(&HistoryModel::writeSnapshot, m_path, records));
 }
 
-HistoryEntryItem* HistoryModel::addEntry(const QUrl &url, const QString &title, const QIcon &icon, const QDateTime &date, quint64 identifier)
+void HistoryModel::ensureLoaded()
 {
-	blockSignals(true);
+	if (m_loadWatcher)
+	{
+		m_loadWatcher->waitForFinished();
 
-	if (m_type == TypedHistory)
+		handleLoadFinished();
+	}
+}
+
+void HistoryModel::handleLoadFinished()
+{
+	if (!m_loadWatcher)
 	{
-		const QUrl normalizedUrl(Utils::normalizeUrl(url));
-		
-		if (hasEntry(normalizedUrl))
-		{
-			for (int i = 0; i < m_urls[normalizedUrl].count(); ++i)
-			{
-				removeEntry(m_urls[normalizedUrl][i]->data(IdentifierRole).toULongLong());
-			}
-		}
+		return;
 	}
 
-	HistoryEntryItem *entry(new HistoryEntryItem());
-	entry->setIcon(icon);
+	const LoadResult result(m_loadWatcher->result());
 
-	insertRow(0, entry);
-	setData(entry->index(), url, UrlRole);
-	setData(entry->index(), title, TitleRole);
-	setData(entry->index(), date, TimeVisitedRole);
+	m_loadWatcher->deleteLater();
+	m_loadWatcher = nullptr;
 
-	if (identifier == 0 || m_identifiers.contains(identifier))
+	if (!result.errorString.isEmpty())
 	{
-		identifier = (m_identifiers.isEmpty() ? 1 : (m_identifiers.keys().last() + 1));
+		Console::addMessage(result.errorString, Console::OtherCategory, Console::ErrorLevel, m_path);
 	}
 
-	setData(entry->index(), identifier, IdentifierRole);
+	beginResetModel();
 
-	m_identifiers[identifier] = entry;
+	m_table = result.table;
+	m_journalRecords += result.journalRecords;
 
-	blockSignals(false);
+	endResetModel();
 
-	emit entryAdded(entry);
+	const QList<std::function<void()> > operations(m_pendingOperations);
 
-	return entry;
+	m_pendingOperations.clear();
+
+	for (int i = 0; i < operations.count(); ++i)
+	{
+		operations.at(i)();
+	}
 }
 
-HistoryEntryItem* HistoryModel::getEntry(quint64 identifier) const
+void HistoryModel::handleCompactionFinished()
 {
-	if (m_identifiers.contains(identifier))
+	if (!m_compactionWatcher)
 	{
-		return m_identifiers[identifier];
+		return;
 	}
 
-	return nullptr;
-}
+	const bool isSuccess(m_compactionWatcher->result());
 
-QList<HistoryModel::HistoryEntryMatch> HistoryModel::findEntries(const QString &prefix, bool markAsTypedIn) const
-{
-	QList<HistoryEntryItem*> matchedEntries;
-	QList<HistoryModel::HistoryEntryMatch> allMatches;
-	QList<HistoryModel::HistoryEntryMatch> currentMatches;
-	QMultiMap<QDateTime, HistoryModel::HistoryEntryMatch> matchesMap;
-	QHash<QUrl, QList<HistoryEntryItem*> >::const_iterator urlsIterator;
+	m_compactionWatcher->deleteLater();
+	m_compactionWatcher = nullptr;
 
-	for (urlsIterator = m_urls.constBegin(); urlsIterator != m_urls.constEnd(); ++urlsIterator)
+	if (isSuccess)
 	{
-		if (urlsIterator.value().isEmpty() || matchedEntries.contains(urlsIterator.value().first()))
-		{
-			continue;
-		}
+		QFile::remove(getJournalPath() + QLatin1String(".old"));
+	}
+	else
+	{
+		Console::addMessage(tr("Failed to save history file"), Console::OtherCategory, Console::ErrorLevel, m_path);
+	}
+}
 
-		const QString result(Utils::matchUrl(urlsIterator.key(), prefix));
+void HistoryModel::HistoryTable::clear()
+{
+	strings.clear();
+	references.clear();
+	searchReferences.clear();
+	freeStrings.clear();
+	stringIndexes.clear();
+	identifiers.clear();
+	timesVisited.clear();
+	urls.clear();
+	normalizedUrls.clear();
+	titles.clear();
+	hosts.clear();
+	urlEntries.clear();
+	prefixes.clear();
+	trigrams.clear();
+	icons.clear();
+
+	trigramsAmount = 0;
+	staleTrigramsAmount = 0;
+}
 
-		if (!result.isEmpty())
-		{
-			HistoryEntryMatch match;
-			match.entry = urlsIterator.value().first();
-			match.match = result;
+void HistoryModel::HistoryTable::insertEntry(int position, const HistoryEntry &entry)
+{
+	const quint32 urlIndex(addSearchString(entry.url.toString()));
+	const quint32 normalizedUrlIndex(addString(Utils::normalizeUrl(entry.url).toString()));
 
-			if (markAsTypedIn)
-			{
-				match.isTypedIn = true;
-			}
+	identifiers.insert(position, entry.identifier);
+	timesVisited.insert(position, (entry.timeVisited.isValid() ? entry.timeVisited.toMSecsSinceEpoch() : 0));
+	urls.insert(position, urlIndex);
+	normalizedUrls.insert(position, normalizedUrlIndex);
+	titles.insert(position, addSearchString(entry.title));
+	hosts.insert(position, addString(entry.url.host()));
+
+	if (!entry.icon.isNull())
+	{
+		icons[urlIndex] = entry.icon;
+	}
 
-			matchesMap.insert(match.entry->data(TimeVisitedRole).toDateTime(), match);
+	addUrl(normalizedUrlIndex, entry.identifier);
+}
 
-			matchedEntries.append(match.entry);
-		}
+void HistoryModel::HistoryTable::removeEntries(int first, int last)
+{
+	for (int i = first; i <= last; ++i)
+	{
+		removeUrl(normalizedUrls.at(i), identifiers.at(i));
+		removeSearchString(urls.at(i));
+		removeString(normalizedUrls.at(i));
+		removeSearchString(titles.at(i));
+		removeString(hosts.at(i));
 	}
 
-	currentMatches = matchesMap.values();
+	const int amount(last - first + 1);
 
-	matchesMap.clear();
+	identifiers.remove(first, amount);
+	timesVisited.remove(first, amount);
+	urls.remove(first, amount);
+	normalizedUrls.remove(first, amount);
+	titles.remove(first, amount);
+	hosts.remove(first, amount);
+}
 
-	for (int i = (currentMatches.count() - 1); i >= 0; --i)
+void HistoryModel::HistoryTable::updateEntry(int position, const QUrl &url, const QString &title, const QIcon &icon)
+{
+	const quint64 identifier(identifiers.at(position));
+	const quint32 urlIndex(addSearchString(url.toString()));
+	const quint32 normalizedUrlIndex(addString(Utils::normalizeUrl(url).toString()));
+	const quint32 titleIndex(addSearchString(title));
+	const quint32 hostIndex(addString(url.host()));
+
+	removeUrl(normalizedUrls.at(position), identifier);
+	removeSearchString(urls.at(position));
+	removeString(normalizedUrls.at(position));
+	removeSearchString(titles.at(position));
+	removeString(hosts.at(position));
+
+	urls[position] = urlIndex;
+	normalizedUrls[position] = normalizedUrlIndex;
+	titles[position] = titleIndex;
+	hosts[position] = hostIndex;
+
+	if (icon.isNull())
 	{
-		allMatches.append(currentMatches.at(i));
+		icons.remove(urlIndex);
+	}
+	else
+	{
+		icons[urlIndex] = icon;
 	}
 
-	return allMatches;
+	addUrl(normalizedUrlIndex, identifier);
 }
 
-HistoryModel::HistoryType HistoryModel::getType() const
+void HistoryModel::HistoryTable::addUrl(quint32 index, quint64 identifier)
 {
-	return m_type;
+	const QString url(getString(index));
+
+	if (url.isEmpty())
+	{
+		return;
+	}
+
+	if (!urlEntries.contains(index))
+	{
+		const QStringList urlPrefixes(getUrlPrefixes(QUrl(url)));
+
+		for (int i = 0; i < urlPrefixes.count(); ++i)
+		{
+			prefixes.insert(urlPrefixes.at(i), index);
+		}
+	}
+
+	urlEntries[index].append(identifier);
 }
 
-bool HistoryModel::save(const QString &path) const
+void HistoryModel::HistoryTable::removeUrl(quint32 index, quint64 identifier)
 {
-	if (SessionsManager::isReadOnly())
+	if (!urlEntries.contains(index))
 	{
-		return false;
+		return;
 	}
 
-	QJsonArray historyArray;
+	QVector<quint64> &entries(urlEntries[index]);
+	entries.removeAll(identifier);
 
-	for (int i = 0; i < rowCount(); ++i)
+	if (entries.isEmpty())
 	{
-		QStandardItem *entry(item(i));
+		const QStringList urlPrefixes(getUrlPrefixes(QUrl(getString(index))));
 
-		if (entry)
+		for (int i = 0; i < urlPrefixes.count(); ++i)
 		{
-			QJsonObject entryObject;
-			entryObject.insert(QLatin1String("url"), entry->data(UrlRole).toUrl().toString());
-			entryObject.insert(QLatin1String("title"), entry->data(TitleRole).toString());
-			entryObject.insert(QLatin1String("time"), entry->data(TimeVisitedRole).toDateTime().toString(QLatin1String("yyyy-MM-dd hh:mm:ss")));
-
-			historyArray.prepend(entryObject);
+			prefixes.remove(urlPrefixes.at(i), index);
 		}
+
+		urlEntries.remove(index);
+	}
+}
+
+void HistoryModel::HistoryTable::removeString(quint32 index)
+{
+	if (index >= static_cast<quint32>(references.count()) || references.at(index) == 0)
+	{
+		return;
 	}
 
-	JsonSettings settings;
-	settings.setArray(historyArray);
+	--references[index];
 
-	return settings.save(path);
+	if (references.at(index) == 0)
+	{
+		stringIndexes.remove(strings.at(index));
+		strings[index] = QString();
+		icons.remove(index);
+		freeStrings.append(index);
+	}
 }
 
-bool HistoryModel::setData(const QModelIndex &index, const QVariant &value, int role)
+void HistoryModel::HistoryTable::removeSearchString(quint32 index)
 {
-	HistoryEntryItem *entry(dynamic_cast<HistoryEntryItem*>(itemFromIndex(index)));
+	if (index < static_cast<quint32>(searchReferences.count()) && searchReferences.at(index) > 0)
+	{
+		--searchReferences[index];
+
+		// postings of released strings are left in place and skipped while searching, until there are enough of them to rebuild the index
+		if (searchReferences.at(index) == 0)
+		{
+			staleTrigramsAmount += getTrigrams(getString(index)).count();
+		}
+	}
 
-	if (!entry)
+	removeString(index);
+
+	if (staleTrigramsAmount > 1024 && staleTrigramsAmount > (trigramsAmount / 2))
 	{
-		return QStandardItemModel::setData(index, value, role);
+		rebuildTrigrams();
 	}
+}
 
-	if (role == UrlRole && value.toUrl() != index.data(UrlRole).toUrl())
+void HistoryModel::HistoryTable::addTrigrams(quint32 index)
+{
+	const QVector<quint64> stringTrigrams(getTrigrams(getString(index)));
+
+	for (int i = 0; i < stringTrigrams.count(); ++i)
 	{
-		const QUrl oldUrl(Utils::normalizeUrl(index.data(UrlRole).toUrl()));
-		const QUrl newUrl(Utils::normalizeUrl(value.toUrl()));
+		QVector<quint32> &postings(trigrams[stringTrigrams.at(i)]);
+		const QVector<quint32>::iterator iterator(std::lower_bound(postings.begin(), postings.end(), index));
 
-		if (!oldUrl.isEmpty() && m_urls.contains(oldUrl))
+		if (iterator == postings.end() || *iterator != index)
 		{
-			m_urls[oldUrl].removeAll(entry);
+			postings.insert(iterator, index);
 
-			if (m_urls[oldUrl].isEmpty())
-			{
-				m_urls.remove(oldUrl);
-			}
+			++trigramsAmount;
 		}
+	}
+}
 
-		if (!newUrl.isEmpty())
-		{
-			if (!m_urls.contains(newUrl))
-			{
-				m_urls[newUrl] = QList<HistoryEntryItem*>();
-			}
+void HistoryModel::HistoryTable::rebuildTrigrams()
+{
+	trigrams.clear();
 
-			m_urls[newUrl].append(entry);
+	trigramsAmount = 0;
+	staleTrigramsAmount = 0;
+
+	for (int i = 0; i < searchReferences.count(); ++i)
+	{
+		if (searchReferences.at(i) > 0)
+		{
+			addTrigrams(static_cast<quint32>(i));
 		}
 	}
 
-	entry->setItemData(value, role);
+	QHash<quint64, QVector<quint32> >::iterator iterator;
 
-	switch (role)
+	for (iterator = trigrams.begin(); iterator != trigrams.end(); ++iterator)
 	{
-		case TitleRole:
-		case UrlRole:
-		case IdentifierRole:
-		case TimeVisitedRole:
-			emit entryModified(entry);
-			emit modelModified();
+		iterator.value().squeeze();
+	}
+}
 
-			break;
+HistoryModel::HistoryEntry HistoryModel::HistoryTable::getEntry(int position) const
+{
+	HistoryEntry entry;
+
+	if (position < 0 || position >= identifiers.count())
+	{
+		return entry;
 	}
 
-	return true;
+	entry.url = QUrl(getString(urls.at(position)));
+	entry.title = getString(titles.at(position));
+	entry.icon = icons.value(urls.at(position));
+	entry.timeVisited = ((timesVisited.at(position) > 0) ? QDateTime::fromMSecsSinceEpoch(timesVisited.at(position)) : QDateTime());
+	entry.identifier = identifiers.at(position);
+
+	return entry;
 }
 
-bool HistoryModel::hasEntry(const QUrl &url) const
+QString HistoryModel::HistoryTable::getString(quint32 index) const
+{
+	return strings.value(static_cast<int>(index));
+}
+
+int HistoryModel::HistoryTable::getPosition(quint64 identifier) const
+{
+	const QVector<quint64>::const_iterator iterator(std::lower_bound(identifiers.constBegin(), identifiers.constEnd(), identifier));
+
+	return ((iterator != identifiers.constEnd() && *iterator == identifier) ? static_cast<int>(iterator - identifiers.constBegin()) : -1);
+}
+
+int HistoryModel::HistoryTable::getStringIndex(const QString &string) const
+{
+	const QHash<QString, quint32>::const_iterator iterator(stringIndexes.constFind(string));
+
+	return ((iterator == stringIndexes.constEnd()) ? -1 : static_cast<int>(iterator.value()));
+}
+
+quint32 HistoryModel::HistoryTable::addString(const QString &string)
+{
+	const int existingIndex(getStringIndex(string));
+
+	if (existingIndex >= 0)
+	{
+		++references[existingIndex];
+
+		return static_cast<quint32>(existingIndex);
+	}
+
+	quint32 index(0);
+
+	if (freeStrings.isEmpty())
+	{
+		index = static_cast<quint32>(strings.count());
+
+		strings.append(string);
+		references.append(1);
+	}
+	else
+	{
+		index = freeStrings.takeLast();
+
+		strings[index] = string;
+		references[index] = 1;
+	}
+
+	stringIndexes.insert(string, index);
+
+	return index;
+}
+
+quint32 HistoryModel::HistoryTable::addSearchString(const QString &string)
+{
+	const quint32 index(addString(string));
+
+	if (index >= static_cast<quint32>(searchReferences.count()))
+	{
+		searchReferences.resize(static_cast<int>(index) + 1);
+	}
+
+	++searchReferences[index];
+
+	if (searchReferences.at(index) == 1)
+	{
+		addTrigrams(index);
+	}
+
+	return index;
+}
+
+HistoryModel::HistoryEntry HistoryModel::getEntry(quint64 identifier) const
+{
+	return m_table.getEntry(m_table.getPosition(m_pendingIdentifiers.value(identifier, identifier)));
+}
+
+QList<quint64> HistoryModel::getHostEntries(const QString &host) const
+{
+	QList<quint64> entries;
+	const int index(m_table.getStringIndex(host));
+
+	if (index < 0)
+	{
+		return entries;
+	}
+
+	for (int i = 0; i < m_table.hosts.count(); ++i)
+	{
+		if (m_table.hosts.at(i) == static_cast<quint32>(index))
+		{
+			entries.append(m_table.identifiers.at(i));
+		}
+	}
+
+	return entries;
+}
+
+QList<HistoryModel::HistoryEntryMatch> HistoryModel::findEntries(const QString &prefix, bool markAsTypedIn, int limit) const
+{
+	QList<HistoryModel::HistoryEntryMatch> matches;
+	QList<quint32> urls;
+	bool isDense(false);
+
+	if (prefix.isEmpty())
+	{
+		isDense = (limit > 0 && m_table.urlEntries.count() > (limit * 10));
+
+		if (!isDense)
+		{
+			urls = m_table.urlEntries.keys();
+		}
+	}
+	else
+	{
+		const QString normalizedPrefix(prefix.toLower());
+		QSet<quint32> matchedUrls;
+		QMultiMap<QString, quint32>::const_iterator iterator(m_table.prefixes.lowerBound(normalizedPrefix));
+
+		while (iterator != m_table.prefixes.constEnd() && iterator.key().startsWith(normalizedPrefix))
+		{
+			matchedUrls.insert(iterator.value());
+
+			if (limit > 0 && matchedUrls.count() > (limit * 10))
+			{
+				isDense = true;
+
+				break;
+			}
+
+			++iterator;
+		}
+
+		urls = matchedUrls.toList();
+	}
+
+	if (isDense)
+	{
+		QSet<quint32> checkedUrls;
+
+		// entries are kept in the order of visits, so the first matches from the end are the most recent ones
+		for (int i = (m_table.identifiers.count() - 1); i >= 0 && matches.count() < limit; --i)
+		{
+			const quint32 urlIndex(m_table.normalizedUrls.at(i));
+
+			if (checkedUrls.contains(urlIndex))
+			{
+				continue;
+			}
+
+			checkedUrls.insert(urlIndex);
+
+			const QString url(m_table.getString(urlIndex));
+			const QString result(prefix.isEmpty() ? url : Utils::matchUrl(QUrl(url), prefix));
+
+			if (!result.isEmpty())
+			{
+				HistoryEntryMatch match;
+				match.entry = m_table.getEntry(i);
+				match.match = result;
+				match.isTypedIn = markAsTypedIn;
+
+				matches.append(match);
+			}
+		}
+
+		return matches;
+	}
+
+	QVector<int> visits;
+	visits.reserve(urls.count());
+
+	for (int i = 0; i < urls.count(); ++i)
+	{
+		const QVector<quint64> identifiers(m_table.urlEntries.value(urls.at(i)));
+		const QString url(m_table.getString(urls.at(i)));
+		HistoryEntryMatch match;
+		match.match = (prefix.isEmpty() ? url : Utils::matchUrl(QUrl(url), prefix));
+		match.isTypedIn = markAsTypedIn;
+
+		if (identifiers.isEmpty() || match.match.isEmpty())
+		{
+			continue;
+		}
+
+		int latestPosition(-1);
+
+		for (int j = 0; j < identifiers.count(); ++j)
+		{
+			const int position(m_table.getPosition(identifiers.at(j)));
+
+			if (position >= 0 && (latestPosition < 0 || m_table.timesVisited.at(position) > m_table.timesVisited.at(latestPosition)))
+			{
+				latestPosition = position;
+			}
+		}
+
+		if (latestPosition < 0)
+		{
+			continue;
+		}
+
+		match.entry = m_table.getEntry(latestPosition);
+
+		matches.append(match);
+		visits.append(identifiers.count());
+	}
+
+	QVector<int> order(matches.count());
+
+	for (int i = 0; i < order.count(); ++i)
+	{
+		order[i] = i;
+	}
+
+	std::sort(order.begin(), order.end(), [&](int first, int second)
+	{
+		const QDateTime &firstTimeVisited(matches.at(first).entry.timeVisited);
+		const QDateTime &secondTimeVisited(matches.at(second).entry.timeVisited);
+
+		return (firstTimeVisited > secondTimeVisited || (firstTimeVisited == secondTimeVisited && visits.at(first) > visits.at(second)));
+	});
+
+	QList<HistoryModel::HistoryEntryMatch> rankedMatches;
+	rankedMatches.reserve((limit > 0) ? qMin(limit, order.count()) : order.count());
+
+	for (int i = 0; i < order.count() && (limit <= 0 || i < limit); ++i)
+	{
+		rankedMatches.append(matches.at(order.at(i)));
+	}
+
+	return rankedMatches;
+}
+
+QList<quint64> HistoryModel::searchEntries(const QString &query) const
+{
+	QList<quint64> entries;
+	const QString normalizedQuery(query.toLower());
+
+	if (normalizedQuery.isEmpty())
+	{
+		return entries;
+	}
+
+	QBitArray matchedStrings(m_table.strings.count());
+	bool hasMatches(false);
+
+	if (normalizedQuery.length() < 3)
+	{
+		for (int i = 0; i < m_table.searchReferences.count(); ++i)
+		{
+			if (m_table.searchReferences.at(i) > 0 && m_table.strings.at(i).contains(normalizedQuery, Qt::CaseInsensitive))
+			{
+				matchedStrings.setBit(i);
+
+				hasMatches = true;
+			}
+		}
+	}
+	else
+	{
+		const QVector<quint64> queryTrigrams(getTrigrams(normalizedQuery));
+		QVector<const QVector<quint32>*> postings;
+		postings.reserve(queryTrigrams.count());
+
+		for (int i = 0; i < queryTrigrams.count(); ++i)
+		{
+			const QHash<quint64, QVector<quint32> >::const_iterator iterator(m_table.trigrams.constFind(queryTrigrams.at(i)));
+
+			if (iterator == m_table.trigrams.constEnd())
+			{
+				return entries;
+			}
+
+			postings.append(&iterator.value());
+		}
+
+		std::sort(postings.begin(), postings.end(), [&](const QVector<quint32> *first, const QVector<quint32> *second)
+		{
+			return (first->count() < second->count());
+		});
+
+		QVector<quint32> candidates(*postings.first());
+
+		for (int i = 1; i < postings.count() && !candidates.isEmpty(); ++i)
+		{
+			QVector<quint32> intersection;
+			intersection.reserve(candidates.count());
+
+			std::set_intersection(candidates.constBegin(), candidates.constEnd(), postings.at(i)->constBegin(), postings.at(i)->constEnd(), std::back_inserter(intersection));
+
+			candidates = intersection;
+		}
+
+		// candidates share all trigrams of the query, but only those containing it as a whole are matches, postings of released strings are skipped here too
+		for (int i = 0; i < candidates.count(); ++i)
+		{
+			const quint32 index(candidates.at(i));
+
+			if (m_table.searchReferences.value(static_cast<int>(index)) > 0 && m_table.getString(index).contains(normalizedQuery, Qt::CaseInsensitive))
+			{
+				matchedStrings.setBit(static_cast<int>(index));
+
+				hasMatches = true;
+			}
+		}
+	}
+
+	if (!hasMatches)
+	{
+		return entries;
+	}
+
+	for (int i = 0; i < m_table.identifiers.count(); ++i)
+	{
+		if (matchedStrings.testBit(static_cast<int>(m_table.urls.at(i))) || matchedStrings.testBit(static_cast<int>(m_table.titles.at(i))))
+		{
+			entries.append(m_table.identifiers.at(i));
+		}
+	}
+
+	return entries;
+}
+
+QModelIndex HistoryModel::getEntryIndex(quint64 identifier) const
+{
+	const int position(m_table.getPosition(m_pendingIdentifiers.value(identifier, identifier)));
+
+	return ((position < 0) ? QModelIndex() : index(m_table.identifiers.count() - position - 1));
+}
+
+QVariant HistoryModel::data(const QModelIndex &index, int role) const
+{
+	if (!index.isValid() || index.row() < 0 || index.row() >= m_table.identifiers.count())
+	{
+		return QVariant();
+	}
+
+	const int position(m_table.identifiers.count() - index.row() - 1);
+
+	switch (role)
+	{
+		case TitleRole:
+			return m_table.getString(m_table.titles.at(position));
+		case UrlRole:
+			return QUrl(m_table.getString(m_table.urls.at(position)));
+		case IdentifierRole:
+			return m_table.identifiers.at(position);
+		case TimeVisitedRole:
+			return ((m_table.timesVisited.at(position) > 0) ? QDateTime::fromMSecsSinceEpoch(m_table.timesVisited.at(position)) : QDateTime());
+		case Qt::DecorationRole:
+			return m_table.icons.value(m_table.urls.at(position));
+		default:
+			break;
+	}
+
+	return QVariant();
+}
+
+HistoryModel::HistoryType HistoryModel::getType() const
+{
+	return m_type;
+}
+
+HistoryModel::LoadResult HistoryModel::loadEntries(const QString &path, const QStringList &journalPaths)
+{
+	LoadResult result;
+	QMap<quint64, HistoryEntry> entries;
+	QFile file(path);
+
+	if (file.open(QIODevice::ReadOnly | QIODevice::Text))
+	{
+		// snapshots are written with one entry per line, so they can be read without parsing whole document at once
+		bool isStreamable(file.readLine().trimmed() == QByteArray("["));
+
+		while (isStreamable && !file.atEnd())
+		{
+			QByteArray line(file.readLine().trimmed());
+
+			if (line.endsWith(','))
+			{
+				line.chop(1);
+			}
+
+			if (line.isEmpty() || line == QByteArray("]"))
+			{
+				continue;
+			}
+
+			const QJsonDocument document(QJsonDocument::fromJson(line));
+
+			if (document.isObject())
+			{
+				applyRecord(document.object(), entries);
+			}
+			else
+			{
+				isStreamable = false;
+			}
+		}
+
+		if (!isStreamable)
+		{
+			entries.clear();
+
+			file.seek(0);
+
+			const QJsonArray historyArray(QJsonDocument::fromJson(file.readAll()).array());
+
+			for (int i = 0; i < historyArray.count(); ++i)
+			{
+				applyRecord(historyArray.at(i).toObject(), entries);
+			}
+		}
+
+		file.close();
+	}
+	else if (file.exists())
+	{
+		result.errorString = tr("Failed to open history file: %1").arg(file.errorString());
+	}
+
+	for (int i = 0; i < journalPaths.count(); ++i)
+	{
+		QFile journalFile(journalPaths.at(i));
+
+		if (!journalFile.open(QIODevice::ReadOnly | QIODevice::Text))
+		{
+			continue;
+		}
+
+		while (!journalFile.atEnd())
+		{
+			const QByteArray line(journalFile.readLine().trimmed());
+
+			if (line.isEmpty())
+			{
+				continue;
+			}
+
+			const QJsonDocument document(QJsonDocument::fromJson(line));
+
+			// last record might be incomplete if the application was terminated while writing it
+			if (document.isObject())
+			{
+				applyRecord(document.object(), entries);
+
+				++result.journalRecords;
+			}
+		}
+
+		journalFile.close();
+	}
+
+	result.table.identifiers.reserve(entries.count());
+	result.table.timesVisited.reserve(entries.count());
+	result.table.urls.reserve(entries.count());
+	result.table.normalizedUrls.reserve(entries.count());
+	result.table.titles.reserve(entries.count());
+	result.table.hosts.reserve(entries.count());
+
+	QMap<quint64, HistoryEntry>::const_iterator iterator;
+
+	for (iterator = entries.constBegin(); iterator != entries.constEnd(); ++iterator)
+	{
+		result.table.insertEntry(result.table.identifiers.count(), iterator.value());
+	}
+
+	return result;
+}
+
+QString HistoryModel::getJournalPath() const
+{
+	const QFileInfo information(m_path);
+
+	return information.dir().filePath(information.completeBaseName() + QLatin1String(".journal"));
+}
+
+QStringList HistoryModel::getUrlPrefixes(const QUrl &url)
+{
+	QStringList prefixes({url.toString().toLower()});
+	const QString address(url.toString(QUrl::RemoveScheme).mid(2).toLower());
+
+	if (address != prefixes.first())
+	{
+		prefixes.append(address);
+	}
+
+	if (address.startsWith(QLatin1String("www.")) && url.host().count(QLatin1Char('.')) > 1)
+	{
+		prefixes.append(address.mid(4));
+	}
+
+	return prefixes;
+}
+
+QVector<quint64> HistoryModel::getTrigrams(const QString &string)
+{
+	const QString normalizedString(string.toLower());
+	QVector<quint64> trigrams;
+
+	if (normalizedString.length() < 3)
+	{
+		return trigrams;
+	}
+
+	trigrams.reserve(normalizedString.length() - 2);
+
+	for (int i = 0; i < (normalizedString.length() - 2); ++i)
+	{
+		trigrams.append((static_cast<quint64>(normalizedString.at(i).unicode()) << 32) | (static_cast<quint64>(normalizedString.at(i + 1).unicode()) << 16) | normalizedString.at(i + 2).unicode());
+	}
+
+	return trigrams;
+}
+
+quint64 HistoryModel::addEntry(const QUrl &url, const QString &title, const QIcon &icon, const QDateTime &date, quint64 identifier)
+{
+	if (m_loadWatcher)
+	{
+		// entries added while loading get temporary identifiers above the range of real ones, mapped when they are added for real
+		const quint64 pendingIdentifier(Q_UINT64_C(0x8000000000000000) + static_cast<quint64>(m_pendingOperations.count()) + 1);
+
+		m_pendingOperations.append([=]()
+		{
+			m_pendingIdentifiers[pendingIdentifier] = addEntry(url, title, icon, date, identifier);
+		});
+
+		return pendingIdentifier;
+	}
+
+	if (m_type == TypedHistory)
+	{
+		const int urlIndex(m_table.getStringIndex(Utils::normalizeUrl(url).toString()));
+
+		if (urlIndex >= 0 && m_table.urlEntries.contains(urlIndex))
+		{
+			const QVector<quint64> identifiers(m_table.urlEntries.value(urlIndex));
+
+			for (int i = 0; i < identifiers.count(); ++i)
+			{
+				removeEntry(identifiers.at(i));
+			}
+		}
+	}
+
+	if (identifier == 0 || m_table.getPosition(identifier) >= 0)
+	{
+		identifier = (m_table.identifiers.isEmpty() ? 1 : (m_table.identifiers.last() + 1));
+	}
+
+	HistoryEntry entry;
+	entry.url = url;
+	entry.title = title;
+	entry.icon = icon;
+	entry.timeVisited = date;
+	entry.identifier = identifier;
+
+	const int position(std::lower_bound(m_table.identifiers.constBegin(), m_table.identifiers.constEnd(), identifier) - m_table.identifiers.constBegin());
+	const int row(m_table.identifiers.count() - position);
+
+	emit entryAboutToBeAdded(date);
+
+	beginInsertRows(QModelIndex(), row, row);
+
+	m_table.insertEntry(position, entry);
+
+	endInsertRows();
+
+	addRecord(QLatin1String("add"), entry);
+
+	emit entryAdded(identifier);
+
+	return identifier;
+}
+
+int HistoryModel::rowCount(const QModelIndex &index) const
+{
+	return (index.isValid() ? 0 : m_table.identifiers.count());
+}
+
+bool HistoryModel::writeSnapshot(const QString &path, const QVector<EntryRecord> &records)
+{
+	QSaveFile file(path);
+
+	if (!file.open(QIODevice::WriteOnly))
+	{
+		return false;
+	}
+
+	file.write(QByteArray("[\n"));
+
+	for (int i = 0; i < records.count(); ++i)
+	{
+		QJsonObject entryObject;
+		entryObject.insert(QLatin1String("identifier"), QJsonValue::fromVariant(records.at(i).identifier));
+		entryObject.insert(QLatin1String("url"), records.at(i).url);
+		entryObject.insert(QLatin1String("title"), records.at(i).title);
+		entryObject.insert(QLatin1String("time"), records.at(i).timeVisited);
+
+		file.write(QJsonDocument(entryObject).toJson(QJsonDocument::Compact));
+		file.write(QByteArray((i < (records.count() - 1)) ? ",\n" : "\n"));
+	}
+
+	file.write(QByteArray("]\n"));
+
+	return file.commit();
+}
+
+bool HistoryModel::save()
+{
+	if (!writeJournal())
+	{
+		return false;
+	}
+
+	if (!m_loadWatcher && !m_compactionWatcher && m_journalRecords > qMax(1000, m_table.identifiers.count()))
+	{
+		compact();
+	}
+
+	return true;
+}
+
+bool HistoryModel::writeJournal()
+{
+	if (m_journal.isEmpty())
+	{
+		return true;
+	}
+
+	if (SessionsManager::isReadOnly())
+	{
+		return false;
+	}
+
+	QFile file(getJournalPath());
+
+	if (!file.open(QIODevice::WriteOnly | QIODevice::Append))
+	{
+		Console::addMessage(tr("Failed to open history journal: %1").arg(file.errorString()), Console::OtherCategory, Console::ErrorLevel, file.fileName());
+
+		return false;
+	}
+
+	file.write(m_journal);
+	file.close();
+
+	m_journal.clear();
+
+	return true;
+}
+
+bool HistoryModel::hasEntry(const QUrl &url) const
+{
+	const int index(m_table.getStringIndex(Utils::normalizeUrl(url).toString()));
+
+	return (index >= 0 && m_table.urlEntries.contains(index));
+}
+
+bool HistoryModel::isEntryMatching(quint64 identifier, const QString &query) const
+{
+	const int position(m_table.getPosition(m_pendingIdentifiers.value(identifier, identifier)));
+
+	if (position < 0 || query.isEmpty())
+	{
+		return false;
+	}
+
+	return (m_table.getString(m_table.urls.at(position)).contains(query, Qt::CaseInsensitive) || m_table.getString(m_table.titles.at(position)).contains(query, Qt::CaseInsensitive));
+}
+
+bool HistoryModel::isLoading() const
 {
-	return m_urls.contains(url);
+	return (m_loadWatcher != nullptr);
 }
 
 }
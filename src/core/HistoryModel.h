@@ -21,26 +21,20 @@
 #ifndef OTTER_HISTORYMODEL_H
 #define OTTER_HISTORYMODEL_H
 
+#include <QtCore/QAbstractListModel>
+#include <QtCore/QBitArray>
 #include <QtCore/QDateTime>
+#include <QtCore/QFutureWatcher>
+#include <QtCore/QJsonObject>
 #include <QtCore/QUrl>
-#include <QtGui/QStandardItemModel>
+#include <QtGui/QIcon>
+
+#include <functional>
 
 namespace Otter
 {
 
-class HistoryEntryItem : public QStandardItem
-{
-public:
-	void setData(const QVariant &value, int role) override;
-	void setItemData(const QVariant &value, int role);
-
-protected:
-	explicit HistoryEntryItem();
-
-friend class HistoryModel;
-};
-
-class HistoryModel : public QStandardItemModel
+class HistoryModel : public QAbstractListModel
 {
 	Q_OBJECT
 
@@ -59,37 +53,134 @@ public:
 		TypedHistory
 	};
 
+	struct HistoryEntry
+	{
+		QUrl url;
+		QString title;
+		QIcon icon;
+		QDateTime timeVisited;
+		quint64 identifier = 0;
+	};
+
 	struct HistoryEntryMatch
 	{
-		HistoryEntryItem *entry = nullptr;
+		HistoryEntry entry;
 		QString match;
 		bool isTypedIn = false;
 	};
 
 	explicit HistoryModel(const QString &path, HistoryType type, QObject *parent = nullptr);
+	~HistoryModel();
 
 	void clearExcessEntries(int limit);
 	void clearRecentEntries(uint period);
 	void clearOldestEntries(int period);
 	void removeEntry(quint64 identifier);
-	HistoryEntryItem* addEntry(const QUrl &url, const QString &title, const QIcon &icon, const QDateTime &date = QDateTime::currentDateTime(), quint64 identifier = 0);
-	HistoryEntryItem* getEntry(quint64 identifier) const;
-	QList<HistoryEntryMatch> findEntries(const QString &prefix, bool markAsTypedIn = false) const;
+	void removeEntries(const QList<quint64> &identifiers);
+	void updateEntry(quint64 identifier, const QUrl &url, const QString &title, const QIcon &icon);
+	HistoryEntry getEntry(quint64 identifier) const;
+	QList<quint64> getHostEntries(const QString &host) const;
+	QList<HistoryEntryMatch> findEntries(const QString &prefix, bool markAsTypedIn = false, int limit = 0) const;
+	QList<quint64> searchEntries(const QString &query) const;
+	QModelIndex getEntryIndex(quint64 identifier) const;
+	QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
 	HistoryType getType() const;
+	quint64 addEntry(const QUrl &url, const QString &title, const QIcon &icon, const QDateTime &date = QDateTime::currentDateTime(), quint64 identifier = 0);
+	int rowCount(const QModelIndex &index = QModelIndex()) const override;
 	bool hasEntry(const QUrl &url) const;
-	bool save(const QString &path) const;
-	bool setData(const QModelIndex &index, const QVariant &value, int role) override;
+	bool isEntryMatching(quint64 identifier, const QString &query) const;
+	bool isLoading() const;
+	bool save();
+
+protected:
+	struct EntryRecord
+	{
+		QString url;
+		QString title;
+		QString timeVisited;
+		quint64 identifier = 0;
+	};
+
+	struct HistoryTable
+	{
+		QVector<QString> strings;
+		QVector<quint32> references;
+		QVector<quint32> searchReferences;
+		QVector<quint32> freeStrings;
+		QHash<QString, quint32> stringIndexes;
+		QVector<quint64> identifiers;
+		QVector<qint64> timesVisited;
+		QVector<quint32> urls;
+		QVector<quint32> normalizedUrls;
+		QVector<quint32> titles;
+		QVector<quint32> hosts;
+		QHash<quint32, QVector<quint64> > urlEntries;
+		QMultiMap<QString, quint32> prefixes;
+		QHash<quint64, QVector<quint32> > trigrams;
+		QHash<quint32, QIcon> icons;
+		int trigramsAmount = 0;
+		int staleTrigramsAmount = 0;
+
+		void clear();
+		void insertEntry(int position, const HistoryEntry &entry);
+		void removeEntries(int first, int last);
+		void updateEntry(int position, const QUrl &url, const QString &title, const QIcon &icon);
+		void addUrl(quint32 index, quint64 identifier);
+		void removeUrl(quint32 index, quint64 identifier);
+		void removeString(quint32 index);
+		void removeSearchString(quint32 index);
+		void addTrigrams(quint32 index);
+		void rebuildTrigrams();
+		HistoryEntry getEntry(int position) const;
+		QString getString(quint32 index) const;
+		int getPosition(quint64 identifier) const;
+		int getStringIndex(const QString &string) const;
+		quint32 addString(const QString &string);
+		quint32 addSearchString(const QString &string);
+	};
+
+	struct LoadResult
+	{
+		HistoryTable table;
+		QString errorString;
+		int journalRecords = 0;
+	};
+
+	void addRecord(const QString &action, const HistoryEntry &entry = HistoryEntry());
+	void addRecord(const QJsonObject &record);
+	void removeEntries(int first, int last);
+	void removeEntries(const QBitArray &entries);
+	void compact();
+	void ensureLoaded();
+	bool writeJournal();
+	QString getJournalPath() const;
+	static LoadResult loadEntries(const QString &path, const QStringList &journalPaths);
+	static void applyRecord(const QJsonObject &record, QMap<quint64, HistoryEntry> &entries);
+	static QStringList getUrlPrefixes(const QUrl &url);
+	static QVector<quint64> getTrigrams(const QString &string);
+	static bool writeSnapshot(const QString &path, const QVector<EntryRecord> &records);
+
+protected slots:
+	void handleLoadFinished();
+	void handleCompactionFinished();
 
 private:
-	QHash<QUrl, QList<HistoryEntryItem*> > m_urls;
-	QMap<quint64, HistoryEntryItem*> m_identifiers;
+	QFutureWatcher<LoadResult> *m_loadWatcher;
+	QFutureWatcher<bool> *m_compactionWatcher;
+	QString m_path;
+	QByteArray m_journal;
+	HistoryTable m_table;
 	HistoryType m_type;
+	QList<std::function<void()> > m_pendingOperations;
+	QHash<quint64, quint64> m_pendingIdentifiers;
+	int m_journalRecords;
 
 signals:
 	void cleared();
-	void entryAdded(HistoryEntryItem *entry);
-	void entryModified(HistoryEntryItem *entry);
-	void entryRemoved(HistoryEntryItem *entry);
+	void entryAboutToBeAdded(const QDateTime &timeVisited);
+	void entryAdded(quint64 identifier);
+	void entryModified(quint64 identifier);
+	void entryRemoved(quint64 identifier);
 	void modelModified();
 };
 
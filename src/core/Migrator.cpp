@@ -110,6 +110,8 @@ void Migrator::run()
 			optionsMap[QLatin1String("Browser/JavaScriptCanDisableContextMen")] = SettingsManager::Permissions_ScriptsCanReceiveRightClicksOption;
 			optionsMap[QLatin1String("Browser/JavaScriptCanShowStatusMessages")] = SettingsManager::Permissions_ScriptsCanShowStatusMessagesOption;
 
+			SettingsManager::save();
+
 			QMap<QString, SettingsManager::OptionIdentifier>::iterator optionsIterator;
 			QSettings configuration(SessionsManager::getWritableDataPath(QLatin1String("otter.conf")), QSettings::IniFormat);
 			const QStringList configurationKeys(configuration.allKeys());
@@ -181,6 +183,11 @@ void Migrator::run()
 
 				ToolBarsManager::setToolBar(sidebarDefiniton);
 			}
+
+			configuration.sync();
+			overrides.sync();
+
+			SettingsManager::reload();
 		}
 
 		if (*iterator == QLatin1String("sessionsIniToJson"))
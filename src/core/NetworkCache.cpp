@@ -21,13 +21,20 @@
 #include "SessionsManager.h"
 #include "SettingsManager.h"
 
-#include <QtCore/QDateTime>
+#include <QtCore/QCryptographicHash>
+#include <QtCore/QDataStream>
 #include <QtCore/QDir>
+#include <QtCore/QSaveFile>
+
+#include <cstring>
 
 namespace Otter
 {
 
-NetworkCache::NetworkCache(QObject *parent) : QNetworkDiskCache(parent)
+NetworkCache::NetworkCache(QObject *parent) : QNetworkDiskCache(parent),
+	m_size(0),
+	m_diskSize(-1),
+	m_pendingSize(0)
 {
 	const QString cachePath(SessionsManager::getCachePath());
 
@@ -36,12 +43,18 @@ NetworkCache::NetworkCache(QObject *parent) : QNetworkDiskCache(parent)
 		QDir().mkpath(cachePath);
 
 		setCacheDirectory(cachePath);
+		loadIndex();
 		setMaximumCacheSize(SettingsManager::getValue(SettingsManager::Cache_DiskCacheLimitOption).toInt() * 1024);
 	}
 
 	connect(SettingsManager::getInstance(), SIGNAL(valueChanged(int,QVariant)), this, SLOT(optionChanged(int,QVariant)));
 }
 
+NetworkCache::~NetworkCache()
+{
+	saveIndex();
+}
+
 void NetworkCache::clearCache(int period)
 {
 	if (period <= 0)
@@ -53,6 +66,121 @@ void NetworkCache::clearCache(int period)
 		return;
 	}
 
+	const QDateTime currentDateTime(QDateTime::currentDateTime());
+	QList<QUrl> entries;
+	QHash<QUrl, EntryInformation>::const_iterator iterator;
+
+	for (iterator = m_entries.constBegin(); iterator != m_entries.constEnd(); ++iterator)
+	{
+		if (iterator.value().lastAccess.secsTo(currentDateTime) < (period * 3600))
+		{
+			entries.append(iterator.key());
+		}
+	}
+
+	for (int i = 0; i < entries.count(); ++i)
+	{
+		remove(entries.at(i));
+	}
+}
+
+void NetworkCache::clear()
+{
+	m_devices.clear();
+	m_entries.clear();
+
+	m_size = 0;
+
+	QNetworkDiskCache::clear();
+}
+
+void NetworkCache::insert(QIODevice *device)
+{
+	const bool hasEntry(m_devices.contains(device));
+	EntryInformation entry(m_devices.take(device));
+	entry.size = device->size();
+
+	m_pendingSize = entry.size;
+
+	QNetworkDiskCache::insert(device);
+
+	m_pendingSize = 0;
+
+	if (!hasEntry)
+	{
+		return;
+	}
+
+	entry.path = getCacheFileName(entry.url);
+	entry.lastAccess = QDateTime::currentDateTime();
+
+	if (!entry.path.isEmpty())
+	{
+		entry.size = QFileInfo(entry.path).size();
+	}
+
+	if (m_entries.contains(entry.url))
+	{
+		m_size -= m_entries[entry.url].size;
+
+		if (m_diskSize >= 0)
+		{
+			m_diskSize = qMax(qint64(0), (m_diskSize - m_entries[entry.url].size));
+		}
+	}
+
+	m_entries[entry.url] = entry;
+
+	m_size += entry.size;
+
+	if (m_diskSize >= 0)
+	{
+		m_diskSize += entry.size;
+	}
+
+	emit entryAdded(entry.url);
+}
+
+void NetworkCache::loadIndex()
+{
+	const QString indexPath(getIndexPath());
+	QFile file(indexPath);
+
+	if (file.open(QIODevice::ReadOnly))
+	{
+		QDataStream stream(&file);
+		quint32 amount;
+
+		stream >> amount;
+
+		m_entries.reserve(amount);
+
+		for (quint32 i = 0; i < amount; ++i)
+		{
+			EntryInformation entry;
+
+			stream >> entry.url >> entry.path >> entry.mimeType >> entry.lastAccess >> entry.lastModified >> entry.expirationDate >> entry.size;
+
+			m_entries[entry.url] = entry;
+
+			m_size += entry.size;
+		}
+
+		file.close();
+
+		// index is written back on clean shutdown only, so a crash forces a rebuild
+		file.remove();
+
+		if (stream.status() == QDataStream::Ok)
+		{
+			return;
+		}
+
+		m_entries.clear();
+
+		m_size = 0;
+	}
+
 	const QDir cacheMainDirectory(cacheDirectory());
 	const QStringList directories(cacheMainDirectory.entryList(QDir::AllDirs | QDir::NoDotAndDotDot));
 
@@ -67,30 +195,81 @@ void NetworkCache::clearCache(int period)
 
 			for (int k = 0; k < files.count(); ++k)
 			{
-				if (files.at(k).lastModified().secsTo(QDateTime::currentDateTime()) < (period * 3600))
-				{
-					const QNetworkCacheMetaData metaData(fileMetaData(files.at(k).absoluteFilePath()));
+				const QNetworkCacheMetaData metaData(fileMetaData(files.at(k).absoluteFilePath()));
 
-					if (metaData.isValid())
-					{
-						remove(metaData.url());
-					}
+				if (!metaData.isValid() || !metaData.url().isValid())
+				{
+					continue;
 				}
+
+				EntryInformation entry;
+				entry.url = metaData.url();
+				entry.path = files.at(k).absoluteFilePath();
+				entry.mimeType = getMimeType(metaData);
+				entry.lastAccess = files.at(k).lastModified();
+				entry.lastModified = metaData.lastModified();
+				entry.expirationDate = metaData.expirationDate();
+				entry.size = files.at(k).size();
+
+				m_entries[entry.url] = entry;
+
+				m_size += entry.size;
 			}
 		}
 	}
 }
 
-void NetworkCache::insert(QIODevice *device)
+void NetworkCache::saveIndex() const
 {
-	QNetworkDiskCache::insert(device);
+	const QString indexPath(getIndexPath());
+
+	if (indexPath.isEmpty() || SessionsManager::isReadOnly())
+	{
+		return;
+	}
+
+	QSaveFile file(indexPath);
 
-	if (m_devices.contains(device))
+	if (!file.open(QIODevice::WriteOnly))
 	{
-		emit entryAdded(m_devices[device]);
+		return;
+	}
+
+	QDataStream stream(&file);
+	stream << quint32(m_entries.count());
+
+	QHash<QUrl, EntryInformation>::const_iterator iterator;
+
+	for (iterator = m_entries.constBegin(); iterator != m_entries.constEnd(); ++iterator)
+	{
+		const EntryInformation &entry(iterator.value());
 
-		m_devices.remove(device);
+		stream << entry.url << entry.path << entry.mimeType << entry.lastAccess << entry.lastModified << entry.expirationDate << entry.size;
 	}
+
+	file.commit();
+}
+
+QIODevice* NetworkCache::data(const QUrl &url)
+{
+	QIODevice *device(QNetworkDiskCache::data(url));
+	const QHash<QUrl, EntryInformation>::iterator iterator(m_entries.find(url));
+
+	if (iterator != m_entries.end())
+	{
+		if (device)
+		{
+			iterator.value().lastAccess = QDateTime::currentDateTime();
+		}
+		else
+		{
+			m_size -= iterator.value().size;
+
+			m_entries.erase(iterator);
+		}
+	}
+
+	return device;
 }
 
 QIODevice* NetworkCache::prepare(const QNetworkCacheMetaData &metaData)
@@ -99,83 +278,181 @@ QIODevice* NetworkCache::prepare(const QNetworkCacheMetaData &metaData)
 
 	if (device)
 	{
-		m_devices[device] = metaData.url();
+		EntryInformation entry;
+		entry.url = metaData.url();
+		entry.mimeType = getMimeType(metaData);
+		entry.lastModified = metaData.lastModified();
+		entry.expirationDate = metaData.expirationDate();
+
+		m_devices[device] = entry;
 	}
 
 	return device;
 }
 
-QString NetworkCache::getPathForUrl(const QUrl &url)
+QString NetworkCache::getCacheFileName(const QUrl &url) const
 {
-	if (!url.isValid() || !metaData(url).isValid())
+	if (cacheDirectory().isEmpty())
 	{
 		return QString();
 	}
 
-	const QDir cacheMainDirectory(cacheDirectory());
-	const QStringList directories(cacheMainDirectory.entryList(QDir::AllDirs | QDir::NoDotAndDotDot));
+	QUrl cleanUrl(url);
+	cleanUrl.setPassword(QString());
+	cleanUrl.setFragment(QString());
 
-	for (int i = 0; i < directories.count(); ++i)
+	const QByteArray hash(QCryptographicHash::hash(cleanUrl.toEncoded(), QCryptographicHash::Sha1));
+	qlonglong number(0);
+
+	std::memcpy(&number, hash.constData(), sizeof(number));
+
+	const QByteArray identifier(QByteArray::number(number, 36).left(8));
+
+	// mirrors file naming of QNetworkDiskCache (cache format version 8)
+	const QString path(QDir(cacheDirectory()).absoluteFilePath(QStringLiteral("data8/%1/%2.d").arg(QString::number((static_cast<uint>(identifier.at(identifier.length() - 1)) % 16), 16)).arg(QString::fromLatin1(identifier))));
+
+	return (QFile::exists(path) ? path : QString());
+}
+
+QString NetworkCache::getIndexPath() const
+{
+	return (cacheDirectory().isEmpty() ? QString() : QDir(cacheDirectory()).absoluteFilePath(QLatin1String("index.dat")));
+}
+
+QString NetworkCache::getPathForUrl(const QUrl &url)
+{
+	const QHash<QUrl, EntryInformation>::iterator iterator(m_entries.find(url));
+
+	if (!url.isValid() || iterator == m_entries.end())
 	{
-		const QDir cacheSubDirectory(cacheMainDirectory.absoluteFilePath(directories.at(i)));
-		const QStringList subDirectories(cacheSubDirectory.entryList(QDir::AllDirs | QDir::NoDotAndDotDot));
+		return QString();
+	}
 
-		for (int j = 0; j < subDirectories.count(); ++j)
-		{
-			const QDir cacheFilesDirectory(cacheSubDirectory.absoluteFilePath(subDirectories.at(j)));
-			const QStringList files(cacheFilesDirectory.entryList(QDir::Files));
+	if (iterator.value().path.isEmpty() || !QFile::exists(iterator.value().path))
+	{
+		iterator.value().path = getCacheFileName(url);
+	}
 
-			for (int k = 0; k < files.count(); ++k)
-			{
-				const QString cacheFilePath(cacheFilesDirectory.absoluteFilePath(files.at(k)));
-				const QNetworkCacheMetaData metaData(fileMetaData(cacheFilePath));
+	return iterator.value().path;
+}
 
-				if (metaData.isValid() && url == metaData.url())
-				{
-					return cacheFilePath;
-				}
-			}
+QString NetworkCache::getMimeType(const QNetworkCacheMetaData &metaData)
+{
+	const QList<QPair<QByteArray, QByteArray> > headers(metaData.rawHeaders());
+
+	for (int i = 0; i < headers.count(); ++i)
+	{
+		if (headers.at(i).first == QStringLiteral("Content-Type").toLatin1())
+		{
+			return QString(headers.at(i).second).section(QLatin1Char(';'), 0, 0).trimmed();
 		}
 	}
 
 	return QString();
 }
 
-QList<QUrl> NetworkCache::getEntries() const
+NetworkCache::EntryInformation NetworkCache::getEntry(const QUrl &url) const
 {
-	QList<QUrl> entries;
+	return m_entries.value(url);
+}
 
-	const QDir cacheMainDirectory(cacheDirectory());
-	const QStringList directories(cacheMainDirectory.entryList(QDir::AllDirs | QDir::NoDotAndDotDot));
+QList<NetworkCache::EntryInformation> NetworkCache::getEntries() const
+{
+	return m_entries.values();
+}
 
-	for (int i = 0; i < directories.count(); ++i)
+qint64 NetworkCache::expire()
+{
+	const qint64 limit(maximumCacheSize());
+
+	if (limit <= 0)
 	{
-		const QDir cacheSubDirectory(cacheMainDirectory.absoluteFilePath(directories.at(i)));
-		const QStringList subDirectories(cacheSubDirectory.entryList(QDir::AllDirs | QDir::NoDotAndDotDot));
+		m_entries.clear();
 
-		for (int j = 0; j < subDirectories.count(); ++j)
+		m_size = 0;
+		m_diskSize = QNetworkDiskCache::expire();
+
+		return m_diskSize;
+	}
+
+	const qint64 goal((limit * 9) / 10);
+
+	if ((m_size + m_pendingSize) > limit)
+	{
+		QMultiMap<QDateTime, QUrl> entries;
+		QHash<QUrl, EntryInformation>::const_iterator entriesIterator;
+
+		for (entriesIterator = m_entries.constBegin(); entriesIterator != m_entries.constEnd(); ++entriesIterator)
 		{
-			const QDir cacheFilesDirectory(cacheSubDirectory.absoluteFilePath(subDirectories.at(j)));
-			const QStringList files(cacheFilesDirectory.entryList(QDir::Files));
+			entries.insert(entriesIterator.value().lastAccess, entriesIterator.key());
+		}
 
-			for (int k = 0; k < files.count(); ++k)
+		QMultiMap<QDateTime, QUrl>::const_iterator iterator;
+
+		for (iterator = entries.constBegin(); iterator != entries.constEnd() && (m_size + m_pendingSize) > goal; ++iterator)
+		{
+			remove(iterator.value());
+		}
+	}
+
+	if (m_diskSize < 0 || (m_diskSize != m_size && (m_diskSize + m_pendingSize) > limit))
+	{
+		m_diskSize = qMax(qint64(0), (QNetworkDiskCache::expire() - m_pendingSize));
+
+		if (m_diskSize < m_size)
+		{
+			QHash<QUrl, EntryInformation>::iterator iterator(m_entries.begin());
+
+			while (iterator != m_entries.end())
 			{
-				const QNetworkCacheMetaData metaData(fileMetaData(cacheFilesDirectory.absoluteFilePath(files.at(k))));
+				if ((iterator.value().path.isEmpty() || !QFile::exists(iterator.value().path)) && getCacheFileName(iterator.key()).isEmpty())
+				{
+					m_size -= iterator.value().size;
 
-				if (metaData.url().isValid())
+					iterator = m_entries.erase(iterator);
+				}
+				else
 				{
-					entries.append(metaData.url());
+					++iterator;
 				}
 			}
 		}
 	}
 
-	return entries;
+	return (qMax(m_size, m_diskSize) + m_pendingSize);
 }
 
 bool NetworkCache::remove(const QUrl &url)
 {
+	QHash<QIODevice*, EntryInformation>::iterator devicesIterator(m_devices.begin());
+
+	// cancelled insertions are removed by URL and their devices are deleted by the base class
+	while (devicesIterator != m_devices.end())
+	{
+		if (devicesIterator.value().url == url)
+		{
+			devicesIterator = m_devices.erase(devicesIterator);
+		}
+		else
+		{
+			++devicesIterator;
+		}
+	}
+
 	const bool result(QNetworkDiskCache::remove(url));
+	const QHash<QUrl, EntryInformation>::iterator iterator(m_entries.find(url));
+
+	if (iterator != m_entries.end())
+	{
+		m_size -= iterator.value().size;
+
+		if (result && m_diskSize >= 0)
+		{
+			m_diskSize = qMax(qint64(0), (m_diskSize - iterator.value().size));
+		}
+
+		m_entries.erase(iterator);
+	}
 
 	if (result)
 	{
@@ -20,6 +20,7 @@
 #ifndef OTTER_NETWORKCACHE_H
 #define OTTER_NETWORKCACHE_H
 
+#include <QtCore/QDateTime>
 #include <QtNetwork/QNetworkDiskCache>
 
 namespace Otter
@@ -30,20 +31,49 @@ class NetworkCache : public QNetworkDiskCache
 	Q_OBJECT
 
 public:
+	struct EntryInformation
+	{
+		QUrl url;
+		QString path;
+		QString mimeType;
+		QDateTime lastAccess;
+		QDateTime lastModified;
+		QDateTime expirationDate;
+		qint64 size = 0;
+	};
+
 	explicit NetworkCache(QObject *parent = nullptr);
+	~NetworkCache();
 
 	void clearCache(int period = 0);
 	void insert(QIODevice *device) override;
+	QIODevice* data(const QUrl &url) override;
 	QIODevice* prepare(const QNetworkCacheMetaData &metaData) override;
 	QString getPathForUrl(const QUrl &url);
-	QList<QUrl> getEntries() const;
+	EntryInformation getEntry(const QUrl &url) const;
+	QList<EntryInformation> getEntries() const;
 	bool remove(const QUrl &url) override;
 
+public slots:
+	void clear() override;
+
+protected:
+	void loadIndex();
+	void saveIndex() const;
+	QString getCacheFileName(const QUrl &url) const;
+	QString getIndexPath() const;
+	qint64 expire() override;
+	static QString getMimeType(const QNetworkCacheMetaData &metaData);
+
 protected slots:
 	void optionChanged(int identifier, const QVariant &value);
 
 private:
-	QHash<QIODevice*, QUrl> m_devices;
+	QHash<QIODevice*, EntryInformation> m_devices;
+	QHash<QUrl, EntryInformation> m_entries;
+	qint64 m_size;
+	qint64 m_diskSize;
+	qint64 m_pendingSize;
 
 signals:
 	void cleared();
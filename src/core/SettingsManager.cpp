@@ -26,6 +26,7 @@
 #include <QtCore/QSettings>
 #include <QtCore/QStandardPaths>
 #include <QtCore/QTextStream>
+#include <QtCore/QTimerEvent>
 #include <QtCore/QVector>
 
 namespace Otter
@@ -35,15 +36,29 @@ SettingsManager* SettingsManager::m_instance(nullptr);
 QString SettingsManager::m_globalPath;
 QString SettingsManager::m_overridePath;
 QVector<SettingsManager::OptionDefinition> SettingsManager::m_definitions;
+QVector<QVariant> SettingsManager::m_values;
+QHash<QString, QHash<int, QVariant> > SettingsManager::m_overrides;
+QHash<QString, QVariant> SettingsManager::m_unknownValues;
+QHash<QString, QHash<QString, QVariant> > SettingsManager::m_unknownOverrides;
 QHash<QString, int> SettingsManager::m_customOptions;
+QReadWriteLock SettingsManager::m_valuesLock;
 int SettingsManager::m_identifierCounter(-1);
 int SettingsManager::m_optionIdentifierEnumerator(0);
 bool SettingsManager::m_hasWildcardedOverrides(false);
 
-SettingsManager::SettingsManager(QObject *parent) : QObject(parent)
+SettingsManager::SettingsManager(QObject *parent) : QObject(parent),
+	m_saveTimer(0)
 {
 }
 
+SettingsManager::~SettingsManager()
+{
+	if (m_saveTimer != 0)
+	{
+		save();
+	}
+}
+
 void SettingsManager::createInstance(const QString &path, QObject *parent)
 {
 	if (m_instance)
@@ -229,29 +244,167 @@ void SettingsManager::createInstance(const QString &path, QObject *parent)
 	registerOption(Updates_LastCheckOption, QString(), StringType);
 	registerOption(Updates_ServerUrlOption, QLatin1String("https://www.otter-browser.org/updates/update.json"), StringType);
 
-	const QStringList hosts(QSettings(m_overridePath, QSettings::IniFormat).childGroups());
+	reload();
+}
+
+void SettingsManager::timerEvent(QTimerEvent *event)
+{
+	if (event->timerId() == m_saveTimer)
+	{
+		save();
+	}
+}
+
+void SettingsManager::save()
+{
+	if (m_instance->m_saveTimer != 0)
+	{
+		m_instance->killTimer(m_instance->m_saveTimer);
+
+		m_instance->m_saveTimer = 0;
+	}
+
+	QReadLocker locker(&m_valuesLock);
+	QSettings globalSettings(m_globalPath, QSettings::IniFormat);
+	globalSettings.clear();
+
+	for (int i = 0; i < m_values.count(); ++i)
+	{
+		if (m_values.at(i).isValid())
+		{
+			globalSettings.setValue(getOptionName(i), m_values.at(i));
+		}
+	}
+
+	QHash<QString, QVariant>::const_iterator valuesIterator;
+
+	for (valuesIterator = m_unknownValues.constBegin(); valuesIterator != m_unknownValues.constEnd(); ++valuesIterator)
+	{
+		globalSettings.setValue(valuesIterator.key(), valuesIterator.value());
+	}
+
+	globalSettings.sync();
+
+	QSettings overrideSettings(m_overridePath, QSettings::IniFormat);
+	overrideSettings.clear();
+
+	QHash<QString, QHash<int, QVariant> >::const_iterator overridesIterator;
+
+	for (overridesIterator = m_overrides.constBegin(); overridesIterator != m_overrides.constEnd(); ++overridesIterator)
+	{
+		overrideSettings.beginGroup(overridesIterator.key());
+
+		QHash<int, QVariant>::const_iterator iterator;
+
+		for (iterator = overridesIterator.value().constBegin(); iterator != overridesIterator.value().constEnd(); ++iterator)
+		{
+			overrideSettings.setValue(getOptionName(iterator.key()), iterator.value());
+		}
+
+		overrideSettings.endGroup();
+	}
+
+	QHash<QString, QHash<QString, QVariant> >::const_iterator unknownOverridesIterator;
+
+	for (unknownOverridesIterator = m_unknownOverrides.constBegin(); unknownOverridesIterator != m_unknownOverrides.constEnd(); ++unknownOverridesIterator)
+	{
+		overrideSettings.beginGroup(unknownOverridesIterator.key());
+
+		for (valuesIterator = unknownOverridesIterator.value().constBegin(); valuesIterator != unknownOverridesIterator.value().constEnd(); ++valuesIterator)
+		{
+			overrideSettings.setValue(valuesIterator.key(), valuesIterator.value());
+		}
+
+		overrideSettings.endGroup();
+	}
+
+	overrideSettings.sync();
+}
+
+void SettingsManager::reload()
+{
+	QWriteLocker locker(&m_valuesLock);
+
+	m_values.fill(QVariant(), m_definitions.count());
+	m_overrides.clear();
+	m_unknownValues.clear();
+	m_unknownOverrides.clear();
+
+	m_hasWildcardedOverrides = false;
+
+	const QSettings globalSettings(m_globalPath, QSettings::IniFormat);
+	const QStringList keys(globalSettings.allKeys());
+
+	for (int i = 0; i < keys.count(); ++i)
+	{
+		const int identifier(getOptionIdentifier(keys.at(i)));
+
+		if (identifier >= 0 && identifier < m_values.count())
+		{
+			m_values[identifier] = globalSettings.value(keys.at(i));
+		}
+		else
+		{
+			m_unknownValues[keys.at(i)] = globalSettings.value(keys.at(i));
+		}
+	}
+
+	QSettings overrideSettings(m_overridePath, QSettings::IniFormat);
+	const QStringList hosts(overrideSettings.childGroups());
 
 	for (int i = 0; i < hosts.count(); ++i)
 	{
 		if (hosts.at(i).startsWith(QLatin1Char('*')))
 		{
 			m_hasWildcardedOverrides = true;
+		}
+
+		overrideSettings.beginGroup(hosts.at(i));
+
+		const QStringList overrideKeys(overrideSettings.allKeys());
+
+		for (int j = 0; j < overrideKeys.count(); ++j)
+		{
+			const int identifier(getOptionIdentifier(overrideKeys.at(j)));
 
-			break;
+			if (identifier >= 0 && identifier < m_values.count())
+			{
+				m_overrides[hosts.at(i)][identifier] = overrideSettings.value(overrideKeys.at(j));
+			}
+			else
+			{
+				m_unknownOverrides[hosts.at(i)][overrideKeys.at(j)] = overrideSettings.value(overrideKeys.at(j));
+			}
 		}
+
+		overrideSettings.endGroup();
 	}
 }
 
 void SettingsManager::removeOverride(const QUrl &url, const QString &key)
 {
+	const QString host(getHost(url));
+
+	m_valuesLock.lockForWrite();
+
 	if (key.isEmpty())
 	{
-		QSettings(m_overridePath, QSettings::IniFormat).remove(getHost(url));
+		m_overrides.remove(host);
+		m_unknownOverrides.remove(host);
 	}
-	else
+	else if (m_overrides.contains(host))
 	{
-		QSettings(m_overridePath, QSettings::IniFormat).remove(getHost(url) + QLatin1Char('/') + key);
+		m_overrides[host].remove(getOptionIdentifier(key));
+
+		if (m_overrides[host].isEmpty())
+		{
+			m_overrides.remove(host);
+		}
 	}
+
+	m_valuesLock.unlock();
+
+	m_instance->scheduleSave();
 }
 
 void SettingsManager::registerOption(int identifier, const QVariant &defaultValue, SettingsManager::OptionType type, const QStringList &choices)
@@ -268,6 +421,8 @@ void SettingsManager::registerOption(int identifier, const QVariant &defaultValu
 
 void SettingsManager::updateOptionDefinition(int identifier, const SettingsManager::OptionDefinition &definition)
 {
+	QWriteLocker locker(&m_valuesLock);
+
 	if (identifier >= 0 && identifier < m_definitions.count())
 	{
 		m_definitions[identifier].defaultValue = definition.defaultValue;
@@ -275,28 +430,53 @@ void SettingsManager::updateOptionDefinition(int identifier, const SettingsManag
 	}
 }
 
+void SettingsManager::scheduleSave()
+{
+	if (m_saveTimer == 0)
+	{
+		m_saveTimer = startTimer(1000);
+	}
+}
+
 void SettingsManager::setValue(int identifier, const QVariant &value, const QUrl &url)
 {
-	const QString name(getOptionName(identifier));
+	if (identifier < 0 || identifier >= m_definitions.count())
+	{
+		return;
+	}
 
 	if (!url.isEmpty())
 	{
-		const QString overrideName(getHost(url) + QLatin1Char('/') + name);
+		const QString host(getHost(url));
+
+		m_valuesLock.lockForWrite();
 
 		if (value.isNull())
 		{
-			QSettings(m_overridePath, QSettings::IniFormat).remove(overrideName);
+			if (m_overrides.contains(host))
+			{
+				m_overrides[host].remove(identifier);
+
+				if (m_overrides[host].isEmpty())
+				{
+					m_overrides.remove(host);
+				}
+			}
 		}
 		else
 		{
-			QSettings(m_overridePath, QSettings::IniFormat).setValue(overrideName, value);
+			m_overrides[host][identifier] = value;
 		}
 
-		if (!m_hasWildcardedOverrides && overrideName.startsWith(QLatin1Char('*')))
+		if (!m_hasWildcardedOverrides && host.startsWith(QLatin1Char('*')))
 		{
 			m_hasWildcardedOverrides = true;
 		}
 
+		m_valuesLock.unlock();
+
+		m_instance->scheduleSave();
+
 		emit m_instance->valueChanged(identifier, value, url);
 
 		return;
@@ -304,7 +484,13 @@ void SettingsManager::setValue(int identifier, const QVariant &value, const QUrl
 
 	if (getValue(identifier) != value)
 	{
-		QSettings(m_globalPath, QSettings::IniFormat).setValue(name, value);
+		m_valuesLock.lockForWrite();
+
+		m_values[identifier] = value;
+
+		m_valuesLock.unlock();
+
+		m_instance->scheduleSave();
 
 		emit m_instance->valueChanged(identifier, value);
 	}
@@ -342,30 +528,32 @@ QString SettingsManager::getReport()
 	stream << QLatin1String("Settings:\n");
 
 	QHash<QString, int> overridenValues;
-	QSettings overrides(m_overridePath, QSettings::IniFormat);
-	const QStringList overridesGroups(overrides.childGroups());
 
-	for (int i = 0; i < overridesGroups.count(); ++i)
-	{
-		overrides.beginGroup(overridesGroups.at(i));
+	m_valuesLock.lockForRead();
 
-		const QStringList keys(overrides.allKeys());
+	QHash<QString, QHash<int, QVariant> >::const_iterator overridesIterator;
 
-		for (int j = 0; j < keys.count(); ++j)
+	for (overridesIterator = m_overrides.constBegin(); overridesIterator != m_overrides.constEnd(); ++overridesIterator)
+	{
+		const QList<int> identifiers(overridesIterator.value().keys());
+
+		for (int i = 0; i < identifiers.count(); ++i)
 		{
-			if (overridenValues.contains(keys.at(j)))
+			const QString name(getOptionName(identifiers.at(i)));
+
+			if (overridenValues.contains(name))
 			{
-				++overridenValues[keys.at(j)];
+				++overridenValues[name];
 			}
 			else
 			{
-				overridenValues[keys.at(j)] = 1;
+				overridenValues[name] = 1;
 			}
 		}
-
-		overrides.endGroup();
 	}
 
+	m_valuesLock.unlock();
+
 	QStringList options;
 
 	for (int i = 0; i < m_definitions.count(); ++i)
@@ -406,38 +594,42 @@ QString SettingsManager::getReport()
 
 QVariant SettingsManager::getValue(int identifier, const QUrl &url)
 {
+	QReadLocker locker(&m_valuesLock);
+
 	if (identifier < 0 || identifier >= m_definitions.count())
 	{
 		return QVariant();
 	}
 
-	const QString name(getOptionName(identifier));
-
-	if (url.isEmpty())
+	if (!url.isEmpty() && !m_overrides.isEmpty())
 	{
-		return QSettings(m_globalPath, QSettings::IniFormat).value(name, m_definitions.at(identifier).defaultValue);
-	}
-
-	const QString host(getHost(url));
-	const QString overrideName(host + QLatin1Char('/') + name);
-	const QSettings overrides(m_overridePath, QSettings::IniFormat);
+		const QString host(getHost(url));
+		QHash<QString, QHash<int, QVariant> >::const_iterator iterator(m_overrides.constFind(host));
 
-	if (m_hasWildcardedOverrides && !overrides.contains(overrideName))
-	{
-		const QStringList hostParts(host.split(QLatin1Char('.')));
+		if (iterator != m_overrides.constEnd() && iterator.value().contains(identifier))
+		{
+			return iterator.value().value(identifier);
+		}
 
-		for (int i = 1; i < hostParts.count(); ++i)
+		if (m_hasWildcardedOverrides)
 		{
-			const QString wildcardedName(QLatin1String("*.") + QStringList(hostParts.mid(i)).join(QLatin1Char('.')) + QLatin1Char('/') + name);
+			const QStringList hostParts(host.split(QLatin1Char('.')));
 
-			if (overrides.contains(wildcardedName))
+			for (int i = 1; i < hostParts.count(); ++i)
 			{
-				return QSettings(m_overridePath, QSettings::IniFormat).value(wildcardedName, getValue(identifier));
+				iterator = m_overrides.constFind(QLatin1String("*.") + QStringList(hostParts.mid(i)).join(QLatin1Char('.')));
+
+				if (iterator != m_overrides.constEnd() && iterator.value().contains(identifier))
+				{
+					return iterator.value().value(identifier);
+				}
 			}
 		}
 	}
 
-	return QSettings(m_overridePath, QSettings::IniFormat).value(overrideName, getValue(identifier));
+	const QVariant value(m_values.value(identifier));
+
+	return (value.isValid() ? value : m_definitions.at(identifier).defaultValue);
 }
 
 QStringList SettingsManager::getOptions()
@@ -456,6 +648,8 @@ QStringList SettingsManager::getOptions()
 
 SettingsManager::OptionDefinition SettingsManager::getOptionDefinition(int identifier)
 {
+	QReadLocker locker(&m_valuesLock);
+
 	if (identifier >= 0 && identifier < m_definitions.count())
 	{
 		return m_definitions.at(identifier);
@@ -481,9 +675,32 @@ int SettingsManager::registerOption(const QString &name, const QVariant &default
 	definition.type = type;
 	definition.identifier = identifier;
 
+	QWriteLocker locker(&m_valuesLock);
+
 	m_customOptions[name] = identifier;
 
 	m_definitions.append(definition);
+	m_values.resize(m_definitions.count());
+	m_values[identifier] = m_unknownValues.take(name);
+
+	QHash<QString, QHash<QString, QVariant> >::iterator iterator(m_unknownOverrides.begin());
+
+	while (iterator != m_unknownOverrides.end())
+	{
+		if (iterator.value().contains(name))
+		{
+			m_overrides[iterator.key()][identifier] = iterator.value().take(name);
+		}
+
+		if (iterator.value().isEmpty())
+		{
+			iterator = m_unknownOverrides.erase(iterator);
+		}
+		else
+		{
+			++iterator;
+		}
+	}
 
 	return identifier;
 }
@@ -508,12 +725,15 @@ int SettingsManager::getOptionIdentifier(const QString &name)
 
 bool SettingsManager::hasOverride(const QUrl &url, int identifier)
 {
+	const QString host(getHost(url));
+	QReadLocker locker(&m_valuesLock);
+
 	if (identifier < 0)
 	{
-		return QSettings(m_overridePath, QSettings::IniFormat).childGroups().contains(getHost(url));
+		return (m_overrides.contains(host) || m_unknownOverrides.contains(host));
 	}
 
-	return QSettings(m_overridePath, QSettings::IniFormat).contains(getHost(url) + QLatin1Char('/') + getOptionName(identifier));
+	return m_overrides.value(host).contains(identifier);
 }
 
 }
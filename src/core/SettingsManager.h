@@ -23,6 +23,7 @@
 #define OTTER_SETTINGSMANAGER_H
 
 #include <QtCore/QObject>
+#include <QtCore/QReadWriteLock>
 #include <QtCore/QUrl>
 #include <QtCore/QVariant>
 
@@ -243,7 +244,11 @@ public:
 		int identifier = -1;
 	};
 
+	~SettingsManager();
+
 	static void createInstance(const QString &path, QObject *parent = nullptr);
+	static void save();
+	static void reload();
 	static void removeOverride(const QUrl &url, const QString &key = QString());
 	static void updateOptionDefinition(int identifier, const OptionDefinition &definition);
 	static void setValue(int identifier, const QVariant &value, const QUrl &url = QUrl());
@@ -260,15 +265,24 @@ public:
 protected:
 	explicit SettingsManager(QObject *parent = nullptr);
 
+	void timerEvent(QTimerEvent *event) override;
+	void scheduleSave();
 	static QString getHost(const QUrl &url);
 	static void registerOption(int identifier, const QVariant &defaultValue, OptionType type, const QStringList &choices = QStringList());
 
 private:
+	int m_saveTimer;
+
 	static SettingsManager *m_instance;
 	static QString m_globalPath;
 	static QString m_overridePath;
 	static QVector<OptionDefinition> m_definitions;
+	static QVector<QVariant> m_values;
+	static QHash<QString, QHash<int, QVariant> > m_overrides;
+	static QHash<QString, QVariant> m_unknownValues;
+	static QHash<QString, QHash<QString, QVariant> > m_unknownOverrides;
 	static QHash<QString, int> m_customOptions;
+	static QReadWriteLock m_valuesLock;
 	static int m_identifierCounter;
 	static int m_optionIdentifierEnumerator;
 	static bool m_hasWildcardedOverrides;
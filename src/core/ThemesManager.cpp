@@ -41,6 +41,7 @@ namespace Otter
 ThemesManager* ThemesManager::m_instance(nullptr);
 QWidget* ThemesManager::m_probeWidget(nullptr);
 QString ThemesManager::m_iconThemePath(QLatin1String(":/icons/"));
+QHash<QString, QIcon> ThemesManager::m_icons;
 bool ThemesManager::m_useSystemIconTheme(false);
 
 ThemesManager::ThemesManager(QObject *parent) : QObject(parent)
@@ -88,6 +89,7 @@ void ThemesManager::optionChanged(int identifier, const QVariant &value)
 				if (path != m_iconThemePath)
 				{
 					m_iconThemePath = path;
+					m_icons.clear();
 
 					emit iconThemeChanged();
 				}
@@ -98,6 +100,7 @@ void ThemesManager::optionChanged(int identifier, const QVariant &value)
 			if (value.toBool() != m_useSystemIconTheme)
 			{
 				m_useSystemIconTheme = value.toBool();
+				m_icons.clear();
 
 				emit iconThemeChanged();
 			}
@@ -131,20 +134,30 @@ Style* ThemesManager::createStyle(const QString &name)
 
 QIcon ThemesManager::getIcon(const QString &name, bool fromTheme)
 {
-	if (m_useSystemIconTheme && fromTheme && QIcon::hasThemeIcon(name))
+	const QString key((fromTheme ? QLatin1String("theme:") : QLatin1String("path:")) + name);
+
+	if (m_icons.contains(key))
 	{
-		return QIcon::fromTheme(name);
+		return m_icons[key];
 	}
 
-	const QString iconPath(m_iconThemePath + name);
-	const QString svgPath(iconPath + QLatin1String(".svg"));
+	QIcon icon;
 
-	if (QFile::exists(svgPath))
+	if (m_useSystemIconTheme && fromTheme && QIcon::hasThemeIcon(name))
 	{
-		return QIcon(svgPath);
+		icon = QIcon::fromTheme(name);
 	}
+	else
+	{
+		const QString iconPath(m_iconThemePath + name);
+		const QString svgPath(iconPath + QLatin1String(".svg"));
+
+		icon = QIcon(QFile::exists(svgPath) ? svgPath : (iconPath + QLatin1String(".png")));
+	}
+
+	m_icons[key] = icon;
 
-	return QIcon(iconPath + QLatin1String(".png"));
+	return icon;
 }
 
 bool ThemesManager::eventFilter(QObject *object, QEvent *event)
@@ -60,6 +60,7 @@ private:
 	static ThemesManager *m_instance;
 	static QWidget *m_probeWidget;
 	static QString m_iconThemePath;
+	static QHash<QString, QIcon> m_icons;
 	static bool m_useSystemIconTheme;
 
 signals:
@@ -54,6 +54,8 @@ void UserScript::reload()
 	m_injectionTime = DocumentReadyTime;
 	m_shouldRunOnSubFrames = true;
 
+	AddonsManager::invalidateUserScriptRules();
+
 	QFile file(m_path);
 
 	if (!file.open(QIODevice::ReadOnly | QIODevice::Text))
@@ -220,49 +222,6 @@ QString UserScript::getSource()
 	return m_source;
 }
 
-QString UserScript::checkUrlSubString(const QString &rule, const QString &urlSubString, QString generatedUrl, int position) const
-{
-	if (rule.isEmpty())
-	{
-		return urlSubString;
-	}
-
-	for (int i = 0; i < urlSubString.length(); ++i)
-	{
-		const QChar character(urlSubString.at(i));
-
-		if (rule[position] == QLatin1Char('*'))
-		{
-			const QString wildcardString(urlSubString.mid(i));
-
-			for (int j = 1; j < wildcardString.length(); ++j)
-			{
-				const QString result(checkUrlSubString(rule, urlSubString.right(wildcardString.length() - j), generatedUrl + wildcardString.left(j), (position + 1)));
-
-				if (!result.isEmpty())
-				{
-					return result;
-				}
-			}
-		}
-		else if (character != rule[position])
-		{
-			return QString();
-		}
-
-		++position;
-
-		generatedUrl += character;
-
-		if (position == rule.length())
-		{
-			return generatedUrl;
-		}
-	}
-
-	return QString();
-}
-
 QUrl UserScript::getHomePage() const
 {
 	return m_homePage;
@@ -295,14 +254,14 @@ QStringList UserScript::getMatchRules() const
 
 QList<UserScript*> UserScript::getUserScriptsForUrl(const QUrl &url, UserScript::InjectionTime injectionTime, bool isSubFrame)
 {
-	const QStringList scriptNames(AddonsManager::getUserScripts());
+	const QList<UserScript*> matchingScripts(AddonsManager::getUserScriptsForUrl(url));
 	QList<UserScript*> scripts;
 
-	for (int i = 0 ; i < scriptNames.count(); ++i)
+	for (int i = 0 ; i < matchingScripts.count(); ++i)
 	{
-		UserScript *script(AddonsManager::getUserScript(scriptNames.at(i)));
+		UserScript *script(matchingScripts.at(i));
 
-		if (script->isEnabled() && (injectionTime == AnyTime || script->getInjectionTime() == injectionTime) && (!isSubFrame || script->shouldRunOnSubFrames()) && script->isEnabledForUrl(url))
+		if ((injectionTime == AnyTime || script->getInjectionTime() == injectionTime) && (!isSubFrame || script->shouldRunOnSubFrames()))
 		{
 			scripts.append(script);
 		}
@@ -321,68 +280,6 @@ Addon::AddonType UserScript::getType() const
 	return Addon::UserScriptType;
 }
 
-bool UserScript::isEnabledForUrl(const QUrl &url)
-{
-	if (url.scheme() != QLatin1String("http") && url.scheme() != QLatin1String("https") && url.scheme() != QLatin1String("file") && url.scheme() != QLatin1String("ftp") && url.scheme() != QLatin1String("about"))
-	{
-		return false;
-	}
-
-	bool isEnabled(!(m_includeRules.length() > 0 || m_matchRules.length() > 0));
-
-	if (checkUrl(url, m_matchRules))
-	{
-		isEnabled = true;
-	}
-
-	if (!isEnabled && checkUrl(url, m_includeRules))
-	{
-		isEnabled = true;
-	}
-
-	if (isEnabled && checkUrl(url, m_excludeRules))
-	{
-		isEnabled = false;
-	}
-
-	return isEnabled;
-}
-
-bool UserScript::checkUrl(const QUrl &url, const QStringList &rules) const
-{
-	for (int i = 0; i < rules.length(); ++i)
-	{
-		QString rule(rules[i]);
-
-		if (rule.startsWith(QLatin1Char('/')) && rule.endsWith(QLatin1Char('/')))
-		{
-			return QRegularExpression(rule.mid(1, rule.length() - 2)).match(url.url()).hasMatch();
-		}
-
-		if (rule.contains(QLatin1String(".tld"), Qt::CaseInsensitive))
-		{
-			rule.replace(QLatin1String(".tld"), url.topLevelDomain(), Qt::CaseInsensitive);
-		}
-
-		bool useExactMatch(true);
-
-		if (rule.endsWith(QLatin1Char('*')))
-		{
-			useExactMatch = false;
-			rule = rule.left(rule.length() - 1);
-		}
-
-		const QString result(checkUrlSubString(rule, url.url(), QString()));
-
-		if (!result.isEmpty() && ((useExactMatch && url.url() == result) || (!useExactMatch && url.url().startsWith(result))))
-		{
-			return true;
-		}
-	}
-
-	return false;
-}
-
 bool UserScript::shouldRunOnSubFrames() const
 {
 	return m_shouldRunOnSubFrames;
@@ -55,16 +55,11 @@ public:
 	static QList<UserScript*> getUserScriptsForUrl(const QUrl &url, InjectionTime injectionTime = AnyTime, bool isSubFrame = false);
 	InjectionTime getInjectionTime() const;
 	AddonType getType() const override;
-	bool isEnabledForUrl(const QUrl &url);
 	bool shouldRunOnSubFrames() const;
 
 public slots:
 	void reload();
 
-protected:
-	QString checkUrlSubString(const QString &rule, const QString &urlSubString, QString generatedUrl, int position = 0) const;
-	bool checkUrl(const QUrl &url, const QStringList &rules) const;
-
 private:
 	QString m_path;
 	QString m_source;
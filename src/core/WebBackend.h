@@ -69,7 +69,7 @@ public:
 	virtual QList<SpellCheckManager::DictionaryInformation> getDictionaries() const;
 	AddonType getType() const override;
 	virtual BackendCapabilities getCapabilities() const;
-	virtual bool requestThumbnail(const QUrl &url, const QSize &size) = 0;
+	virtual bool requestThumbnail(const QUrl &url, const QSize &size, int priority = 0) = 0;
 
 signals:
 	void thumbnailAvailable(const QUrl &url, const QPixmap &thumbnail, const QString &title);
@@ -22,7 +22,6 @@
 #include "QtWebEngineWebBackend.h"
 #include "QtWebEngineWebWidget.h"
 #include "../../../../core/Console.h"
-#include "../../../../core/ContentBlockingManager.h"
 #include "../../../../core/ThemesManager.h"
 #include "../../../../core/UserScript.h"
 #include "../../../../core/Utils.h"
@@ -61,88 +60,82 @@ void QtWebEnginePage::pageLoadFinished()
 {
 	m_ignoreJavaScriptPopups = false;
 
-	toHtml([&](const QString &result)
+	if (m_widget)
 	{
-		if (m_widget)
+		const QStringList blockedRequests(qobject_cast<QtWebEngineWebBackend*>(m_widget->getBackend())->getBlockedElements(url().host()));
+
+		if (!blockedRequests.isEmpty())
 		{
-			const QVector<int> profiles(ContentBlockingManager::getProfileList(m_widget->getOption(SettingsManager::ContentBlocking_ProfilesOption, url()).toStringList()));
+			QFile file(QLatin1String(":/modules/backends/web/qtwebengine/resources/hideBlockedRequests.js"));
 
-			if (!profiles.isEmpty() && ContentBlockingManager::getCosmeticFiltersMode() != ContentBlockingManager::NoFiltersMode)
+			if (file.open(QIODevice::ReadOnly))
 			{
-				const ContentBlockingManager::CosmeticFiltersMode mode(ContentBlockingManager::checkUrl(profiles, url(), url(), NetworkManager::OtherType).comesticFiltersMode);
-				QStringList styleSheetBlackList;
-				QStringList styleSheetWhiteList;
-
-				if (mode != ContentBlockingManager::NoFiltersMode)
-				{
-					if (mode != ContentBlockingManager::DomainOnlyFiltersMode)
-					{
-						styleSheetBlackList = ContentBlockingManager::getStyleSheet(profiles);
-					}
-
-					const QStringList domainList(ContentBlockingManager::createSubdomainList(url().host()));
-
-					for (int i = 0; i < domainList.count(); ++i)
-					{
-						styleSheetBlackList += ContentBlockingManager::getStyleSheetBlackList(domainList.at(i), profiles);
-						styleSheetWhiteList += ContentBlockingManager::getStyleSheetWhiteList(domainList.at(i), profiles);
-					}
-				}
-
-				if (!styleSheetBlackList.isEmpty() || !styleSheetWhiteList.isEmpty())
-				{
-					QFile file(QLatin1String(":/modules/backends/web/qtwebengine/resources/hideElements.js"));
-
-					if (file.open(QIODevice::ReadOnly))
-					{
-						runJavaScript(QString(file.readAll()).arg(createJavaScriptList(styleSheetWhiteList)).arg(createJavaScriptList(styleSheetBlackList)));
-
-						file.close();
-					}
-				}
-			}
+				runJavaScript(QString(file.readAll()).arg(createJavaScriptList(blockedRequests)));
 
-			const QStringList blockedRequests(qobject_cast<QtWebEngineWebBackend*>(m_widget->getBackend())->getBlockedElements(url().host()));
+				file.close();
+			}
+		}
+	}
 
-			if (!blockedRequests.isEmpty())
-			{
-				QFile file(QLatin1String(":/modules/backends/web/qtwebengine/resources/hideBlockedRequests.js"));
+#if QT_VERSION >= 0x050700
+	runJavaScript(QLatin1String("document.contentType"), QWebEngineScript::ApplicationWorld, [&](const QVariant &result)
+	{
+		updateViewingMedia(result.toString());
+	});
+#else
+	if (settings()->testAttribute(QWebEngineSettings::JavascriptEnabled))
+	{
+		runJavaScript(QLatin1String("document.contentType"), [&](const QVariant &result)
+		{
+			updateViewingMedia(result.toString());
+		});
+	}
+	else
+	{
+		toHtml([&](const QString &result)
+		{
+			QString string(url().toString());
+			string.truncate(1000);
 
-				if (file.open(QIODevice::ReadOnly))
-				{
-					runJavaScript(QString(file.readAll()).arg(createJavaScriptList(blockedRequests)));
+			const QRegularExpressionMatch match(QRegularExpression(QStringLiteral(">(<img style=\"-webkit-user-select: none;(?: cursor: zoom-in;)?\"|<video controls=\"\" autoplay=\"\" name=\"media\"><source) src=\"%1").arg(QRegularExpression::escape(string))).match(result));
 
-					file.close();
-				}
+			if (match.hasMatch())
+			{
+				updateViewingMedia(match.captured().startsWith(QLatin1String("><img")) ? QLatin1String("image/") : QLatin1String("video/"));
 			}
-		}
-
-		QString string(url().toString());
-		string.truncate(1000);
+			else
+			{
+				updateViewingMedia(QString());
+			}
+		});
+	}
+#endif
+}
 
-		const QRegularExpressionMatch match(QRegularExpression(QStringLiteral(">(<img style=\"-webkit-user-select: none;(?: cursor: zoom-in;)?\"|<video controls=\"\" autoplay=\"\" name=\"media\"><source) src=\"%1").arg(QRegularExpression::escape(string))).match(result));
-		const bool isViewingMedia(match.hasMatch());
+void QtWebEnginePage::updateViewingMedia(const QString &mimeType)
+{
+	const bool isImage(mimeType.startsWith(QLatin1String("image/")) && mimeType != QLatin1String("image/svg+xml"));
+	const bool isViewingMedia(isImage || mimeType.startsWith(QLatin1String("video/")) || mimeType.startsWith(QLatin1String("audio/")));
 
-		if (isViewingMedia && match.captured().startsWith(QLatin1String("><img")))
-		{
-			settings()->setAttribute(QWebEngineSettings::AutoLoadImages, true);
-			settings()->setAttribute(QWebEngineSettings::JavascriptEnabled, true);
+	if (isImage)
+	{
+		settings()->setAttribute(QWebEngineSettings::AutoLoadImages, true);
+		settings()->setAttribute(QWebEngineSettings::JavascriptEnabled, true);
 
-			QFile file(QLatin1String(":/modules/backends/web/qtwebengine/resources/imageViewer.js"));
-			file.open(QIODevice::ReadOnly);
+		QFile file(QLatin1String(":/modules/backends/web/qtwebengine/resources/imageViewer.js"));
+		file.open(QIODevice::ReadOnly);
 
-			runJavaScript(file.readAll());
+		runJavaScript(file.readAll());
 
-			file.close();
-		}
+		file.close();
+	}
 
-		if (isViewingMedia != m_isViewingMedia)
-		{
-			m_isViewingMedia = isViewingMedia;
+	if (isViewingMedia != m_isViewingMedia)
+	{
+		m_isViewingMedia = isViewingMedia;
 
-			emit viewingMediaChanged(m_isViewingMedia);
-		}
-	});
+		emit viewingMediaChanged(m_isViewingMedia);
+	}
 }
 
 void QtWebEnginePage::removePopup(const QUrl &url)
@@ -371,6 +364,19 @@ bool QtWebEnginePage::acceptNavigationRequest(const QUrl &url, QWebEnginePage::N
 			this->scripts().insert(script);
 		}
 
+		if (m_widget)
+		{
+			QtWebEngineWebBackend *backend(qobject_cast<QtWebEngineWebBackend*>(m_widget->getBackend()));
+			backend->updateRequestPolicy(url);
+
+			const QWebEngineScript cosmeticFiltersScript(backend->getCosmeticFiltersScript(m_widget->getOption(SettingsManager::ContentBlocking_ProfilesOption, url).toStringList(), url));
+
+			if (!cosmeticFiltersScript.isNull())
+			{
+				this->scripts().insert(cosmeticFiltersScript);
+			}
+		}
+
 		emit aboutToNavigate(url, type);
 	}
 
@@ -42,6 +42,7 @@ public:
 
 protected:
 	void markAsPopup();
+	void updateViewingMedia(const QString &mimeType);
 	void javaScriptAlert(const QUrl &url, const QString &message) override;
 	void javaScriptConsoleMessage(JavaScriptConsoleMessageLevel level, const QString &note, int line, const QString &source) override;
 	QWebEnginePage* createWindow(WebWindowType type) override;
@@ -21,7 +21,6 @@
 #include "QtWebEngineUrlRequestInterceptor.h"
 #include "../../../../core/Console.h"
 #include "../../../../core/ContentBlockingManager.h"
-#include "../../../../core/NetworkManagerFactory.h"
 #include "../../../../core/SettingsManager.h"
 
 #include <QtCore/QCoreApplication>
@@ -31,34 +30,186 @@ namespace Otter
 {
 
 QtWebEngineUrlRequestInterceptor::QtWebEngineUrlRequestInterceptor(QObject *parent) : QWebEngineUrlRequestInterceptor(parent),
-	m_areImagesEnabled(SettingsManager::getValue(SettingsManager::Permissions_EnableImagesOption).toString() != QLatin1String("disabled"))
+	m_snapshot(nullptr),
+	m_blockedRequests(nullptr),
+	m_pendingPolicies(nullptr),
+	m_snapshotReaders(0)
 {
-	QTimer::singleShot(1800000, this, SLOT(clearContentBlockingInformation()));
+	clearContentBlockingInformation();
 
 	connect(SettingsManager::getInstance(), SIGNAL(valueChanged(int,QVariant)), this, SLOT(optionChanged(int)));
 	connect(SettingsManager::getInstance(), SIGNAL(valueChanged(int,QVariant,QUrl)), this, SLOT(optionChanged(int)));
 }
 
-void QtWebEngineUrlRequestInterceptor::optionChanged(int identifier)
+QtWebEngineUrlRequestInterceptor::~QtWebEngineUrlRequestInterceptor()
 {
-	if (identifier == SettingsManager::Permissions_EnableImagesOption)
+	BlockedRequest *blockedRequest(m_blockedRequests.fetchAndStoreAcquire(nullptr));
+
+	while (blockedRequest)
 	{
-		m_areImagesEnabled = (SettingsManager::getValue(SettingsManager::Permissions_EnableImagesOption).toString() != QLatin1String("disabled"));
+		BlockedRequest *nextBlockedRequest(blockedRequest->next);
+
+		delete blockedRequest;
+
+		blockedRequest = nextBlockedRequest;
 	}
-	else if (identifier == SettingsManager::ContentBlocking_ProfilesOption)
+
+	PendingPolicy *pendingPolicy(m_pendingPolicies.fetchAndStoreAcquire(nullptr));
+
+	while (pendingPolicy)
 	{
-		clearContentBlockingInformation();
+		PendingPolicy *nextPendingPolicy(pendingPolicy->next);
+
+		delete pendingPolicy;
+
+		pendingPolicy = nextPendingPolicy;
+	}
+
+	qDeleteAll(m_retiredSnapshots);
+
+	delete m_snapshot.loadAcquire();
+}
+
+void QtWebEngineUrlRequestInterceptor::optionChanged(int identifier)
+{
+	switch (identifier)
+	{
+		case SettingsManager::Network_DoNotTrackPolicyOption:
+		case SettingsManager::Permissions_EnableImagesOption:
+			{
+				PolicySnapshot *snapshot(new PolicySnapshot(*m_snapshot.loadAcquire()));
+				snapshot->doNotTrackPolicy = NetworkManagerFactory::getDoNotTrackPolicy();
+				snapshot->areImagesEnabled = (SettingsManager::getValue(SettingsManager::Permissions_EnableImagesOption).toString() != QLatin1String("disabled"));
+
+				publishSnapshot(snapshot);
+			}
+
+			break;
+		case SettingsManager::ContentBlocking_EnableContentBlockingOption:
+		case SettingsManager::ContentBlocking_ProfilesOption:
+			clearContentBlockingInformation();
+
+			break;
+		default:
+			break;
 	}
 }
 
 void QtWebEngineUrlRequestInterceptor::clearContentBlockingInformation()
 {
+	PolicySnapshot *snapshot(new PolicySnapshot());
+	snapshot->defaultProfiles = getContentBlockingProfiles(QUrl());
+	snapshot->doNotTrackPolicy = NetworkManagerFactory::getDoNotTrackPolicy();
+	snapshot->areImagesEnabled = (SettingsManager::getValue(SettingsManager::Permissions_EnableImagesOption).toString() != QLatin1String("disabled"));
+
+	publishSnapshot(snapshot);
+
 	m_blockedElements.clear();
-	m_contentBlockingProfiles.clear();
 
 	QTimer::singleShot(1800000, this, SLOT(clearContentBlockingInformation()));
 }
 
+void QtWebEngineUrlRequestInterceptor::updatePolicy(const QUrl &url)
+{
+	const QString host(url.host());
+	const PolicySnapshot *currentSnapshot(m_snapshot.loadAcquire());
+	const QVector<int> profiles(getContentBlockingProfiles(url));
+
+	if (currentSnapshot->hostProfiles.contains(host) && currentSnapshot->hostProfiles.value(host) == profiles)
+	{
+		return;
+	}
+
+	PolicySnapshot *snapshot(new PolicySnapshot(*currentSnapshot));
+	snapshot->hostProfiles[host] = profiles;
+
+	publishSnapshot(snapshot);
+}
+
+void QtWebEngineUrlRequestInterceptor::publishSnapshot(PolicySnapshot *snapshot)
+{
+	const PolicySnapshot *previousSnapshot(m_snapshot.fetchAndStoreOrdered(snapshot));
+
+	if (previousSnapshot)
+	{
+		m_retiredSnapshots.append(previousSnapshot);
+	}
+
+	releaseSnapshots();
+}
+
+void QtWebEngineUrlRequestInterceptor::releaseSnapshots()
+{
+	if (!m_retiredSnapshots.isEmpty() && m_snapshotReaders.loadAcquire() == 0)
+	{
+		qDeleteAll(m_retiredSnapshots);
+
+		m_retiredSnapshots.clear();
+	}
+}
+
+void QtWebEngineUrlRequestInterceptor::handleBlockedRequests()
+{
+	QVector<BlockedRequest*> blockedRequests;
+	BlockedRequest *blockedRequest(m_blockedRequests.fetchAndStoreAcquire(nullptr));
+
+	while (blockedRequest)
+	{
+		blockedRequests.append(blockedRequest);
+
+		blockedRequest = blockedRequest->next;
+	}
+
+	for (int i = (blockedRequests.count() - 1); i >= 0; --i)
+	{
+		const BlockedRequest *request(blockedRequests.at(i));
+
+		if (request->shouldStoreUrl && !m_blockedElements.value(request->host).contains(request->url))
+		{
+			m_blockedElements[request->host].append(request->url);
+		}
+
+		Console::addMessage(QCoreApplication::translate("main", "Request blocked with rule: %1").arg(request->rule), Console::NetworkCategory, Console::LogLevel, request->url, -1);
+
+		delete request;
+	}
+
+	releaseSnapshots();
+}
+
+void QtWebEngineUrlRequestInterceptor::handlePendingPolicies()
+{
+	const PolicySnapshot *currentSnapshot(m_snapshot.loadAcquire());
+	PolicySnapshot *snapshot(nullptr);
+	PendingPolicy *pendingPolicy(m_pendingPolicies.fetchAndStoreAcquire(nullptr));
+
+	while (pendingPolicy)
+	{
+		const QString host(pendingPolicy->url.host());
+
+		if (!currentSnapshot->hostProfiles.contains(host) && (!snapshot || !snapshot->hostProfiles.contains(host)))
+		{
+			if (!snapshot)
+			{
+				snapshot = new PolicySnapshot(*currentSnapshot);
+			}
+
+			snapshot->hostProfiles[host] = getContentBlockingProfiles(pendingPolicy->url);
+		}
+
+		PendingPolicy *nextPendingPolicy(pendingPolicy->next);
+
+		delete pendingPolicy;
+
+		pendingPolicy = nextPendingPolicy;
+	}
+
+	if (snapshot)
+	{
+		publishSnapshot(snapshot);
+	}
+}
+
 QStringList QtWebEngineUrlRequestInterceptor::getBlockedElements(const QString &domain) const
 {
 	return m_blockedElements.value(domain);
@@ -66,31 +217,48 @@ QStringList QtWebEngineUrlRequestInterceptor::getBlockedElements(const QString &
 
 void QtWebEngineUrlRequestInterceptor::interceptRequest(QWebEngineUrlRequestInfo &request)
 {
-	if (!m_areImagesEnabled && request.resourceType() == QWebEngineUrlRequestInfo::ResourceTypeImage)
-	{
-		request.block(true);
+	const QString host(request.firstPartyUrl().host());
 
-		return;
-	}
+	m_snapshotReaders.ref();
+
+	const PolicySnapshot *snapshot(m_snapshot.loadAcquire());
+	const bool hasHostProfiles(snapshot->hostProfiles.contains(host));
+	const QVector<int> contentBlockingProfiles(hasHostProfiles ? snapshot->hostProfiles.value(host) : snapshot->defaultProfiles);
+	const NetworkManagerFactory::DoNotTrackPolicy doNotTrackPolicy(snapshot->doNotTrackPolicy);
+	const bool areImagesEnabled(snapshot->areImagesEnabled);
 
-	if (!m_contentBlockingProfiles.contains(request.firstPartyUrl().host()))
+	m_snapshotReaders.deref();
+
+	if (!hasHostProfiles)
 	{
-		if (SettingsManager::getValue(SettingsManager::ContentBlocking_EnableContentBlockingOption, request.firstPartyUrl()).toBool())
+		PendingPolicy *pendingPolicy(new PendingPolicy());
+		pendingPolicy->url = request.firstPartyUrl();
+
+		PendingPolicy *previousPendingPolicy(nullptr);
+
+		do
 		{
-			m_contentBlockingProfiles[request.firstPartyUrl().host()] = ContentBlockingManager::getProfileList(SettingsManager::getValue(SettingsManager::ContentBlocking_ProfilesOption, request.firstPartyUrl()).toStringList());
+			previousPendingPolicy = m_pendingPolicies.loadAcquire();
+
+			pendingPolicy->next = previousPendingPolicy;
 		}
-		else
+		while (!m_pendingPolicies.testAndSetRelease(previousPendingPolicy, pendingPolicy));
+
+		if (!previousPendingPolicy)
 		{
-			m_contentBlockingProfiles[request.firstPartyUrl().host()] = QVector<int>();
+			QMetaObject::invokeMethod(this, "handlePendingPolicies", Qt::QueuedConnection);
 		}
 	}
 
-	const QVector<int> contentBlockingProfiles(m_contentBlockingProfiles.value(request.firstPartyUrl().host()));
+	if (!areImagesEnabled && request.resourceType() == QWebEngineUrlRequestInfo::ResourceTypeImage)
+	{
+		request.block(true);
+
+		return;
+	}
 
 	if (contentBlockingProfiles.isEmpty())
 	{
-		const NetworkManagerFactory::DoNotTrackPolicy doNotTrackPolicy(NetworkManagerFactory::getDoNotTrackPolicy());
-
 		if (doNotTrackPolicy != NetworkManagerFactory::SkipTrackPolicy)
 		{
 			request.setHttpHeader(QStringLiteral("DNT").toLatin1(), ((doNotTrackPolicy == NetworkManagerFactory::DoNotAllowToTrackPolicy) ? QStringLiteral("1") : QStringLiteral("0")).toLatin1());
@@ -150,15 +318,39 @@ void QtWebEngineUrlRequestInterceptor::interceptRequest(QWebEngineUrlRequestInfo
 
 	if (result.isBlocked)
 	{
-		if (storeBlockedUrl && !m_blockedElements.value(request.firstPartyUrl().host()).contains(request.requestUrl().url()))
+		BlockedRequest *blockedRequest(new BlockedRequest());
+		blockedRequest->host = host;
+		blockedRequest->url = request.requestUrl().url();
+		blockedRequest->rule = result.rule;
+		blockedRequest->shouldStoreUrl = storeBlockedUrl;
+
+		BlockedRequest *previousBlockedRequest(nullptr);
+
+		do
 		{
-			m_blockedElements[request.firstPartyUrl().host()].append(request.requestUrl().url());
+			previousBlockedRequest = m_blockedRequests.loadAcquire();
+
+			blockedRequest->next = previousBlockedRequest;
 		}
+		while (!m_blockedRequests.testAndSetRelease(previousBlockedRequest, blockedRequest));
 
-		Console::addMessage(QCoreApplication::translate("main", "Request blocked with rule: %1").arg(result.rule), Console::NetworkCategory, Console::LogLevel, request.requestUrl().toString(), -1);
+		if (!previousBlockedRequest)
+		{
+			QMetaObject::invokeMethod(this, "handleBlockedRequests", Qt::QueuedConnection);
+		}
 
 		request.block(true);
 	}
 }
 
+QVector<int> QtWebEngineUrlRequestInterceptor::getContentBlockingProfiles(const QUrl &url)
+{
+	if (!SettingsManager::getValue(SettingsManager::ContentBlocking_EnableContentBlockingOption, url).toBool())
+	{
+		return QVector<int>();
+	}
+
+	return ContentBlockingManager::getProfileList(SettingsManager::getValue(SettingsManager::ContentBlocking_ProfilesOption, url).toStringList());
+}
+
 }
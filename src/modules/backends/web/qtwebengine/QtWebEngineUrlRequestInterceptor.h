@@ -21,7 +21,12 @@
 #ifndef OTTER_QTWEBENGINEURLREQUESTINTERCEPTOR_H
 #define OTTER_QTWEBENGINEURLREQUESTINTERCEPTOR_H
 
+#include "../../../../core/NetworkManagerFactory.h"
+
+#include <QtCore/QAtomicInt>
+#include <QtCore/QAtomicPointer>
 #include <QtCore/QMap>
+#include <QtCore/QUrl>
 #include <QtCore/QVector>
 #include <QtWebEngineCore/QWebEngineUrlRequestInterceptor>
 
@@ -34,18 +39,55 @@ class QtWebEngineUrlRequestInterceptor : public QWebEngineUrlRequestInterceptor
 
 public:
 	explicit QtWebEngineUrlRequestInterceptor(QObject *parent = nullptr);
+	~QtWebEngineUrlRequestInterceptor();
 
 	QStringList getBlockedElements(const QString &domain) const;
 	void interceptRequest(QWebEngineUrlRequestInfo &request) override;
 
+public slots:
+	void updatePolicy(const QUrl &url);
+
+protected:
+	struct PolicySnapshot
+	{
+		QHash<QString, QVector<int> > hostProfiles;
+		QVector<int> defaultProfiles;
+		NetworkManagerFactory::DoNotTrackPolicy doNotTrackPolicy = NetworkManagerFactory::SkipTrackPolicy;
+		bool areImagesEnabled = true;
+	};
+
+	struct BlockedRequest
+	{
+		QString host;
+		QString url;
+		QString rule;
+		BlockedRequest *next = nullptr;
+		bool shouldStoreUrl = true;
+	};
+
+	struct PendingPolicy
+	{
+		QUrl url;
+		PendingPolicy *next = nullptr;
+	};
+
+	void publishSnapshot(PolicySnapshot *snapshot);
+	void releaseSnapshots();
+	static QVector<int> getContentBlockingProfiles(const QUrl &url);
+
 protected slots:
 	void optionChanged(int identifier);
 	void clearContentBlockingInformation();
+	void handleBlockedRequests();
+	void handlePendingPolicies();
 
 private:
 	QMap<QString, QStringList> m_blockedElements;
-	QMap<QString, QVector<int> > m_contentBlockingProfiles;
-	bool m_areImagesEnabled;
+	QVector<const PolicySnapshot*> m_retiredSnapshots;
+	QAtomicPointer<const PolicySnapshot> m_snapshot;
+	QAtomicPointer<BlockedRequest> m_blockedRequests;
+	QAtomicPointer<PendingPolicy> m_pendingPolicies;
+	QAtomicInt m_snapshotReaders;
 };
 
 }
@@ -22,6 +22,7 @@
 #include "QtWebEngineTransfer.h"
 #include "QtWebEngineUrlRequestInterceptor.h"
 #include "QtWebEngineWebWidget.h"
+#include "../../../../core/ContentBlockingManager.h"
 #include "../../../../core/HandlersManager.h"
 #include "../../../../core/NetworkManagerFactory.h"
 #include "../../../../core/SettingsManager.h"
@@ -31,6 +32,7 @@
 
 #include <QtCore/QCoreApplication>
 #include <QtCore/QDir>
+#include <QtCore/QFile>
 #include <QtCore/QRegularExpression>
 #include <QtWebEngineWidgets/QWebEngineProfile>
 #include <QtWebEngineWidgets/QWebEngineSettings>
@@ -44,6 +46,8 @@ QMap<QString, QString> QtWebEngineWebBackend::m_userAgents;
 
 QtWebEngineWebBackend::QtWebEngineWebBackend(QObject *parent) : WebBackend(parent),
 	m_requestInterceptor(nullptr),
+	m_cosmeticFiltersScripts(8388608),
+	m_cosmeticFiltersGeneration(0),
 	m_isInitialized(false)
 {
 	const QString userAgent(QWebEngineProfile::defaultProfile()->httpUserAgent());
@@ -103,6 +107,14 @@ void QtWebEngineWebBackend::optionChanged(int identifier)
 	}
 }
 
+void QtWebEngineWebBackend::updateRequestPolicy(const QUrl &url)
+{
+	if (m_requestInterceptor)
+	{
+		m_requestInterceptor->updatePolicy(url);
+	}
+}
+
 void QtWebEngineWebBackend::downloadFile(QWebEngineDownloadItem *item)
 {
 #if QT_VERSION >= 0x050700
@@ -304,6 +316,64 @@ QStringList QtWebEngineWebBackend::getBlockedElements(const QString &domain) con
 	return (m_requestInterceptor ? m_requestInterceptor->getBlockedElements(domain) : QStringList());
 }
 
+QWebEngineScript QtWebEngineWebBackend::getCosmeticFiltersScript(const QStringList &profiles, const QUrl &url)
+{
+	const QVector<int> profileList(ContentBlockingManager::getProfileList(profiles));
+
+	if (profileList.isEmpty() || ContentBlockingManager::getCosmeticFiltersMode() == ContentBlockingManager::NoFiltersMode)
+	{
+		return QWebEngineScript();
+	}
+
+	const ContentBlockingManager::CosmeticFiltersMode mode(ContentBlockingManager::checkUrl(profileList, url, url, NetworkManager::OtherType).comesticFiltersMode);
+
+	if (mode == ContentBlockingManager::NoFiltersMode)
+	{
+		return QWebEngineScript();
+	}
+
+	const quint64 generation(ContentBlockingManager::getCachesGeneration());
+
+	if (generation != m_cosmeticFiltersGeneration)
+	{
+		m_cosmeticFiltersScripts.clear();
+		m_cosmeticFiltersGeneration = generation;
+	}
+
+	const QString key(QString::number(mode) + QLatin1Char(' ') + profiles.join(QLatin1Char(',')) + QLatin1Char(' ') + url.host());
+	const QWebEngineScript *cachedScript(m_cosmeticFiltersScripts.object(key));
+
+	if (cachedScript)
+	{
+		return *cachedScript;
+	}
+
+	const ContentBlockingManager::CosmeticFilters cosmeticFilters(ContentBlockingManager::getCosmeticFilters(profileList, url));
+	QWebEngineScript script;
+
+	if (!cosmeticFilters.genericStyleSheet.isEmpty() || !cosmeticFilters.domainStyleSheet.isEmpty())
+	{
+		QFile file(QLatin1String(":/modules/backends/web/qtwebengine/resources/hideElements.js"));
+
+		if (file.open(QIODevice::ReadOnly))
+		{
+			QString styleSheet(cosmeticFilters.genericStyleSheet + cosmeticFilters.domainStyleSheet);
+			styleSheet.replace(QLatin1Char('\\'), QLatin1String("\\\\")).replace(QLatin1Char('\''), QLatin1String("\\'")).replace(QLatin1Char('\n'), QLatin1String("\\n")).replace(QLatin1Char('\r'), QLatin1String("\\r")).replace(QChar(0x2028), QLatin1String("\\u2028")).replace(QChar(0x2029), QLatin1String("\\u2029"));
+
+			script.setName(QLatin1String("cosmeticFilters"));
+			script.setSourceCode(QString(file.readAll()).arg(styleSheet));
+			script.setInjectionPoint(QWebEngineScript::DocumentCreation);
+			script.setRunsOnSubFrames(false);
+
+			file.close();
+		}
+	}
+
+	m_cosmeticFiltersScripts.insert(key, new QWebEngineScript(script), qMax(1, script.sourceCode().size()));
+
+	return script;
+}
+
 QUrl QtWebEngineWebBackend::getHomePage() const
 {
 	return QUrl(QLatin1String("http://otter-browser.org/"));
@@ -319,10 +389,11 @@ WebBackend::BackendCapabilities QtWebEngineWebBackend::getCapabilities() const
 	return (UserScriptsCapability | GlobalCookiesPolicyCapability | GlobalContentFilteringCapability | GlobalDoNotTrackCapability | GlobalProxyCapability | GlobalReferrerCapability | GlobalUserAgentCapability);
 }
 
-bool QtWebEngineWebBackend::requestThumbnail(const QUrl &url, const QSize &size)
+bool QtWebEngineWebBackend::requestThumbnail(const QUrl &url, const QSize &size, int priority)
 {
 	Q_UNUSED(url)
 	Q_UNUSED(size)
+	Q_UNUSED(priority)
 
 	return false;
 }
@@ -23,7 +23,9 @@
 
 #include "../../../../core/WebBackend.h"
 
+#include <QtCore/QCache>
 #include <QtWebEngineWidgets/QWebEngineDownloadItem>
+#include <QtWebEngineWidgets/QWebEngineScript>
 
 namespace Otter
 {
@@ -38,6 +40,8 @@ class QtWebEngineWebBackend : public WebBackend
 public:
 	explicit QtWebEngineWebBackend(QObject *parent = nullptr);
 
+	void updateRequestPolicy(const QUrl &url);
+
 	WebWidget* createWidget(bool isPrivate = false, ContentsWidget *parent = nullptr) override;
 	QString getTitle() const override;
 	QString getDescription() const override;
@@ -46,10 +50,11 @@ public:
 	QString getSslVersion() const override;
 	QString getUserAgent(const QString &pattern = QString()) const override;
 	QStringList getBlockedElements(const QString &domain) const;
+	QWebEngineScript getCosmeticFiltersScript(const QStringList &profiles, const QUrl &url);
 	QUrl getHomePage() const override;
 	QIcon getIcon() const override;
 	WebBackend::BackendCapabilities getCapabilities() const override;
-	bool requestThumbnail(const QUrl &url, const QSize &size) override;
+	bool requestThumbnail(const QUrl &url, const QSize &size, int priority = 0) override;
 
 protected slots:
 	void optionChanged(int identifier);
@@ -57,6 +62,8 @@ protected slots:
 
 private:
 	QtWebEngineUrlRequestInterceptor *m_requestInterceptor;
+	QCache<QString, QWebEngineScript> m_cosmeticFiltersScripts;
+	quint64 m_cosmeticFiltersGeneration;
 	bool m_isInitialized;
 
 	static QString m_engineVersion;
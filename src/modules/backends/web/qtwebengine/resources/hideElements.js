@@ -1,41 +1,24 @@
-var whitelist = [%1];
-var blacklist = [%2];
-var ignoredElements = [];
-
-for (var i = 0; i < whitelist.length; ++i)
+(function()
 {
-    try
-    {
-        ignoredElements = ignoredElements.concat(Array.from(document.querySelectorAll(whitelist[i])));
-    }
-    catch (e)
-    {
-        console.error("Invalid selector: " + whitelist[i]);
+	var style = document.createElement('style');
+	style.type = 'text/css';
+	style.textContent = '%1';
 
-        continue;
-    }
-}
+	if (document.documentElement)
+	{
+		(document.head || document.documentElement).appendChild(style);
 
-for (var i = 0; i < blacklist.length; ++i)
-{
-    var elements = [];
-     
-    try
-    {
-        elements = document.querySelectorAll(blacklist[i]);
-    }
-    catch (e)
-    {
-        console.error("Invalid selector: " + blacklist[i]);
+		return;
+	}
+
+	var observer = new MutationObserver(function()
+	{
+		if (document.documentElement)
+		{
+			observer.disconnect();
 
-        continue;
-    }
-     
-    for (var j = 0; j < elements.length; ++j)
-    {
-        if (ignoredElements.indexOf(elements[j]) < 0)
-        {
-            elements[j].style.cssText = "display:none !important";
-        }
-    }
-}
+			(document.head || document.documentElement).appendChild(style);
+		}
+	});
+	observer.observe(document, {childList: true});
+})();
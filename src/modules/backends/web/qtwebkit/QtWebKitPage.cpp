@@ -62,10 +62,9 @@ void QtWebKitFrame::runUserScripts(const QUrl &url) const
 	}
 }
 
-void QtWebKitFrame::applyContentBlockingRules(const QStringList &rules, bool remove)
+void QtWebKitFrame::applyContentBlockingRules(const QStringList &rules)
 {
 	const QWebElement document(m_frame->documentElement());
-	const QString value(remove ? QLatin1String("none !important") : QString());
 
 	for (int i = 0; i < rules.count(); ++i)
 	{
@@ -77,7 +76,7 @@ void QtWebKitFrame::applyContentBlockingRules(const QStringList &rules, bool rem
 
 			if (!element.isNull())
 			{
-				element.setStyleProperty(QLatin1String("display"), value);
+				element.setStyleProperty(QLatin1String("display"), QLatin1String("none !important"));
 			}
 		}
 	}
@@ -111,27 +110,10 @@ void QtWebKitFrame::handleLoadFinished()
 
 	const QUrl url(m_widget->getUrl());
 	const QVector<int> profiles(ContentBlockingManager::getProfileList(m_widget->getOption(SettingsManager::ContentBlocking_ProfilesOption, url).toStringList()));
+	const ContentBlockingManager::CosmeticFilters cosmeticFilters(ContentBlockingManager::getCosmeticFilters(profiles, url));
 
-	if (!profiles.isEmpty() && ContentBlockingManager::getCosmeticFiltersMode() != ContentBlockingManager::NoFiltersMode)
-	{
-		const ContentBlockingManager::CosmeticFiltersMode mode(ContentBlockingManager::checkUrl(profiles, url, url, NetworkManager::OtherType).comesticFiltersMode);
-
-		if (mode != ContentBlockingManager::NoFiltersMode)
-		{
-			if (mode != ContentBlockingManager::DomainOnlyFiltersMode)
-			{
-				applyContentBlockingRules(ContentBlockingManager::getStyleSheet(profiles), true);
-			}
-
-			const QStringList domainList(ContentBlockingManager::createSubdomainList(url.host()));
-
-			for (int i = 0; i < domainList.count(); ++i)
-			{
-				applyContentBlockingRules(ContentBlockingManager::getStyleSheetBlackList(domainList.at(i), profiles), true);
-				applyContentBlockingRules(ContentBlockingManager::getStyleSheetWhiteList(domainList.at(i), profiles), false);
-			}
-		}
-	}
+	applyContentBlockingRules(cosmeticFilters.genericRules);
+	applyContentBlockingRules(cosmeticFilters.domainRules);
 
 	const QStringList blockedRequests(m_widget->getBlockedElements());
 
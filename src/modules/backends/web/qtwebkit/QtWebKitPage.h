@@ -44,7 +44,7 @@ public:
 	void runUserScripts(const QUrl &url) const;
 
 protected:
-	void applyContentBlockingRules(const QStringList &rules, bool remove);
+	void applyContentBlockingRules(const QStringList &rules);
 
 protected slots:
 	void handleLoadFinished();
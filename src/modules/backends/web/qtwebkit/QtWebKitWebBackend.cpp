@@ -75,8 +75,37 @@ QtWebKitWebBackend::QtWebKitWebBackend(QObject *parent) : WebBackend(parent),
 QtWebKitWebBackend::~QtWebKitWebBackend()
 {
 	qDeleteAll(m_thumbnailRequests.keys());
+	qDeleteAll(m_thumbnailPages);
 
 	m_thumbnailRequests.clear();
+	m_thumbnailPages.clear();
+}
+
+void QtWebKitWebBackend::timerEvent(QTimerEvent *event)
+{
+	QHash<QtWebKitPage*, ThumbnailRequest>::iterator iterator;
+
+	for (iterator = m_thumbnailRequests.begin(); iterator != m_thumbnailRequests.end(); ++iterator)
+	{
+		if (iterator.value().timer == event->timerId())
+		{
+			QtWebKitPage *page(iterator.key());
+
+			disconnect(page, SIGNAL(loadFinished(bool)), this, SLOT(pageLoaded(bool)));
+
+			page->triggerAction(QWebPage::Stop);
+
+			finishThumbnailRequest(page);
+
+			m_thumbnailPages.removeAll(page);
+
+			page->deleteLater();
+
+			return;
+		}
+	}
+
+	killTimer(event->timerId());
 }
 
 void QtWebKitWebBackend::optionChanged(int identifier)
@@ -138,50 +167,103 @@ void QtWebKitWebBackend::pageLoaded(bool success)
 {
 	QtWebKitPage *page(qobject_cast<QtWebKitPage*>(sender()));
 
-	if (!page)
+	if (!page || !m_thumbnailRequests.contains(page))
+	{
+		return;
+	}
+
+	if (!success)
 	{
+		finishThumbnailRequest(page);
+
 		return;
 	}
 
-	if (success)
+	const QSize size(m_thumbnailRequests[page].size);
+	QPixmap pixmap;
+
+	if (!size.isEmpty())
 	{
-		QPixmap pixmap;
+		QSize contentsSize(page->mainFrame()->contentsSize());
 
-		if (!m_thumbnailRequests[page].second.isEmpty())
+		page->setViewportSize(contentsSize);
+
+		if (contentsSize.width() > 2000)
 		{
-			QSize contentsSize(page->mainFrame()->contentsSize());
+			contentsSize.setWidth(2000);
+		}
 
-			page->setViewportSize(contentsSize);
+		contentsSize.setHeight(size.height() * (qreal(contentsSize.width()) / size.width()));
 
-			if (contentsSize.width() > 2000)
-			{
-				contentsSize.setWidth(2000);
-			}
+		pixmap = QPixmap(contentsSize);
+		pixmap.fill(Qt::white);
 
-			contentsSize.setHeight(m_thumbnailRequests[page].second.height() * (qreal(contentsSize.width()) / m_thumbnailRequests[page].second.width()));
+		QPainter painter(&pixmap);
 
-			pixmap = QPixmap(contentsSize);
-			pixmap.fill(Qt::white);
+		page->mainFrame()->render(&painter, QWebFrame::ContentsLayer, QRegion(QRect(QPoint(0, 0), contentsSize)));
 
-			QPainter painter(&pixmap);
+		painter.end();
 
-			page->mainFrame()->render(&painter, QWebFrame::ContentsLayer, QRegion(QRect(QPoint(0, 0), contentsSize)));
+		pixmap = pixmap.scaled(size, Qt::KeepAspectRatio, Qt::SmoothTransformation);
+	}
+
+	finishThumbnailRequest(page, pixmap, page->mainFrame()->title());
+}
+
+void QtWebKitWebBackend::startThumbnailRequests()
+{
+	while (!m_thumbnailQueue.isEmpty() && m_thumbnailRequests.count() < 3)
+	{
+		QtWebKitPage *page(nullptr);
 
-			painter.end();
+		if (m_thumbnailPages.isEmpty())
+		{
+			page = new QtWebKitPage();
+			page->setParent(this);
+			page->settings()->setAttribute(QWebSettings::JavaEnabled, false);
+			page->settings()->setAttribute(QWebSettings::JavascriptEnabled, false);
+			page->settings()->setAttribute(QWebSettings::PluginsEnabled, false);
 
-			pixmap = pixmap.scaled(m_thumbnailRequests[page].second, Qt::KeepAspectRatio, Qt::SmoothTransformation);
+			connect(page, SIGNAL(loadFinished(bool)), this, SLOT(pageLoaded(bool)));
+		}
+		else
+		{
+			page = m_thumbnailPages.takeLast();
+			page->setViewportSize(QSize());
 		}
 
-		emit thumbnailAvailable(m_thumbnailRequests[page].first, pixmap, page->mainFrame()->title());
+		ThumbnailRequest request(m_thumbnailQueue.takeFirst());
+		request.timer = startTimer(30000);
+
+		m_thumbnailRequests[page] = request;
+
+		page->mainFrame()->setUrl(request.url);
 	}
-	else
+
+	if (m_thumbnailQueue.isEmpty() && m_thumbnailRequests.isEmpty())
 	{
-		emit thumbnailAvailable(m_thumbnailRequests[page].first, QPixmap(), QString());
+		for (int i = 0; i < m_thumbnailPages.count(); ++i)
+		{
+			m_thumbnailPages.at(i)->deleteLater();
+		}
+
+		m_thumbnailPages.clear();
 	}
+}
 
-	m_thumbnailRequests.remove(page);
+void QtWebKitWebBackend::finishThumbnailRequest(QtWebKitPage *page, const QPixmap &thumbnail, const QString &title)
+{
+	const ThumbnailRequest request(m_thumbnailRequests.take(page));
 
-	page->deleteLater();
+	killTimer(request.timer);
+
+	page->setViewportSize(QSize());
+
+	m_thumbnailPages.append(page);
+
+	emit thumbnailAvailable(request.url, thumbnail, title);
+
+	QMetaObject::invokeMethod(this, "startThumbnailRequests", Qt::QueuedConnection);
 }
 
 void QtWebKitWebBackend::setActiveWidget(WebWidget *widget)
@@ -336,19 +418,48 @@ int QtWebKitWebBackend::getOptionIdentifier(QtWebKitWebBackend::OptionIdentifier
 	return -1;
 }
 
-bool QtWebKitWebBackend::requestThumbnail(const QUrl &url, const QSize &size)
+bool QtWebKitWebBackend::requestThumbnail(const QUrl &url, const QSize &size, int priority)
 {
-	QtWebKitPage *page(new QtWebKitPage());
+	QHash<QtWebKitPage*, ThumbnailRequest>::iterator requestsIterator;
+
+	for (requestsIterator = m_thumbnailRequests.begin(); requestsIterator != m_thumbnailRequests.end(); ++requestsIterator)
+	{
+		if (requestsIterator.value().url == url && requestsIterator.value().size == size)
+		{
+			return true;
+		}
+	}
+
+	for (int i = 0; i < m_thumbnailQueue.count(); ++i)
+	{
+		if (m_thumbnailQueue.at(i).url == url && m_thumbnailQueue.at(i).size == size)
+		{
+			if (m_thumbnailQueue.at(i).priority <= priority)
+			{
+				return true;
+			}
+
+			m_thumbnailQueue.removeAt(i);
 
-	m_thumbnailRequests[page] = qMakePair(url, size);
+			break;
+		}
+	}
+
+	ThumbnailRequest request;
+	request.url = url;
+	request.size = size;
+	request.priority = priority;
+
+	QList<ThumbnailRequest>::iterator queueIterator(m_thumbnailQueue.begin());
+
+	while (queueIterator != m_thumbnailQueue.end() && queueIterator->priority <= priority)
+	{
+		++queueIterator;
+	}
 
-	connect(page, SIGNAL(loadFinished(bool)), this, SLOT(pageLoaded(bool)));
+	m_thumbnailQueue.insert(queueIterator, request);
 
-	page->setParent(this);
-	page->settings()->setAttribute(QWebSettings::JavaEnabled, false);
-	page->settings()->setAttribute(QWebSettings::JavascriptEnabled, false);
-	page->settings()->setAttribute(QWebSettings::PluginsEnabled, false);
-	page->mainFrame()->setUrl(url);
+	startThumbnailRequests();
 
 	return true;
 }
@@ -54,19 +54,32 @@ public:
 	QList<SpellCheckManager::DictionaryInformation> getDictionaries() const override;
 	BackendCapabilities getCapabilities() const override;
 	static int getOptionIdentifier(OptionIdentifier identifier);
-	bool requestThumbnail(const QUrl &url, const QSize &size) override;
+	bool requestThumbnail(const QUrl &url, const QSize &size, int priority = 0) override;
 
 protected:
+	struct ThumbnailRequest
+	{
+		QUrl url;
+		QSize size;
+		int priority = 0;
+		int timer = 0;
+	};
+
+	void timerEvent(QTimerEvent *event) override;
+	void finishThumbnailRequest(QtWebKitPage *page, const QPixmap &thumbnail = QPixmap(), const QString &title = QString());
 	static QtWebKitWebBackend* getInstance();
 	static QString getActiveDictionary();
 
 protected slots:
 	void optionChanged(int identifier);
 	void pageLoaded(bool success);
+	void startThumbnailRequests();
 	void setActiveWidget(WebWidget *widget);
 
 private:
-	QHash<QtWebKitPage*, QPair<QUrl, QSize> > m_thumbnailRequests;
+	QVector<QtWebKitPage*> m_thumbnailPages;
+	QList<ThumbnailRequest> m_thumbnailQueue;
+	QHash<QtWebKitPage*, ThumbnailRequest> m_thumbnailRequests;
 	bool m_isInitialized;
 
 	static QtWebKitWebBackend* m_instance;
@@ -57,6 +57,7 @@
 #include <QtCore/QJsonObject>
 #include <QtCore/QMimeData>
 #include <QtCore/QTimer>
+#include <QtCore/QtMath>
 #include <QtCore/QUuid>
 #include <QtGui/QClipboard>
 #include <QtGui/QImageWriter>
@@ -83,12 +84,15 @@ QtWebKitWebWidget::QtWebKitWebWidget(bool isPrivate, WebBackend *backend, QtWebK
 	m_inspector(nullptr),
 	m_networkManager(networkManager),
 	m_loadingState(WindowsManager::FinishedLoadingState),
+	m_thumbnails(10),
 	m_transfersTimer(0),
+	m_thumbnailTimer(0),
 	m_canLoadPlugins(false),
 	m_isAudioMuted(false),
 	m_isFullScreen(false),
 	m_isTyped(false),
-	m_isNavigating(false)
+	m_isNavigating(false),
+	m_needsThumbnailUpdate(true)
 {
 	QVBoxLayout *layout(new QVBoxLayout(this));
 	layout->addWidget(m_webView);
@@ -198,6 +202,14 @@ void QtWebKitWebWidget::timerEvent(QTimerEvent *event)
 			m_transfersTimer = startTimer(250);
 		}
 	}
+	else if (event->timerId() == m_thumbnailTimer)
+	{
+		killTimer(m_thumbnailTimer);
+
+		m_thumbnailTimer = 0;
+
+		updateThumbnail();
+	}
 	else
 	{
 		WebWidget::timerEvent(event);
@@ -302,7 +314,6 @@ void QtWebKitWebWidget::pageLoadStarted()
 		return;
 	}
 
-	m_thumbnail = QPixmap();
 	m_passwordToken = QUuid::createUuid().toString();
 	m_canLoadPlugins = (getOption(SettingsManager::Permissions_EnablePluginsOption, getUrl()).toString() == QLatin1String("enabled"));
 	m_loadingState = WindowsManager::OngoingLoadingState;
@@ -331,13 +342,14 @@ void QtWebKitWebWidget::pageLoadFinished()
 
 	m_networkManager->handleLoadingFinished();
 
-	m_thumbnail = QPixmap();
 	m_loadingState = WindowsManager::FinishedLoadingState;
 
 	updateNavigationActions();
 	handleHistory();
 	startReloadTimer();
 
+	invalidateThumbnail();
+
 	emit contentStateChanged(getContentState());
 	emit loadingStateChanged(WindowsManager::FinishedLoadingState);
 }
@@ -624,6 +636,44 @@ void QtWebKitWebWidget::handleHistory()
 	}
 }
 
+void QtWebKitWebWidget::updateThumbnail()
+{
+	if (m_loadingState == WindowsManager::OngoingLoadingState)
+	{
+		return;
+	}
+
+	const QSize viewportSize(m_page->viewportSize());
+
+	m_needsThumbnailUpdate = false;
+
+	if (viewportSize.isEmpty())
+	{
+		return;
+	}
+
+	const QSize thumbnailSize(QSize(260, 170) * devicePixelRatio());
+	const qreal scale(qreal(thumbnailSize.width()) / viewportSize.width());
+	ThumbnailEntry *entry(new ThumbnailEntry());
+	entry->thumbnail = QPixmap(thumbnailSize);
+	entry->thumbnail.fill(Qt::white);
+	entry->scrollPosition = getScrollPosition();
+
+	QPainter painter(&entry->thumbnail);
+	painter.setRenderHint(QPainter::SmoothPixmapTransform);
+	painter.scale(scale, scale);
+
+	m_page->mainFrame()->render(&painter, QWebFrame::ContentsLayer, QRegion(QRect(0, 0, viewportSize.width(), qCeil(thumbnailSize.height() / scale))));
+
+	painter.end();
+
+	entry->thumbnail.setDevicePixelRatio(devicePixelRatio());
+
+	m_thumbnails.insert(getThumbnailKey(), entry);
+
+	emit thumbnailChanged();
+}
+
 void QtWebKitWebWidget::handleWindowCloseRequest()
 {
 	const QString mode(SettingsManager::getValue(SettingsManager::Permissions_ScriptsCanCloseWindowsOption, getUrl()).toString());
@@ -886,6 +936,16 @@ void QtWebKitWebWidget::updateOptions(const QUrl &url)
 	m_canLoadPlugins = (getOption(SettingsManager::Permissions_EnablePluginsOption, url).toString() == QLatin1String("enabled"));
 }
 
+void QtWebKitWebWidget::invalidateThumbnail()
+{
+	if (!m_needsThumbnailUpdate)
+	{
+		m_needsThumbnailUpdate = true;
+
+		emit thumbnailChanged();
+	}
+}
+
 void QtWebKitWebWidget::clearOptions()
 {
 	WebWidget::clearOptions();
@@ -2189,6 +2249,11 @@ QString QtWebKitWebWidget::getPluginToken() const
 	return m_pluginToken;
 }
 
+QString QtWebKitWebWidget::getThumbnailKey() const
+{
+	return QString::number(m_page->history()->currentItemIndex()) + QLatin1Char(' ') + m_page->history()->currentItem().url().toString();
+}
+
 QVariant QtWebKitWebWidget::getPageInformation(WebWidget::PageInformation key) const
 {
 	if (key == LoadingTimeInformation)
@@ -2230,51 +2295,19 @@ QIcon QtWebKitWebWidget::getIcon() const
 
 QPixmap QtWebKitWebWidget::getThumbnail()
 {
-	if ((!m_thumbnail.isNull() && m_thumbnail.devicePixelRatio() == devicePixelRatio()) || m_loadingState == WindowsManager::OngoingLoadingState)
+	if (m_loadingState == WindowsManager::OngoingLoadingState)
 	{
-		return m_thumbnail;
+		return QPixmap();
 	}
 
-	const QSize thumbnailSize(QSize(260, 170));
-	const QSize oldViewportSize(m_webView->page()->viewportSize());
-	const QPoint position(m_webView->page()->mainFrame()->scrollPosition());
-	const qreal zoom(m_webView->page()->mainFrame()->zoomFactor());
-	QSize contentsSize(m_webView->page()->mainFrame()->contentsSize());
-	QWidget *newView(new QWidget());
-	QWidget *oldView(m_webView->page()->view());
+	const ThumbnailEntry *entry(m_thumbnails.object(getThumbnailKey()));
 
-	m_webView->page()->setView(newView);
-	m_webView->page()->setViewportSize(contentsSize);
-	m_webView->page()->mainFrame()->setZoomFactor(1);
-
-	if (contentsSize.width() > 2000)
+	if ((!entry || m_needsThumbnailUpdate || entry->thumbnail.devicePixelRatio() != devicePixelRatio() || entry->scrollPosition != getScrollPosition()) && m_thumbnailTimer == 0)
 	{
-		contentsSize.setWidth(2000);
+		m_thumbnailTimer = startTimer(250);
 	}
 
-	contentsSize.setHeight(thumbnailSize.height() * (qreal(contentsSize.width()) / thumbnailSize.width()));
-
-	QPixmap pixmap(contentsSize);
-	pixmap.fill(Qt::white);
-
-	QPainter painter(&pixmap);
-
-	m_webView->page()->mainFrame()->render(&painter, QWebFrame::ContentsLayer, QRegion(QRect(QPoint(0, 0), contentsSize)));
-	m_webView->page()->mainFrame()->setZoomFactor(zoom);
-	m_webView->page()->setView(oldView);
-	m_webView->page()->setViewportSize(oldViewportSize);
-	m_webView->page()->mainFrame()->setScrollPosition(position);
-
-	painter.end();
-
-	pixmap = pixmap.scaled((thumbnailSize * devicePixelRatio()), Qt::KeepAspectRatio, Qt::SmoothTransformation);
-	pixmap.setDevicePixelRatio(devicePixelRatio());
-
-	newView->deleteLater();
-
-	m_thumbnail = pixmap;
-
-	return pixmap;
+	return (entry ? entry->thumbnail : QPixmap());
 }
 
 QPoint QtWebKitWebWidget::getScrollPosition() const
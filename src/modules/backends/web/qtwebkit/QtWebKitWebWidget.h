@@ -23,6 +23,7 @@
 
 #include "../../../../ui/WebWidget.h"
 
+#include <QtCore/QCache>
 #include <QtCore/QQueue>
 #include <QtNetwork/QNetworkReply>
 #include <QtWebKitWidgets/QWebHitTestResult>
@@ -108,6 +109,12 @@ protected:
 		PositionEntryData = 2
 	};
 
+	struct ThumbnailEntry
+	{
+		QPixmap thumbnail;
+		QPoint scrollPosition;
+	};
+
 	explicit QtWebKitWebWidget(bool isPrivate, WebBackend *backend, QtWebKitNetworkManager *networkManager = nullptr, ContentsWidget *parent = nullptr);
 
 	void timerEvent(QTimerEvent *event) override;
@@ -124,6 +131,7 @@ protected:
 	void pasteText(const QString &text) override;
 	void startDelayedTransfer(Transfer *transfer);
 	void handleHistory();
+	void updateThumbnail();
 #ifdef OTTER_ENABLE_QTWEBKIT_LEGACY
 	void setHistory(QDataStream &stream);
 #else
@@ -133,6 +141,7 @@ protected:
 	QWebPage* getPage();
 	QString getPasswordToken() const;
 	QString getPluginToken() const;
+	QString getThumbnailKey() const;
 	QUrl resolveUrl(QWebFrame *frame, const QUrl &url) const;
 	int getAmountOfNotLoadedPlugins() const override;
 	bool canLoadPlugins() const;
@@ -174,6 +183,7 @@ protected slots:
 	void updateUndoText(const QString &text);
 	void updateRedoText(const QString &text);
 	void updateOptions(const QUrl &url);
+	void invalidateThumbnail();
 
 private:
 	QWebView *m_webView;
@@ -183,19 +193,21 @@ private:
 	QtWebKitNetworkManager *m_networkManager;
 	QString m_passwordToken;
 	QString m_pluginToken;
-	QPixmap m_thumbnail;
 	QUrl m_formRequestUrl;
 	QByteArray m_formRequestBody;
 	QQueue<Transfer*> m_transfers;
 	QHash<QNetworkReply*, QPointer<SourceViewerWebWidget> > m_viewSourceReplies;
+	QCache<QString, ThumbnailEntry> m_thumbnails;
 	QNetworkAccessManager::Operation m_formRequestOperation;
 	WindowsManager::LoadingState m_loadingState;
 	int m_transfersTimer;
+	int m_thumbnailTimer;
 	bool m_canLoadPlugins;
 	bool m_isAudioMuted;
 	bool m_isFullScreen;
 	bool m_isTyped;
 	bool m_isNavigating;
+	bool m_needsThumbnailUpdate;
 
 signals:
 	void widgetActivated(WebWidget *widget);
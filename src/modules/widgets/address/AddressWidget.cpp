@@ -814,7 +814,11 @@ void AddressWidget::showCompletion(bool isTypedHistory)
 
 	m_completionView->setFixedHeight(completionHeight);
 	m_completionView->viewport()->setFixedHeight(completionHeight - 3);
-	m_completionView->setCurrentIndex(m_completionModel->index(0, 0));
+
+	if (!m_completionView->currentIndex().isValid())
+	{
+		m_completionView->setCurrentIndex(m_completionModel->index(0, 0));
+	}
 }
 
 void AddressWidget::updateGeometries()
@@ -233,6 +233,11 @@ void ContentBlockingInformationWidget::populateProfilesMenu()
 			profileAction->setChecked(enabledProfiles.contains(profiles.at(i)->getName()));
 		}
 	}
+
+	m_profilesMenu->addSeparator();
+
+	QAction *cacheAction(m_profilesMenu->addAction(tr("Cached Verdicts: %1 hits, %2 misses").arg(ContentBlockingManager::getVerdictCacheHits()).arg(ContentBlockingManager::getVerdictCacheMisses())));
+	cacheAction->setEnabled(false);
 }
 
 void ContentBlockingInformationWidget::handleRequest(const NetworkManager::ResourceInformation &request)
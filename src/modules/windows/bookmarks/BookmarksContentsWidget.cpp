@@ -30,6 +30,7 @@
 #include "ui_BookmarksContentsWidget.h"
 
 #include <QtCore/QTimer>
+#include <QtCore/QTimerEvent>
 #include <QtGui/QClipboard>
 #include <QtGui/QMouseEvent>
 #include <QtWidgets/QDesktopWidget>
@@ -40,6 +41,7 @@ namespace Otter
 {
 
 BookmarksContentsWidget::BookmarksContentsWidget(Window *window) : ContentsWidget(window),
+	m_filterTimer(0),
 	m_ui(new Ui::BookmarksContentsWidget)
 {
 	m_ui->setupUi(this);
@@ -55,7 +57,6 @@ BookmarksContentsWidget::BookmarksContentsWidget(Window *window) : ContentsWidge
 	m_ui->bookmarksViewWidget->setViewMode(ItemViewWidget::TreeViewMode);
 	m_ui->bookmarksViewWidget->setModel(model);
 	m_ui->bookmarksViewWidget->setExpanded(m_ui->bookmarksViewWidget->model()->index(0, 0), true);
-	m_ui->bookmarksViewWidget->setFilterRoles(QSet<int>({BookmarksModel::UrlRole, BookmarksModel::TitleRole, BookmarksModel::DescriptionRole, BookmarksModel::KeywordRole}));
 	m_ui->bookmarksViewWidget->installEventFilter(this);
 	m_ui->bookmarksViewWidget->viewport()->installEventFilter(this);
 	m_ui->bookmarksViewWidget->viewport()->setMouseTracking(true);
@@ -70,7 +71,8 @@ BookmarksContentsWidget::BookmarksContentsWidget(Window *window) : ContentsWidge
 	connect(m_ui->propertiesButton, SIGNAL(clicked()), this, SLOT(bookmarkProperties()));
 	connect(m_ui->deleteButton, SIGNAL(clicked()), this, SLOT(removeBookmark()));
 	connect(m_ui->addButton, SIGNAL(clicked()), this, SLOT(addBookmark()));
-	connect(m_ui->filterLineEdit, SIGNAL(textChanged(QString)), m_ui->bookmarksViewWidget, SLOT(setFilterString(QString)));
+	connect(BookmarksManager::getModel(), SIGNAL(searchIndexModified()), this, SLOT(handleSearchIndexModified()));
+	connect(m_ui->filterLineEdit, SIGNAL(textChanged(QString)), this, SLOT(scheduleFilterUpdate()));
 	connect(m_ui->bookmarksViewWidget, SIGNAL(doubleClicked(QModelIndex)), this, SLOT(openBookmark(QModelIndex)));
 	connect(m_ui->bookmarksViewWidget, SIGNAL(customContextMenuRequested(QPoint)), this, SLOT(showContextMenu(QPoint)));
 	connect(m_ui->bookmarksViewWidget, SIGNAL(needsActionsUpdate()), this, SLOT(updateActions()));
@@ -81,6 +83,22 @@ BookmarksContentsWidget::~BookmarksContentsWidget()
 	delete m_ui;
 }
 
+void BookmarksContentsWidget::timerEvent(QTimerEvent *event)
+{
+	if (event->timerId() == m_filterTimer)
+	{
+		killTimer(m_filterTimer);
+
+		m_filterTimer = 0;
+
+		updateFilter();
+	}
+	else
+	{
+		ContentsWidget::timerEvent(event);
+	}
+}
+
 void BookmarksContentsWidget::changeEvent(QEvent *event)
 {
 	QWidget::changeEvent(event);
@@ -306,6 +324,42 @@ void BookmarksContentsWidget::updateActions()
 	}
 }
 
+void BookmarksContentsWidget::scheduleFilterUpdate()
+{
+	if (m_filterTimer != 0)
+	{
+		killTimer(m_filterTimer);
+	}
+
+	m_filterTimer = startTimer(150);
+}
+
+void BookmarksContentsWidget::handleSearchIndexModified()
+{
+	if (m_filterTimer == 0 && !m_ui->filterLineEdit->text().isEmpty())
+	{
+		m_filterTimer = startTimer(150);
+	}
+}
+
+void BookmarksContentsWidget::updateFilter()
+{
+	const QString filter(m_ui->filterLineEdit->text());
+	QSet<quint64> identifiers;
+
+	if (!filter.isEmpty())
+	{
+		const QList<BookmarksItem*> bookmarks(BookmarksManager::getModel()->searchBookmarks(filter));
+
+		for (int i = 0; i < bookmarks.count(); ++i)
+		{
+			identifiers.insert(bookmarks.at(i)->data(BookmarksModel::IdentifierRole).toULongLong());
+		}
+	}
+
+	m_ui->bookmarksViewWidget->setFilterIdentifiers(filter, identifiers);
+}
+
 void BookmarksContentsWidget::print(QPrinter *printer)
 {
 	m_ui->bookmarksViewWidget->render(printer);
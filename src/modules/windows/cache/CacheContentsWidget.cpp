@@ -114,36 +114,86 @@ void CacheContentsWidget::populateCache()
 	m_model->setSortRole(Qt::DisplayRole);
 
 	NetworkCache *cache(NetworkManagerFactory::getCache());
-	const QList<QUrl> entries(cache->getEntries());
 
-	for (int i = 0; i < entries.count(); ++i)
-	{
-		addEntry(entries.at(i));
-	}
+	m_pendingEntries = cache->getEntries();
 
-	m_model->sort(0);
-
-	if (m_isLoading)
+	if (m_ui->cacheViewWidget->getSourceModel() != m_model)
 	{
 		m_ui->cacheViewWidget->setModel(m_model);
 		m_ui->cacheViewWidget->setLayoutDirection(Qt::LeftToRight);
 		m_ui->cacheViewWidget->setFilterRoles(QSet<int>({Qt::DisplayRole, Qt::UserRole}));
 
-		m_isLoading = false;
-
-		emit loadingStateChanged(WindowsManager::FinishedLoadingState);
-
 		connect(cache, SIGNAL(cleared()), this, SLOT(populateCache()));
 		connect(cache, SIGNAL(entryAdded(QUrl)), this, SLOT(addEntry(QUrl)));
 		connect(cache, SIGNAL(entryRemoved(QUrl)), this, SLOT(removeEntry(QUrl)));
 		connect(m_model, SIGNAL(modelReset()), this, SLOT(updateActions()));
 		connect(m_ui->cacheViewWidget, SIGNAL(needsActionsUpdate()), this, SLOT(updateActions()));
 	}
+
+	populateEntries();
+}
+
+void CacheContentsWidget::populateEntries()
+{
+	NetworkCache *cache(NetworkManagerFactory::getCache());
+	const int amount(qMin(500, m_pendingEntries.count()));
+
+	for (int i = 0; i < amount; ++i)
+	{
+		const NetworkCache::EntryInformation entry(m_pendingEntries.takeFirst());
+
+		if (cache->getEntry(entry.url).url.isValid())
+		{
+			addEntry(entry);
+		}
+	}
+
+	if (!m_pendingEntries.isEmpty())
+	{
+		QMetaObject::invokeMethod(this, "populateEntries", Qt::QueuedConnection);
+
+		return;
+	}
+
+	m_model->sort(0);
+
+	if (m_isLoading)
+	{
+		m_isLoading = false;
+
+		emit loadingStateChanged(WindowsManager::FinishedLoadingState);
+	}
 }
 
 void CacheContentsWidget::addEntry(const QUrl &entry)
 {
-	const QString domain(entry.host());
+	const NetworkCache::EntryInformation information(NetworkManagerFactory::getCache()->getEntry(entry));
+
+	if (!information.url.isValid())
+	{
+		return;
+	}
+
+	const bool hasDomain(findDomain(entry.host()) != nullptr);
+
+	addEntry(information);
+
+	QStandardItem *domainItem(findDomain(entry.host()));
+
+	if (domainItem)
+	{
+		domainItem->sortChildren(0, Qt::DescendingOrder);
+	}
+
+	if (!hasDomain)
+	{
+		m_model->sort(0);
+	}
+}
+
+void CacheContentsWidget::addEntry(const NetworkCache::EntryInformation &entry)
+{
+	const QString domain(entry.url.host());
 	QStandardItem *domainItem(findDomain(domain));
 
 	if (domainItem)
@@ -152,7 +202,7 @@ void CacheContentsWidget::addEntry(const QUrl &entry)
 		{
 			QStandardItem *entryItem(domainItem->child(i, 0));
 
-			if (entryItem && entry == entryItem->data(Qt::UserRole).toUrl())
+			if (entryItem && entry.url == entryItem->data(Qt::UserRole).toUrl())
 			{
 				return;
 			}
@@ -165,59 +215,27 @@ void CacheContentsWidget::addEntry(const QUrl &entry)
 
 		m_model->appendRow(domainItem);
 		m_model->setItem(domainItem->row(), 2, new QStandardItem(QString()));
-
-		if (sender())
-		{
-			m_model->sort(0);
-		}
 	}
 
-	NetworkCache *cache(NetworkManagerFactory::getCache());
-	QIODevice *device(cache->data(entry));
-	const QNetworkCacheMetaData metaData(cache->metaData(entry));
-	const QList<QPair<QByteArray, QByteArray> > headers(metaData.rawHeaders());
-	QString type;
-
-	for (int i = 0; i < headers.count(); ++i)
-	{
-		if (headers.at(i).first == QStringLiteral("Content-Type").toLatin1())
-		{
-			type = QString(headers.at(i).second);
-
-			break;
-		}
-	}
-
-	const QMimeType mimeType((type.isEmpty() && device) ? QMimeDatabase().mimeTypeForData(device) : QMimeDatabase().mimeTypeForName(type));
-	QList<QStandardItem*> entryItems({new QStandardItem(entry.path()), new QStandardItem(mimeType.name()), new QStandardItem(device ? Utils::formatUnit(device->size()) : QString()), new QStandardItem(Utils::formatDateTime(metaData.lastModified())), new QStandardItem(Utils::formatDateTime(metaData.expirationDate()))});
-	entryItems[0]->setData(entry, Qt::UserRole);
+	QList<QStandardItem*> entryItems({new QStandardItem(entry.url.path()), new QStandardItem(entry.mimeType.isEmpty() ? QString() : QMimeDatabase().mimeTypeForName(entry.mimeType).name()), new QStandardItem(Utils::formatUnit(entry.size)), new QStandardItem(Utils::formatDateTime(entry.lastModified)), new QStandardItem(Utils::formatDateTime(entry.expirationDate))});
+	entryItems[0]->setData(entry.url, Qt::UserRole);
 	entryItems[0]->setFlags(entryItems[0]->flags() | Qt::ItemNeverHasChildren);
 	entryItems[1]->setFlags(entryItems[1]->flags() | Qt::ItemNeverHasChildren);
-	entryItems[2]->setData((device ? device->size() : 0), Qt::UserRole);
+	entryItems[2]->setData(entry.size, Qt::UserRole);
 	entryItems[2]->setFlags(entryItems[2]->flags() | Qt::ItemNeverHasChildren);
 	entryItems[3]->setFlags(entryItems[3]->flags() | Qt::ItemNeverHasChildren);
 	entryItems[4]->setFlags(entryItems[4]->flags() | Qt::ItemNeverHasChildren);
 
-	if (device)
-	{
-		QStandardItem *sizeItem(m_model->item(domainItem->row(), 2));
+	QStandardItem *sizeItem(m_model->item(domainItem->row(), 2));
 
-		if (sizeItem)
-		{
-			sizeItem->setData((sizeItem->data(Qt::UserRole).toLongLong() + device->size()), Qt::UserRole);
-			sizeItem->setText(Utils::formatUnit(sizeItem->data(Qt::UserRole).toLongLong()));
-		}
-
-		device->deleteLater();
+	if (sizeItem)
+	{
+		sizeItem->setData((sizeItem->data(Qt::UserRole).toLongLong() + entry.size), Qt::UserRole);
+		sizeItem->setText(Utils::formatUnit(sizeItem->data(Qt::UserRole).toLongLong()));
 	}
 
 	domainItem->appendRow(entryItems);
 	domainItem->setText(QStringLiteral("%1 (%2)").arg(domain).arg(domainItem->rowCount()));
-
-	if (sender())
-	{
-		domainItem->sortChildren(0, Qt::DescendingOrder);
-	}
 }
 
 void CacheContentsWidget::removeEntry(const QUrl &entry)
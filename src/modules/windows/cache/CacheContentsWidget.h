@@ -20,6 +20,7 @@
 #ifndef OTTER_CacheContentsWidget_H
 #define OTTER_CacheContentsWidget_H
 
+#include "../../../core/NetworkCache.h"
 #include "../../../ui/ContentsWidget.h"
 
 #include <QtGui/QStandardItemModel>
@@ -56,12 +57,14 @@ public slots:
 
 protected:
 	void changeEvent(QEvent *event) override;
+	void addEntry(const NetworkCache::EntryInformation &entry);
 	QStandardItem* findDomain(const QString &domain);
 	QStandardItem* findEntry(const QUrl &entry);
 	QUrl getEntry(const QModelIndex &index) const;
 
 protected slots:
 	void populateCache();
+	void populateEntries();
 	void addEntry(const QUrl &entry);
 	void removeEntry(const QUrl &entry);
 	void removeEntry();
@@ -74,6 +77,7 @@ protected slots:
 
 private:
 	QStandardItemModel *m_model;
+	QList<NetworkCache::EntryInformation> m_pendingEntries;
 	QHash<int, Action*> m_actions;
 	bool m_isLoading;
 	Ui::CacheContentsWidget *m_ui;
@@ -25,6 +25,7 @@
 #include "ui_HistoryContentsWidget.h"
 
 #include <QtCore/QTimer>
+#include <QtCore/QTimerEvent>
 #include <QtGui/QClipboard>
 #include <QtGui/QMouseEvent>
 #include <QtWidgets/QMenu>
@@ -32,173 +33,495 @@
 namespace Otter
 {
 
-HistoryContentsWidget::HistoryContentsWidget(Window *window) : ContentsWidget(window),
-	m_model(new QStandardItemModel(this)),
-	m_isLoading(true),
-	m_ui(new Ui::HistoryContentsWidget)
+HistoryContentsModel::HistoryContentsModel(HistoryModel *model, QObject *parent) : QAbstractItemModel(parent),
+	m_model(model),
+	m_groups({tr("Today"), tr("Yesterday"), tr("Earlier This Week"), tr("Previous Week"), tr("Earlier This Month"), tr("Earlier This Year"), tr("Older")}),
+	m_changedGroup(-1)
 {
-	m_ui->setupUi(this);
+	reload();
+
+	connect(m_model, SIGNAL(modelReset()), this, SLOT(reload()));
+	connect(m_model, SIGNAL(entryAboutToBeAdded(QDateTime)), this, SLOT(handleEntryAboutToBeAdded(QDateTime)));
+	connect(m_model, SIGNAL(rowsAboutToBeInserted(QModelIndex,int,int)), this, SLOT(handleRowsAboutToBeInserted(QModelIndex,int,int)));
+	connect(m_model, SIGNAL(rowsInserted(QModelIndex,int,int)), this, SLOT(handleRowsInserted(QModelIndex,int,int)));
+	connect(m_model, SIGNAL(rowsAboutToBeRemoved(QModelIndex,int,int)), this, SLOT(handleRowsAboutToBeRemoved(QModelIndex,int,int)));
+	connect(m_model, SIGNAL(rowsRemoved(QModelIndex,int,int)), this, SLOT(handleRowsRemoved(QModelIndex,int,int)));
+	connect(m_model, SIGNAL(dataChanged(QModelIndex,QModelIndex)), this, SLOT(handleDataChanged(QModelIndex,QModelIndex)));
+}
 
-	const QStringList groups({tr("Today"), tr("Yesterday"), tr("Earlier This Week"), tr("Previous Week"), tr("Earlier This Month"), tr("Earlier This Year"), tr("Older")});
+void HistoryContentsModel::reload()
+{
+	beginResetModel();
 
-	for (int i = 0; i < groups.count(); ++i)
+	updateSizes();
+
+	endResetModel();
+}
+
+void HistoryContentsModel::updateSizes()
+{
+	const QDate date(QDate::currentDate());
+
+	m_dates = QVector<QDate>({date, date.addDays(-1), date.addDays(-7), date.addDays(-14), date.addDays(-30), date.addDays(-365), QDate()});
+	m_sizes = QVector<int>(m_groups.count(), 0);
+
+	int start(0);
+
+	// history rows are ordered from the most recent visit, so each group is a continuous range of them
+	for (int i = 0; i < (m_dates.count() - 1); ++i)
 	{
-		m_model->appendRow(new QStandardItem(ThemesManager::getIcon(QLatin1String("inode-directory")), groups.at(i)));
+		const int end(qMax(start, findBoundary(m_dates.at(i))));
+
+		m_sizes[i] = (end - start);
+
+		start = end;
 	}
 
-	m_model->setHorizontalHeaderLabels(QStringList({tr("Address"), tr("Title"), tr("Date")}));
-	m_model->setSortRole(Qt::DisplayRole);
+	m_sizes[m_sizes.count() - 1] = (m_model->rowCount() - start);
+}
 
-	m_ui->historyViewWidget->setViewMode(ItemViewWidget::TreeViewMode);
-	m_ui->historyViewWidget->setModel(m_model, true);
-	m_ui->historyViewWidget->installEventFilter(this);
-	m_ui->historyViewWidget->viewport()->installEventFilter(this);
-	m_ui->filterLineEdit->installEventFilter(this);
+void HistoryContentsModel::handleEntryAboutToBeAdded(const QDateTime &timeVisited)
+{
+	m_addedDate = timeVisited.date();
+}
 
-	for (int i = 0; i < m_model->rowCount(); ++i)
+void HistoryContentsModel::handleRowsAboutToBeInserted(const QModelIndex &parent, int first, int last)
+{
+	if (parent.isValid())
 	{
-		m_ui->historyViewWidget->setRowHidden(i, m_model->invisibleRootItem()->index(), true);
+		return;
 	}
 
-	QTimer::singleShot(100, this, SLOT(populateEntries()));
+	// history model adds one entry at a time, its row is placed in a group by the visit time announced just before
+	m_changedGroup = getGroup(first, m_addedDate);
 
-	connect(HistoryManager::getBrowsingHistoryModel(), SIGNAL(cleared()), this, SLOT(populateEntries()));
-	connect(HistoryManager::getBrowsingHistoryModel(), SIGNAL(entryAdded(HistoryEntryItem*)), this, SLOT(addEntry(HistoryEntryItem*)));
-	connect(HistoryManager::getBrowsingHistoryModel(), SIGNAL(entryModified(HistoryEntryItem*)), this, SLOT(modifyEntry(HistoryEntryItem*)));
-	connect(HistoryManager::getBrowsingHistoryModel(), SIGNAL(entryRemoved(HistoryEntryItem*)), this, SLOT(removeEntry(HistoryEntryItem*)));
-	connect(HistoryManager::getInstance(), SIGNAL(dayChanged()), this, SLOT(populateEntries()));
-	connect(m_ui->filterLineEdit, SIGNAL(textChanged(QString)), m_ui->historyViewWidget, SLOT(setFilterString(QString)));
-	connect(m_ui->historyViewWidget, SIGNAL(doubleClicked(QModelIndex)), this, SLOT(openEntry(QModelIndex)));
-	connect(m_ui->historyViewWidget, SIGNAL(customContextMenuRequested(QPoint)), this, SLOT(showContextMenu(QPoint)));
+	const int start(getGroupStart(m_changedGroup));
+
+	beginInsertRows(index(m_changedGroup, 0), (first - start), (last - start));
 }
 
-HistoryContentsWidget::~HistoryContentsWidget()
+void HistoryContentsModel::handleRowsInserted(const QModelIndex &parent, int first, int last)
 {
-	delete m_ui;
+	if (parent.isValid() || m_changedGroup < 0)
+	{
+		return;
+	}
+
+	m_sizes[m_changedGroup] += (last - first + 1);
+	m_changedGroup = -1;
+	m_addedDate = QDate();
+
+	endInsertRows();
 }
 
-void HistoryContentsWidget::changeEvent(QEvent *event)
+void HistoryContentsModel::handleRowsAboutToBeRemoved(const QModelIndex &parent, int first, int last)
 {
-	QWidget::changeEvent(event);
+	if (parent.isValid())
+	{
+		return;
+	}
 
-	if (event->type() == QEvent::LanguageChange)
+	const int group(findGroup(first));
+
+	// ranges spanning several groups cannot be announced as a single removal
+	if (group != findGroup(last))
 	{
-		m_ui->retranslateUi(this);
+		m_changedGroup = -1;
+
+		beginResetModel();
+
+		return;
 	}
+
+	const int start(getGroupStart(group));
+
+	m_changedGroup = group;
+
+	beginRemoveRows(index(group, 0), (first - start), (last - start));
 }
 
-void HistoryContentsWidget::triggerAction(int identifier, const QVariantMap &parameters)
+void HistoryContentsModel::handleRowsRemoved(const QModelIndex &parent, int first, int last)
 {
-	Q_UNUSED(parameters)
+	if (parent.isValid())
+	{
+		return;
+	}
 
-	switch (identifier)
+	if (m_changedGroup < 0)
 	{
-		case ActionsManager::FindAction:
-		case ActionsManager::QuickFindAction:
-		case ActionsManager::ActivateAddressFieldAction:
-			m_ui->filterLineEdit->setFocus();
+		updateSizes();
 
-			break;
-		case ActionsManager::ActivateContentAction:
-			m_ui->historyViewWidget->setFocus();
+		endResetModel();
 
-			break;
-		default:
-			break;
+		return;
 	}
+
+	m_sizes[m_changedGroup] -= (last - first + 1);
+	m_changedGroup = -1;
+
+	endRemoveRows();
 }
 
-void HistoryContentsWidget::print(QPrinter *printer)
+void HistoryContentsModel::handleDataChanged(const QModelIndex &topLeft, const QModelIndex &bottomRight)
 {
-	m_ui->historyViewWidget->render(printer);
+	for (int i = topLeft.row(); i <= bottomRight.row(); ++i)
+	{
+		int start(0);
+
+		for (int j = 0; j < m_sizes.count(); ++j)
+		{
+			if (i < (start + m_sizes.at(j)))
+			{
+				const QModelIndex groupIndex(index(j, 0));
+
+				emit dataChanged(index((i - start), 0, groupIndex), index((i - start), 2, groupIndex));
+
+				break;
+			}
+
+			start += m_sizes.at(j);
+		}
+	}
 }
 
-void HistoryContentsWidget::populateEntries()
+QModelIndex HistoryContentsModel::mapFromSource(const QModelIndex &sourceIndex) const
 {
-	const QDate date(QDate::currentDate());
-	const QList<QDate> dates({date, date.addDays(-1), date.addDays(-7), date.addDays(-14), date.addDays(-30), date.addDays(-365)});
-
-	for (int i = 0; i < m_model->rowCount(); ++i)
+	if (!sourceIndex.isValid())
 	{
-		QStandardItem *groupItem(m_model->item(i, 0));
+		return QModelIndex();
+	}
 
-		if (groupItem)
+	int start(0);
+
+	for (int i = 0; i < m_sizes.count(); ++i)
+	{
+		if (sourceIndex.row() < (start + m_sizes.at(i)))
 		{
-			groupItem->setData(dates.value(i, QDate()), Qt::UserRole);
-			groupItem->removeRows(0, groupItem->rowCount());
+			return index((sourceIndex.row() - start), 0, index(i, 0));
 		}
+
+		start += m_sizes.at(i);
 	}
 
-	HistoryModel *model(HistoryManager::getBrowsingHistoryModel());
+	return QModelIndex();
+}
 
-	for (int i = 0; i < model->rowCount(); ++i)
+QModelIndex HistoryContentsModel::index(int row, int column, const QModelIndex &parent) const
+{
+	if (row < 0 || column < 0 || column >= 3)
 	{
-		addEntry(dynamic_cast<HistoryEntryItem*>(model->item(i, 0)));
+		return QModelIndex();
 	}
 
-	const QString expandBranches(SettingsManager::getValue(SettingsManager::History_ExpandBranchesOption).toString());
+	if (!parent.isValid())
+	{
+		return ((row < m_groups.count()) ? createIndex(row, column, quintptr(0)) : QModelIndex());
+	}
 
-	if (expandBranches == QLatin1String("first"))
+	if (parent.internalId() == 0 && parent.row() < m_sizes.count() && row < m_sizes.at(parent.row()))
 	{
-		for (int i = 0; i < m_model->rowCount(); ++i)
+		return createIndex(row, column, quintptr(parent.row() + 1));
+	}
+
+	return QModelIndex();
+}
+
+QModelIndex HistoryContentsModel::parent(const QModelIndex &index) const
+{
+	if (!index.isValid() || index.internalId() == 0)
+	{
+		return QModelIndex();
+	}
+
+	return createIndex(static_cast<int>(index.internalId() - 1), 0, quintptr(0));
+}
+
+QVariant HistoryContentsModel::data(const QModelIndex &index, int role) const
+{
+	if (!index.isValid())
+	{
+		return QVariant();
+	}
+
+	if (index.internalId() == 0)
+	{
+		if (index.column() == 0 && role == Qt::DisplayRole)
 		{
-			const QModelIndex index(m_model->index(i, 0));
+			return m_groups.value(index.row());
+		}
 
-			if (m_model->rowCount(index) > 0)
+		if (index.column() == 0 && role == Qt::DecorationRole)
+		{
+			return ThemesManager::getIcon(QLatin1String("inode-directory"));
+		}
+
+		return QVariant();
+	}
+
+	const QModelIndex entryIndex(m_model->index(getGroupStart(static_cast<int>(index.internalId() - 1)) + index.row()));
+
+	switch (index.column())
+	{
+		case 0:
+			if (role == Qt::DisplayRole)
 			{
-				m_ui->historyViewWidget->expand(m_ui->historyViewWidget->getProxyModel()->mapFromSource(index));
+				return entryIndex.data(HistoryModel::UrlRole).toUrl().toDisplayString().replace(QLatin1String("%23"), QString(QLatin1Char('#')));
+			}
 
-				break;
+			if (role == Qt::DecorationRole)
+			{
+				const QIcon icon(entryIndex.data(Qt::DecorationRole).value<QIcon>());
+
+				return (icon.isNull() ? ThemesManager::getIcon(QLatin1String("text-html")) : icon);
 			}
+
+			if (role == Qt::UserRole)
+			{
+				return entryIndex.data(HistoryModel::IdentifierRole);
+			}
+
+			break;
+		case 1:
+			if (role == Qt::DisplayRole)
+			{
+				const QString title(entryIndex.data(HistoryModel::TitleRole).toString());
+
+				return (title.isEmpty() ? tr("(Untitled)") : title);
+			}
+
+			break;
+		case 2:
+			if (role == Qt::DisplayRole)
+			{
+				return Utils::formatDateTime(entryIndex.data(HistoryModel::TimeVisitedRole).toDateTime());
+			}
+
+			break;
+		default:
+			break;
+	}
+
+	return QVariant();
+}
+
+QVariant HistoryContentsModel::headerData(int section, Qt::Orientation orientation, int role) const
+{
+	if (orientation == Qt::Horizontal && role == Qt::DisplayRole)
+	{
+		switch (section)
+		{
+			case 0:
+				return tr("Address");
+			case 1:
+				return tr("Title");
+			case 2:
+				return tr("Date");
+			default:
+				break;
 		}
 	}
-	else if (expandBranches == QLatin1String("all"))
+
+	return QVariant();
+}
+
+Qt::ItemFlags HistoryContentsModel::flags(const QModelIndex &index) const
+{
+	if (!index.isValid())
 	{
-		m_ui->historyViewWidget->expandAll();
+		return Qt::NoItemFlags;
+	}
+
+	if (index.internalId() == 0)
+	{
+		return (Qt::ItemIsEnabled | Qt::ItemIsSelectable);
 	}
 
-	m_isLoading = false;
+	return (Qt::ItemIsEnabled | Qt::ItemIsSelectable | Qt::ItemNeverHasChildren);
+}
+
+int HistoryContentsModel::columnCount(const QModelIndex &parent) const
+{
+	Q_UNUSED(parent)
 
-	emit loadingStateChanged(WindowsManager::FinishedLoadingState);
+	return 3;
 }
 
-void HistoryContentsWidget::addEntry(HistoryEntryItem *entry)
+int HistoryContentsModel::rowCount(const QModelIndex &parent) const
 {
-	if (!entry || entry->data(HistoryModel::IdentifierRole).toULongLong() == 0 || findEntry(entry->data(HistoryModel::IdentifierRole).toULongLong()))
+	if (!parent.isValid())
 	{
-		return;
+		return m_groups.count();
+	}
+
+	if (parent.internalId() == 0 && parent.column() == 0)
+	{
+		return m_sizes.value(parent.row(), 0);
 	}
 
-	QStandardItem *groupItem(nullptr);
+	return 0;
+}
 
-	for (int i = 0; i < m_model->rowCount(); ++i)
+int HistoryContentsModel::findBoundary(const QDate &date) const
+{
+	int low(0);
+	int high(m_model->rowCount());
+
+	while (low < high)
 	{
-		groupItem = m_model->item(i, 0);
+		const int middle((low + high) / 2);
 
-		if (groupItem && (entry->data(HistoryModel::TimeVisitedRole).toDateTime().date() >= groupItem->data(Qt::UserRole).toDate() || !groupItem->data(Qt::UserRole).toDate().isValid()))
+		if (m_model->index(middle).data(HistoryModel::TimeVisitedRole).toDateTime().date() >= date)
 		{
-			break;
+			low = (middle + 1);
+		}
+		else
+		{
+			high = middle;
 		}
+	}
+
+	return low;
+}
+
+int HistoryContentsModel::findGroup(int row) const
+{
+	int start(0);
 
-		groupItem = nullptr;
+	for (int i = 0; i < m_sizes.count(); ++i)
+	{
+		start += m_sizes.at(i);
+
+		if (row < start)
+		{
+			return i;
+		}
 	}
 
-	if (!groupItem)
+	return (m_sizes.count() - 1);
+}
+
+int HistoryContentsModel::getGroup(int row, const QDate &date) const
+{
+	int start(0);
+
+	for (int i = 0; i < (m_sizes.count() - 1); ++i)
 	{
-		return;
+		const int end(start + m_sizes.at(i));
+
+		if (row < end || (row == end && (!m_dates.at(i).isValid() || date >= m_dates.at(i))))
+		{
+			return i;
+		}
+
+		start = end;
 	}
 
-	QList<QStandardItem*> entryItems({new QStandardItem((entry->icon().isNull() ? ThemesManager::getIcon(QLatin1String("text-html")) : entry->icon()), entry->data(HistoryModel::UrlRole).toUrl().toDisplayString().replace(QLatin1String("%23"), QString(QLatin1Char('#')))), new QStandardItem(entry->data(HistoryModel::TitleRole).isNull() ? tr("(Untitled)") : entry->data(HistoryModel::TitleRole).toString()), new QStandardItem(Utils::formatDateTime(entry->data(HistoryModel::TimeVisitedRole).toDateTime()))});
-	entryItems[0]->setData(entry->data(HistoryModel::IdentifierRole).toULongLong(), Qt::UserRole);
-	entryItems[0]->setFlags(entryItems[0]->flags() | Qt::ItemNeverHasChildren);
-	entryItems[1]->setFlags(entryItems[1]->flags() | Qt::ItemNeverHasChildren);
-	entryItems[2]->setFlags(entryItems[2]->flags() | Qt::ItemNeverHasChildren);
+	return (m_sizes.count() - 1);
+}
 
-	groupItem->appendRow(entryItems);
+int HistoryContentsModel::getGroupStart(int group) const
+{
+	int start(0);
 
-	m_ui->historyViewWidget->setRowHidden(groupItem->row(), groupItem->index().parent(), false);
+	for (int i = 0; i < group && i < m_sizes.count(); ++i)
+	{
+		start += m_sizes.at(i);
+	}
+
+	return start;
+}
 
-	if (sender() && groupItem->rowCount() == 1 && SettingsManager::getValue(SettingsManager::History_ExpandBranchesOption).toString() == QLatin1String("first"))
+HistoryContentsWidget::HistoryContentsWidget(Window *window) : ContentsWidget(window),
+	m_model(new HistoryContentsModel(HistoryManager::getBrowsingHistoryModel(), this)),
+	m_filterTimer(0),
+	m_isLoading(true),
+	m_ui(new Ui::HistoryContentsWidget)
+{
+	m_ui->setupUi(this);
+	m_ui->historyViewWidget->setViewMode(ItemViewWidget::TreeViewMode);
+	m_ui->historyViewWidget->setModel(m_model, true);
+	m_ui->historyViewWidget->installEventFilter(this);
+	m_ui->historyViewWidget->viewport()->installEventFilter(this);
+	m_ui->filterLineEdit->installEventFilter(this);
+
+	updateGroups();
+
+	QTimer::singleShot(100, this, SLOT(populateEntries()));
+
+	connect(m_model, SIGNAL(modelReset()), this, SLOT(populateEntries()));
+	connect(m_model, SIGNAL(rowsInserted(QModelIndex,int,int)), this, SLOT(updateGroups()));
+	connect(m_model, SIGNAL(rowsRemoved(QModelIndex,int,int)), this, SLOT(updateGroups()));
+	connect(HistoryManager::getInstance(), SIGNAL(dayChanged()), m_model, SLOT(reload()));
+	connect(HistoryManager::getBrowsingHistoryModel(), SIGNAL(modelReset()), this, SLOT(scheduleFilterUpdate()));
+	connect(HistoryManager::getBrowsingHistoryModel(), SIGNAL(entryAdded(quint64)), this, SLOT(handleEntryModified(quint64)));
+	connect(HistoryManager::getBrowsingHistoryModel(), SIGNAL(entryModified(quint64)), this, SLOT(handleEntryModified(quint64)));
+	connect(m_ui->filterLineEdit, SIGNAL(textChanged(QString)), this, SLOT(scheduleFilterUpdate()));
+	connect(m_ui->historyViewWidget, SIGNAL(doubleClicked(QModelIndex)), this, SLOT(openEntry(QModelIndex)));
+	connect(m_ui->historyViewWidget, SIGNAL(customContextMenuRequested(QPoint)), this, SLOT(showContextMenu(QPoint)));
+}
+
+HistoryContentsWidget::~HistoryContentsWidget()
+{
+	delete m_ui;
+}
+
+void HistoryContentsWidget::timerEvent(QTimerEvent *event)
+{
+	if (event->timerId() == m_filterTimer)
+	{
+		killTimer(m_filterTimer);
+
+		m_filterTimer = 0;
+
+		updateFilter();
+	}
+	else
+	{
+		ContentsWidget::timerEvent(event);
+	}
+}
+
+void HistoryContentsWidget::changeEvent(QEvent *event)
+{
+	QWidget::changeEvent(event);
+
+	if (event->type() == QEvent::LanguageChange)
+	{
+		m_ui->retranslateUi(this);
+	}
+}
+
+void HistoryContentsWidget::triggerAction(int identifier, const QVariantMap &parameters)
+{
+	Q_UNUSED(parameters)
+
+	switch (identifier)
+	{
+		case ActionsManager::FindAction:
+		case ActionsManager::QuickFindAction:
+		case ActionsManager::ActivateAddressFieldAction:
+			m_ui->filterLineEdit->setFocus();
+
+			break;
+		case ActionsManager::ActivateContentAction:
+			m_ui->historyViewWidget->setFocus();
+
+			break;
+		default:
+			break;
+	}
+}
+
+void HistoryContentsWidget::print(QPrinter *printer)
+{
+	m_ui->historyViewWidget->render(printer);
+}
+
+void HistoryContentsWidget::expandBranches()
+{
+	const QString expandBranches(SettingsManager::getValue(SettingsManager::History_ExpandBranchesOption).toString());
+
+	if (expandBranches == QLatin1String("first"))
 	{
 		for (int i = 0; i < m_model->rowCount(); ++i)
 		{
@@ -212,52 +535,44 @@ void HistoryContentsWidget::addEntry(HistoryEntryItem *entry)
 			}
 		}
 	}
-}
-
-void HistoryContentsWidget::modifyEntry(HistoryEntryItem *entry)
-{
-	if (!entry || entry->data(HistoryModel::IdentifierRole).toULongLong() == 0)
+	else if (expandBranches == QLatin1String("all"))
 	{
-		return;
+		m_ui->historyViewWidget->expandAll();
 	}
+}
 
-	QStandardItem *entryItem(findEntry(entry->data(HistoryModel::IdentifierRole).toULongLong()));
+void HistoryContentsWidget::populateEntries()
+{
+	updateGroups();
+	expandBranches();
 
-	if (!entryItem)
+	if (m_isLoading && !HistoryManager::getBrowsingHistoryModel()->isLoading())
 	{
-		addEntry(entry);
+		m_isLoading = false;
 
-		return;
+		emit loadingStateChanged(WindowsManager::FinishedLoadingState);
 	}
-
-	entryItem->setIcon(entry->icon().isNull() ? ThemesManager::getIcon(QLatin1String("text-html")) : entry->icon());
-	entryItem->setText(entry->data(HistoryModel::UrlRole).toUrl().toDisplayString());
-	entryItem->parent()->child(entryItem->row(), 1)->setText(entry->data(HistoryModel::TitleRole).isNull() ? tr("(Untitled)") : entry->data(HistoryModel::TitleRole).toString());
-	entryItem->parent()->child(entryItem->row(), 2)->setText(Utils::formatDateTime(entry->data(HistoryModel::TimeVisitedRole).toDateTime()));
 }
 
-void HistoryContentsWidget::removeEntry(HistoryEntryItem *entry)
+void HistoryContentsWidget::updateGroups()
 {
-	if (!entry || entry->data(HistoryModel::IdentifierRole).toULongLong() == 0)
-	{
-		return;
-	}
-
-	QStandardItem *entryItem(findEntry(entry->data(HistoryModel::IdentifierRole).toULongLong()));
+	bool hasShownGroup(false);
 
-	if (entryItem)
+	for (int i = 0; i < m_model->rowCount(); ++i)
 	{
-		QStandardItem *groupItem(entryItem->parent());
+		const bool isEmpty(m_model->rowCount(m_model->index(i, 0)) == 0);
 
-		if (groupItem)
+		if (!isEmpty && m_ui->historyViewWidget->isRowHidden(i, QModelIndex()))
 		{
-			m_model->removeRow(entryItem->row(), groupItem->index());
-
-			if (groupItem->rowCount() == 0)
-			{
-				m_ui->historyViewWidget->setRowHidden(groupItem->row(), m_model->invisibleRootItem()->index(), true);
-			}
+			hasShownGroup = true;
 		}
+
+		m_ui->historyViewWidget->setRowHidden(i, QModelIndex(), isEmpty);
+	}
+
+	if (hasShownGroup && sender() == m_model && SettingsManager::getValue(SettingsManager::History_ExpandBranchesOption).toString() == QLatin1String("first"))
+	{
+		expandBranches();
 	}
 }
 
@@ -273,44 +588,21 @@ void HistoryContentsWidget::removeEntry()
 
 void HistoryContentsWidget::removeDomainEntries()
 {
-	QStandardItem *domainItem(findEntry(getEntry(m_ui->historyViewWidget->currentIndex())));
+	const HistoryModel::HistoryEntry entry(HistoryManager::getEntry(getEntry(m_ui->historyViewWidget->currentIndex())));
 
-	if (!domainItem)
+	if (entry.identifier == 0)
 	{
 		return;
 	}
 
-	const QString host(QUrl(domainItem->text()).host());
-	QList<quint64> entries;
-
-	for (int i = 0; i < m_model->rowCount(); ++i)
-	{
-		QStandardItem *groupItem(m_model->item(i, 0));
-
-		if (!groupItem)
-		{
-			continue;
-		}
-
-		for (int j = (groupItem->rowCount() - 1); j >= 0; --j)
-		{
-			QStandardItem *entryItem(groupItem->child(j, 0));
-
-			if (entryItem && host == QUrl(entryItem->text()).host())
-			{
-				entries.append(entryItem->data(Qt::UserRole).toULongLong());
-			}
-		}
-	}
-
-	HistoryManager::removeEntries(entries);
+	HistoryManager::removeEntries(HistoryManager::getBrowsingHistoryModel()->getHostEntries(entry.url.host()));
 }
 
 void HistoryContentsWidget::openEntry(const QModelIndex &index)
 {
 	const QModelIndex entryIndex(index.isValid() ? index : m_ui->historyViewWidget->currentIndex());
 
-	if (!entryIndex.isValid() || entryIndex.parent() == m_model->invisibleRootItem()->index())
+	if (!entryIndex.isValid() || !entryIndex.parent().isValid())
 	{
 		return;
 	}
@@ -327,21 +619,21 @@ void HistoryContentsWidget::openEntry(const QModelIndex &index)
 
 void HistoryContentsWidget::bookmarkEntry()
 {
-	QStandardItem *entryItem(findEntry(getEntry(m_ui->historyViewWidget->currentIndex())));
+	const HistoryModel::HistoryEntry entry(HistoryManager::getEntry(getEntry(m_ui->historyViewWidget->currentIndex())));
 
-	if (entryItem)
+	if (entry.identifier > 0)
 	{
-		emit requestedAddBookmark(QUrl(entryItem->text()), m_ui->historyViewWidget->currentIndex().sibling(m_ui->historyViewWidget->currentIndex().row(), 1).data(Qt::DisplayRole).toString(), QString());
+		emit requestedAddBookmark(entry.url, entry.title, QString());
 	}
 }
 
 void HistoryContentsWidget::copyEntryLink()
 {
-	QStandardItem *entryItem(findEntry(getEntry(m_ui->historyViewWidget->currentIndex())));
+	const QModelIndex index(m_ui->historyViewWidget->currentIndex());
 
-	if (entryItem)
+	if (getEntry(index) > 0)
 	{
-		QApplication::clipboard()->setText(entryItem->text());
+		QApplication::clipboard()->setText(index.sibling(index.row(), 0).data(Qt::DisplayRole).toString());
 	}
 }
 
@@ -371,27 +663,48 @@ void HistoryContentsWidget::showContextMenu(const QPoint &point)
 	menu.exec(m_ui->historyViewWidget->mapToGlobal(point));
 }
 
-QStandardItem* HistoryContentsWidget::findEntry(quint64 identifier)
+void HistoryContentsWidget::scheduleFilterUpdate()
 {
-	for (int i = 0; i < m_model->rowCount(); ++i)
+	if (m_filterTimer != 0)
 	{
-		QStandardItem *groupItem(m_model->item(i, 0));
+		killTimer(m_filterTimer);
+	}
 
-		if (groupItem)
-		{
-			for (int j = 0; j < groupItem->rowCount(); ++j)
-			{
-				QStandardItem *entryItem(groupItem->child(j, 0));
+	m_filterTimer = startTimer(150);
+}
 
-				if (entryItem && entryItem->data(Qt::UserRole).toULongLong() == identifier)
-				{
-					return entryItem;
-				}
-			}
+void HistoryContentsWidget::handleEntryModified(quint64 identifier)
+{
+	const QString filter(m_ui->filterLineEdit->text());
+
+	if (filter.isEmpty() || m_filterTimer != 0)
+	{
+		return;
+	}
+
+	HistoryModel *model(HistoryManager::getBrowsingHistoryModel());
+	const QModelIndex index(m_model->mapFromSource(model->getEntryIndex(identifier)));
+	QSortFilterProxyModel *proxyModel(m_ui->historyViewWidget->getProxyModel());
+
+	m_ui->historyViewWidget->setFilterIdentifier((proxyModel ? proxyModel->mapFromSource(index) : index), model->isEntryMatching(identifier, filter));
+}
+
+void HistoryContentsWidget::updateFilter()
+{
+	const QString filter(m_ui->filterLineEdit->text());
+	QSet<quint64> identifiers;
+
+	if (!filter.isEmpty())
+	{
+		const QList<quint64> entries(HistoryManager::getBrowsingHistoryModel()->searchEntries(filter));
+
+		for (int i = 0; i < entries.count(); ++i)
+		{
+			identifiers.insert(entries.at(i));
 		}
 	}
 
-	return nullptr;
+	m_ui->historyViewWidget->setFilterIdentifiers(filter, identifiers);
 }
 
 QString HistoryContentsWidget::getTitle() const
@@ -421,7 +734,7 @@ WindowsManager::LoadingState HistoryContentsWidget::getLoadingState() const
 
 quint64 HistoryContentsWidget::getEntry(const QModelIndex &index) const
 {
-	return ((index.isValid() && index.parent().isValid() && index.parent().parent() == m_model->invisibleRootItem()->index()) ? index.sibling(index.row(), 0).data(Qt::UserRole).toULongLong() : -1);
+	return ((index.isValid() && index.parent().isValid() && !index.parent().parent().isValid()) ? index.sibling(index.row(), 0).data(Qt::UserRole).toULongLong() : -1);
 }
 
 bool HistoryContentsWidget::eventFilter(QObject *object, QEvent *event)
@@ -452,7 +765,7 @@ bool HistoryContentsWidget::eventFilter(QObject *object, QEvent *event)
 		{
 			const QModelIndex entryIndex(m_ui->historyViewWidget->currentIndex());
 
-			if (!entryIndex.isValid() || entryIndex.parent() == m_model->invisibleRootItem()->index())
+			if (!entryIndex.isValid() || !entryIndex.parent().isValid())
 			{
 				return ContentsWidget::eventFilter(object, event);
 			}
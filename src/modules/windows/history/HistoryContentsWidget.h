@@ -23,7 +23,7 @@
 #include "../../../core/HistoryManager.h"
 #include "../../../ui/ContentsWidget.h"
 
-#include <QtGui/QStandardItemModel>
+#include <QtCore/QAbstractItemModel>
 
 namespace Otter
 {
@@ -35,6 +35,49 @@ namespace Ui
 
 class Window;
 
+class HistoryContentsModel : public QAbstractItemModel
+{
+	Q_OBJECT
+
+public:
+	explicit HistoryContentsModel(HistoryModel *model, QObject *parent = nullptr);
+
+	QModelIndex mapFromSource(const QModelIndex &sourceIndex) const;
+	QModelIndex index(int row, int column, const QModelIndex &parent = QModelIndex()) const override;
+	QModelIndex parent(const QModelIndex &index) const override;
+	QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+	QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const override;
+	Qt::ItemFlags flags(const QModelIndex &index) const override;
+	int columnCount(const QModelIndex &parent = QModelIndex()) const override;
+	int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+
+public slots:
+	void reload();
+
+protected:
+	void updateSizes();
+	int findBoundary(const QDate &date) const;
+	int findGroup(int row) const;
+	int getGroup(int row, const QDate &date) const;
+	int getGroupStart(int group) const;
+
+protected slots:
+	void handleEntryAboutToBeAdded(const QDateTime &timeVisited);
+	void handleRowsAboutToBeInserted(const QModelIndex &parent, int first, int last);
+	void handleRowsInserted(const QModelIndex &parent, int first, int last);
+	void handleRowsAboutToBeRemoved(const QModelIndex &parent, int first, int last);
+	void handleRowsRemoved(const QModelIndex &parent, int first, int last);
+	void handleDataChanged(const QModelIndex &topLeft, const QModelIndex &bottomRight);
+
+private:
+	HistoryModel *m_model;
+	QStringList m_groups;
+	QVector<QDate> m_dates;
+	QVector<int> m_sizes;
+	QDate m_addedDate;
+	int m_changedGroup;
+};
+
 class HistoryContentsWidget : public ContentsWidget
 {
 	Q_OBJECT
@@ -55,24 +98,27 @@ public slots:
 	void triggerAction(int identifier, const QVariantMap &parameters = QVariantMap()) override;
 
 protected:
+	void timerEvent(QTimerEvent *event) override;
 	void changeEvent(QEvent *event) override;
-	QStandardItem* findEntry(quint64 identifier);
+	void expandBranches();
 	quint64 getEntry(const QModelIndex &index) const;
 
 protected slots:
 	void populateEntries();
-	void addEntry(HistoryEntryItem *entry);
-	void modifyEntry(HistoryEntryItem *entry);
-	void removeEntry(HistoryEntryItem *entry);
+	void updateGroups();
 	void removeEntry();
 	void removeDomainEntries();
 	void openEntry(const QModelIndex &index = QModelIndex());
 	void bookmarkEntry();
 	void copyEntryLink();
 	void showContextMenu(const QPoint &point);
+	void scheduleFilterUpdate();
+	void handleEntryModified(quint64 identifier);
+	void updateFilter();
 
 private:
-	QStandardItemModel *m_model;
+	HistoryContentsModel *m_model;
+	int m_filterTimer;
 	bool m_isLoading;
 	Ui::HistoryContentsWidget *m_ui;
 };
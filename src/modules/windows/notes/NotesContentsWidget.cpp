@@ -28,6 +28,7 @@
 #include "ui_NotesContentsWidget.h"
 
 #include <QtCore/QTimer>
+#include <QtCore/QTimerEvent>
 #include <QtGui/QClipboard>
 #include <QtGui/QMouseEvent>
 #include <QtWidgets/QDesktopWidget>
@@ -39,6 +40,7 @@ namespace Otter
 {
 
 NotesContentsWidget::NotesContentsWidget(Window *window) : ContentsWidget(window),
+	m_filterTimer(0),
 	m_ui(new Ui::NotesContentsWidget)
 {
 	m_ui->setupUi(this);
@@ -52,7 +54,6 @@ NotesContentsWidget::NotesContentsWidget(Window *window) : ContentsWidget(window
 	m_ui->notesViewWidget->setViewMode(ItemViewWidget::TreeViewMode);
 	m_ui->notesViewWidget->setModel(NotesManager::getModel());
 	m_ui->notesViewWidget->setExpanded(NotesManager::getModel()->getRootItem()->index(), true);
-	m_ui->notesViewWidget->setFilterRoles(QSet<int>({BookmarksModel::UrlRole, BookmarksModel::TitleRole, BookmarksModel::DescriptionRole, BookmarksModel::KeywordRole}));
 	m_ui->notesViewWidget->viewport()->installEventFilter(this);
 	m_ui->notesViewWidget->viewport()->setMouseTracking(true);
 	m_ui->filterLineEdit->installEventFilter(this);
@@ -67,7 +68,8 @@ NotesContentsWidget::NotesContentsWidget(Window *window) : ContentsWidget(window
 	connect(m_ui->deleteButton, SIGNAL(clicked()), this, SLOT(removeNote()));
 	connect(m_ui->addButton, SIGNAL(clicked()), this, SLOT(addNote()));
 	connect(m_ui->textEdit, SIGNAL(textChanged()), this, SLOT(updateText()));
-	connect(m_ui->filterLineEdit, SIGNAL(textChanged(QString)), m_ui->notesViewWidget, SLOT(setFilterString(QString)));
+	connect(NotesManager::getModel(), SIGNAL(searchIndexModified()), this, SLOT(handleSearchIndexModified()));
+	connect(m_ui->filterLineEdit, SIGNAL(textChanged(QString)), this, SLOT(scheduleFilterUpdate()));
 	connect(m_ui->notesViewWidget, SIGNAL(doubleClicked(QModelIndex)), this, SLOT(openUrl(QModelIndex)));
 	connect(m_ui->notesViewWidget, SIGNAL(customContextMenuRequested(QPoint)), this, SLOT(showContextMenu(QPoint)));
 	connect(m_ui->notesViewWidget, SIGNAL(needsActionsUpdate()), this, SLOT(updateActions()));
@@ -78,6 +80,22 @@ NotesContentsWidget::~NotesContentsWidget()
 	delete m_ui;
 }
 
+void NotesContentsWidget::timerEvent(QTimerEvent *event)
+{
+	if (event->timerId() == m_filterTimer)
+	{
+		killTimer(m_filterTimer);
+
+		m_filterTimer = 0;
+
+		updateFilter();
+	}
+	else
+	{
+		ContentsWidget::timerEvent(event);
+	}
+}
+
 void NotesContentsWidget::changeEvent(QEvent *event)
 {
 	QWidget::changeEvent(event);
@@ -308,6 +326,42 @@ void NotesContentsWidget::updateText()
 	connect(m_ui->notesViewWidget, SIGNAL(needsActionsUpdate()), this, SLOT(updateActions()));
 }
 
+void NotesContentsWidget::scheduleFilterUpdate()
+{
+	if (m_filterTimer != 0)
+	{
+		killTimer(m_filterTimer);
+	}
+
+	m_filterTimer = startTimer(150);
+}
+
+void NotesContentsWidget::handleSearchIndexModified()
+{
+	if (m_filterTimer == 0 && !m_ui->filterLineEdit->text().isEmpty())
+	{
+		m_filterTimer = startTimer(150);
+	}
+}
+
+void NotesContentsWidget::updateFilter()
+{
+	const QString filter(m_ui->filterLineEdit->text());
+	QSet<quint64> identifiers;
+
+	if (!filter.isEmpty())
+	{
+		const QList<BookmarksItem*> bookmarks(NotesManager::getModel()->searchBookmarks(filter));
+
+		for (int i = 0; i < bookmarks.count(); ++i)
+		{
+			identifiers.insert(bookmarks.at(i)->data(BookmarksModel::IdentifierRole).toULongLong());
+		}
+	}
+
+	m_ui->notesViewWidget->setFilterIdentifiers(filter, identifiers);
+}
+
 void NotesContentsWidget::print(QPrinter *printer)
 {
 	m_ui->notesViewWidget->render(printer);
@@ -55,6 +55,7 @@ public slots:
 	void triggerAction(int identifier, const QVariantMap &parameters = QVariantMap()) override;
 
 protected:
+	void timerEvent(QTimerEvent *event) override;
 	void changeEvent(QEvent *event) override;
 	BookmarksItem* findFolder(const QModelIndex &index);
 
@@ -68,9 +69,13 @@ protected slots:
 	void showContextMenu(const QPoint &point);
 	void updateActions(bool updateText = true);
 	void updateText();
+	void scheduleFilterUpdate();
+	void handleSearchIndexModified();
+	void updateFilter();
 
 private:
 	QHash<int, Action*> m_actions;
+	int m_filterTimer;
 	Ui::NotesContentsWidget *m_ui;
 };
 
@@ -24,8 +24,10 @@
 #include "../../../core/SettingsManager.h"
 #include "../../../core/WebBackend.h"
 
+#include <QtConcurrent/QtConcurrentRun>
 #include <QtCore/QDir>
 #include <QtCore/QFile>
+#include <QtCore/QFutureWatcher>
 #include <QtCore/QMimeData>
 #include <QtGui/QPainter>
 
@@ -74,28 +76,33 @@ void StartPageModel::thumbnailCreated(const QUrl &url, const QPixmap &thumbnail,
 		return;
 	}
 
-	if (!thumbnail.isNull())
+	if (thumbnail.isNull())
 	{
-		const QString path(SessionsManager::getWritableDataPath(QLatin1String("thumbnails/")));
+		finishThumbnailRequest(url, title);
 
-		QDir().mkpath(path);
-
-		thumbnail.save(path + QString::number(m_reloads[url].first) + QLatin1String(".png"), "png");
+		return;
 	}
 
-	BookmarksItem *bookmark(BookmarksManager::getModel()->getBookmark(m_reloads[url].first));
+	QSet<quint64> tiles;
 
-	if (bookmark)
+	for (int i = 0; i < rowCount(); ++i)
 	{
-		if (m_reloads[url].second)
+		if (item(i))
 		{
-			bookmark->setData(title, BookmarksModel::TitleRole);
+			tiles.insert(item(i)->data(BookmarksModel::IdentifierRole).toULongLong());
 		}
-
-		emit isReloadingTileChanged(index(bookmark->index().row(), bookmark->index().column()));
 	}
 
-	m_reloads.remove(url);
+	QFutureWatcher<void> *watcher(new QFutureWatcher<void>(this));
+
+	connect(watcher, &QFutureWatcher<void>::finished, this, [=]()
+	{
+		finishThumbnailRequest(url, title);
+
+		watcher->deleteLater();
+	});
+
+	watcher->setFuture(QtConcurrent::run(&StartPageModel::writeThumbnail, SessionsManager::getWritableDataPath(QLatin1String("thumbnails/")), thumbnail.toImage(), m_reloads[url].identifiers, tiles));
 }
 
 void StartPageModel::reloadModel()
@@ -159,9 +166,14 @@ void StartPageModel::reloadModel()
 
 				if (url.isValid() && SettingsManager::getValue(SettingsManager::StartPage_TileBackgroundModeOption) == QLatin1String("thumbnail") && !QFile::exists(SessionsManager::getWritableDataPath(QLatin1String("thumbnails/")) + QString::number(identifier) + QLatin1String(".png")))
 				{
-					m_reloads[url] = qMakePair(identifier, false);
+					const bool isPending(m_reloads.contains(url));
+
+					addThumbnailRequest(url, identifier, false);
 
-					AddonsManager::getWebBackend()->requestThumbnail(url, QSize(SettingsManager::getValue(SettingsManager::StartPage_TileWidthOption).toInt(), SettingsManager::getValue(SettingsManager::StartPage_TileHeightOption).toInt()));
+					if (!isPending)
+					{
+						AddonsManager::getWebBackend()->requestThumbnail(url, QSize(SettingsManager::getValue(SettingsManager::StartPage_TileWidthOption).toInt(), SettingsManager::getValue(SettingsManager::StartPage_TileHeightOption).toInt()), (i + 1));
+					}
 				}
 
 				appendRow(item);
@@ -213,13 +225,85 @@ void StartPageModel::reloadTile(const QModelIndex &index, bool full)
 
 			information.icon.paint(&painter, QRect(QPoint(0, 0), size));
 
-			m_reloads[index.data(BookmarksModel::UrlRole).toUrl()] = qMakePair(index.data(BookmarksModel::IdentifierRole).toULongLong(), full);
+			addThumbnailRequest(url, index.data(BookmarksModel::IdentifierRole).toULongLong(), full);
 
 			thumbnailCreated(url, thumbnail, information.getTitle());
 		}
-		else if (AddonsManager::getWebBackend()->requestThumbnail(url, size))
+		else if (AddonsManager::getWebBackend()->requestThumbnail(url, size, 0))
 		{
-			m_reloads[index.data(BookmarksModel::UrlRole).toUrl()] = qMakePair(index.data(BookmarksModel::IdentifierRole).toULongLong(), full);
+			addThumbnailRequest(url, index.data(BookmarksModel::IdentifierRole).toULongLong(), full);
+		}
+	}
+}
+
+void StartPageModel::addThumbnailRequest(const QUrl &url, quint64 identifier, bool needsTitleUpdate)
+{
+	ThumbnailRequest &request(m_reloads[url]);
+
+	if (!request.identifiers.contains(identifier))
+	{
+		request.identifiers.append(identifier);
+	}
+
+	if (needsTitleUpdate)
+	{
+		request.needsTitleUpdate = true;
+	}
+}
+
+void StartPageModel::finishThumbnailRequest(const QUrl &url, const QString &title)
+{
+	const ThumbnailRequest request(m_reloads.take(url));
+
+	for (int i = 0; i < request.identifiers.count(); ++i)
+	{
+		BookmarksItem *bookmark(BookmarksManager::getModel()->getBookmark(request.identifiers.at(i)));
+
+		if (bookmark)
+		{
+			if (request.needsTitleUpdate)
+			{
+				bookmark->setData(title, BookmarksModel::TitleRole);
+			}
+
+			emit isReloadingTileChanged(index(bookmark->index().row(), bookmark->index().column()));
+		}
+	}
+}
+
+void StartPageModel::writeThumbnail(const QString &path, const QImage &thumbnail, const QVector<quint64> &identifiers, const QSet<quint64> &tiles)
+{
+	QDir().mkpath(path);
+
+	for (int i = 0; i < identifiers.count(); ++i)
+	{
+		thumbnail.save(path + QString::number(identifiers.at(i)) + QLatin1String(".png"), "png");
+	}
+
+	const QFileInfoList entries(QDir(path).entryInfoList(QStringList(QLatin1String("*.png")), QDir::Files, (QDir::Time | QDir::Reversed)));
+	const qint64 limit(20 * 1024 * 1024);
+	qint64 size(0);
+
+	for (int i = 0; i < entries.count(); ++i)
+	{
+		size += entries.at(i).size();
+	}
+
+	for (int pass = 0; pass < 2; ++pass)
+	{
+		for (int i = 0; (i < entries.count() && size > limit); ++i)
+		{
+			const quint64 identifier(entries.at(i).baseName().toULongLong());
+
+			if (identifiers.contains(identifier) || (pass == 0 && tiles.contains(identifier)))
+			{
+				continue;
+			}
+
+			if (QFile::remove(entries.at(i).absoluteFilePath()))
+			{
+				size -= entries.at(i).size();
+			}
 		}
 	}
 }
@@ -50,6 +50,17 @@ public slots:
 	void reloadModel();
 	void reloadTile(const QModelIndex &index, bool full = false);
 
+protected:
+	struct ThumbnailRequest
+	{
+		QVector<quint64> identifiers;
+		bool needsTitleUpdate = false;
+	};
+
+	void addThumbnailRequest(const QUrl &url, quint64 identifier, bool needsTitleUpdate);
+	void finishThumbnailRequest(const QUrl &url, const QString &title);
+	static void writeThumbnail(const QString &path, const QImage &thumbnail, const QVector<quint64> &identifiers, const QSet<quint64> &tiles);
+
 protected slots:
 	void optionChanged(int identifier);
 	void dragEnded();
@@ -57,7 +68,7 @@ protected slots:
 
 private:
 	BookmarksItem *m_bookmark;
-	QHash<QUrl, QPair<quint64, bool> > m_reloads;
+	QHash<QUrl, ThumbnailRequest> m_reloads;
 
 signals:
 	void modelModified();
@@ -201,7 +201,9 @@ ItemViewWidget::ItemViewWidget(QWidget *parent) : QTreeView(parent),
 	m_sortColumn(-1),
 	m_dragRow(-1),
 	m_dropRow(-1),
+	m_filterTimer(0),
 	m_canGatherExpanded(false),
+	m_hasFilterIdentifiers(false),
 	m_isExclusive(false),
 	m_isModified(false),
 	m_isInitialized(false)
@@ -225,6 +227,22 @@ ItemViewWidget::ItemViewWidget(QWidget *parent) : QTreeView(parent),
 	connect(m_headerWidget, SIGNAL(sectionMoved(int,int,int)), this, SLOT(saveState()));
 }
 
+void ItemViewWidget::timerEvent(QTimerEvent *event)
+{
+	if (event->timerId() == m_filterTimer)
+	{
+		killTimer(m_filterTimer);
+
+		m_filterTimer = 0;
+
+		updateFilterString(m_pendingFilterString);
+	}
+	else
+	{
+		QTreeView::timerEvent(event);
+	}
+}
+
 void ItemViewWidget::showEvent(QShowEvent *event)
 {
 	ensureInitialized();
@@ -440,6 +458,85 @@ void ItemViewWidget::moveRow(bool up)
 	}
 }
 
+void ItemViewWidget::updateFilterString(const QString &filter)
+{
+	const QString normalizedFilter(filter.toLower());
+
+	if (!model())
+	{
+		return;
+	}
+
+	if (normalizedFilter == m_filterString)
+	{
+		if (!m_filterString.isEmpty())
+		{
+			updateFilter();
+		}
+
+		return;
+	}
+
+	if (m_filterString.isEmpty())
+	{
+		connect(model(), SIGNAL(rowsInserted(QModelIndex,int,int)), this, SLOT(filterInsertedRows(QModelIndex,int,int)));
+		connect(model(), SIGNAL(rowsMoved(QModelIndex,int,int,QModelIndex,int)), this, SLOT(filterMovedRows(QModelIndex,int,int,QModelIndex,int)));
+		connect(model(), SIGNAL(rowsAboutToBeRemoved(QModelIndex,int,int)), this, SLOT(removeFilterKeys(QModelIndex,int,int)));
+		connect(model(), SIGNAL(rowsRemoved(QModelIndex,int,int)), this, SLOT(filterRemovedRows(QModelIndex,int,int)));
+		connect(model(), SIGNAL(dataChanged(QModelIndex,QModelIndex)), this, SLOT(filterChangedRows(QModelIndex,QModelIndex)));
+		connect(model(), SIGNAL(modelReset()), this, SLOT(resetFilter()));
+	}
+
+	m_canGatherExpanded = m_filterString.isEmpty();
+	m_filterString = normalizedFilter;
+
+	updateFilter();
+
+	if (m_filterString.isEmpty())
+	{
+		m_expandedBranches.clear();
+		m_filterKeys.clear();
+
+		disconnect(model(), SIGNAL(rowsInserted(QModelIndex,int,int)), this, SLOT(filterInsertedRows(QModelIndex,int,int)));
+		disconnect(model(), SIGNAL(rowsMoved(QModelIndex,int,int,QModelIndex,int)), this, SLOT(filterMovedRows(QModelIndex,int,int,QModelIndex,int)));
+		disconnect(model(), SIGNAL(rowsAboutToBeRemoved(QModelIndex,int,int)), this, SLOT(removeFilterKeys(QModelIndex,int,int)));
+		disconnect(model(), SIGNAL(rowsRemoved(QModelIndex,int,int)), this, SLOT(filterRemovedRows(QModelIndex,int,int)));
+		disconnect(model(), SIGNAL(dataChanged(QModelIndex,QModelIndex)), this, SLOT(filterChangedRows(QModelIndex,QModelIndex)));
+		disconnect(model(), SIGNAL(modelReset()), this, SLOT(resetFilter()));
+	}
+}
+
+void ItemViewWidget::updateFilterParents(const QModelIndex &index)
+{
+	if (m_filterString.isEmpty())
+	{
+		return;
+	}
+
+	QModelIndex parent(index);
+
+	while (parent.isValid())
+	{
+		const int rowCount(getRowCount(parent));
+		bool hasFound(false);
+
+		for (int i = 0; i < rowCount; ++i)
+		{
+			if (!isRowHidden(i, parent))
+			{
+				hasFound = true;
+
+				break;
+			}
+		}
+
+		setRowHidden(parent.row(), parent.parent(), !hasFound);
+		setExpanded(parent, hasFound);
+
+		parent = parent.parent();
+	}
+}
+
 void ItemViewWidget::insertRow(const QList<QStandardItem*> &items)
 {
 	if (!m_sourceModel)
@@ -589,6 +686,74 @@ void ItemViewWidget::updateFilter()
 	}
 }
 
+void ItemViewWidget::resetFilter()
+{
+	m_filterKeys.clear();
+
+	updateFilter();
+}
+
+void ItemViewWidget::filterInsertedRows(const QModelIndex &parent, int first, int last)
+{
+	for (int i = first; i <= last; ++i)
+	{
+		applyFilter(model()->index(i, 0, parent));
+	}
+
+	updateFilterParents(parent);
+}
+
+void ItemViewWidget::filterMovedRows(const QModelIndex &sourceParent, int sourceStart, int sourceEnd, const QModelIndex &destinationParent, int destinationRow)
+{
+	const int amount(sourceEnd - sourceStart + 1);
+	const int first((sourceParent == destinationParent && destinationRow > sourceEnd) ? (destinationRow - amount) : destinationRow);
+
+	filterInsertedRows(destinationParent, first, (first + amount - 1));
+	updateFilterParents(sourceParent);
+}
+
+void ItemViewWidget::filterRemovedRows(const QModelIndex &parent, int first, int last)
+{
+	Q_UNUSED(first)
+	Q_UNUSED(last)
+
+	updateFilterParents(parent);
+}
+
+void ItemViewWidget::removeFilterKeys(const QModelIndex &parent, int first, int last)
+{
+	if (m_filterKeys.isEmpty())
+	{
+		return;
+	}
+
+	for (int i = first; i <= last; ++i)
+	{
+		const QModelIndex index(model()->index(i, 0, parent));
+
+		m_filterKeys.remove(getItem(m_proxyModel ? m_proxyModel->mapToSource(index) : index));
+
+		if (model()->hasChildren(index))
+		{
+			removeFilterKeys(index, 0, (model()->rowCount(index) - 1));
+		}
+	}
+}
+
+void ItemViewWidget::filterChangedRows(const QModelIndex &topLeft, const QModelIndex &bottomRight)
+{
+	for (int i = topLeft.row(); i <= bottomRight.row(); ++i)
+	{
+		const QModelIndex index(topLeft.sibling(i, 0));
+
+		m_filterKeys.remove(getItem(m_proxyModel ? m_proxyModel->mapToSource(index) : index));
+
+		applyFilter(index);
+	}
+
+	updateFilterParents(topLeft.parent());
+}
+
 void ItemViewWidget::setSort(int column, Qt::SortOrder order)
 {
 	if (column == m_sortColumn && order == m_sortOrder)
@@ -632,36 +797,62 @@ void ItemViewWidget::setExclusive(bool isExclusive)
 
 void ItemViewWidget::setFilterString(const QString filter)
 {
-	if (filter == m_filterString || !model())
+	m_pendingFilterString = filter;
+
+	if (m_filterTimer != 0)
 	{
-		return;
+		killTimer(m_filterTimer);
 	}
 
-	if (m_filterString.isEmpty())
+	m_filterTimer = startTimer(150);
+}
+
+void ItemViewWidget::setFilterIdentifiers(const QString &filter, const QSet<quint64> &identifiers)
+{
+	m_filterIdentifiers = identifiers;
+	m_hasFilterIdentifiers = true;
+	m_pendingFilterString = filter;
+
+	if (m_filterTimer != 0)
 	{
-		connect(model(), SIGNAL(rowsInserted(QModelIndex,int,int)), this, SLOT(updateFilter()));
-		connect(model(), SIGNAL(rowsMoved(QModelIndex,int,int,QModelIndex,int)), this, SLOT(updateFilter()));
-		connect(model(), SIGNAL(rowsRemoved(QModelIndex,int,int)), this, SLOT(updateFilter()));
+		killTimer(m_filterTimer);
+
+		m_filterTimer = 0;
 	}
 
-	m_canGatherExpanded = m_filterString.isEmpty();
-	m_filterString = filter;
+	updateFilterString(filter);
+}
 
-	updateFilter();
+void ItemViewWidget::setFilterIdentifier(const QModelIndex &index, bool isMatching)
+{
+	const QModelIndex entryIndex(index.sibling(index.row(), 0));
+	const quint64 identifier(entryIndex.data(Qt::UserRole).toULongLong());
 
-	if (m_filterString.isEmpty())
+	if (!m_hasFilterIdentifiers || identifier == 0 || m_filterIdentifiers.contains(identifier) == isMatching)
 	{
-		m_expandedBranches.clear();
+		return;
+	}
 
-		disconnect(model(), SIGNAL(rowsInserted(QModelIndex,int,int)), this, SLOT(updateFilter()));
-		disconnect(model(), SIGNAL(rowsMoved(QModelIndex,int,int,QModelIndex,int)), this, SLOT(updateFilter()));
-		disconnect(model(), SIGNAL(rowsRemoved(QModelIndex,int,int)), this, SLOT(updateFilter()));
+	if (isMatching)
+	{
+		m_filterIdentifiers.insert(identifier);
+	}
+	else
+	{
+		m_filterIdentifiers.remove(identifier);
+	}
+
+	if (!m_filterString.isEmpty())
+	{
+		applyFilter(entryIndex);
+		updateFilterParents(entryIndex.parent());
 	}
 }
 
 void ItemViewWidget::setFilterRoles(const QSet<int> &roles)
 {
 	m_filterRoles = roles;
+	m_filterKeys.clear();
 }
 
 void ItemViewWidget::setData(const QModelIndex &index, const QVariant &value, int role)
@@ -860,6 +1051,50 @@ bool ItemViewWidget::isExclusive() const
 	return m_isExclusive;
 }
 
+QString ItemViewWidget::getFilterKey(const QModelIndex &index)
+{
+	QStandardItem *item(getItem(m_proxyModel ? m_proxyModel->mapToSource(index) : index));
+
+	if (item && m_filterKeys.contains(item))
+	{
+		return m_filterKeys[item];
+	}
+
+	const int columnCount(getColumnCount(index.parent()));
+	QStringList values;
+
+	for (int i = 0; i < columnCount; ++i)
+	{
+		const QModelIndex childIndex(index.sibling(index.row(), i));
+
+		if (!childIndex.isValid())
+		{
+			continue;
+		}
+
+		QSet<int>::iterator iterator;
+
+		for (iterator = m_filterRoles.begin(); iterator != m_filterRoles.end(); ++iterator)
+		{
+			const QString value(childIndex.data(*iterator).toString());
+
+			if (!value.isEmpty())
+			{
+				values.append(value);
+			}
+		}
+	}
+
+	const QString key(values.join(QLatin1Char('\n')).toLower());
+
+	if (item)
+	{
+		m_filterKeys[item] = key;
+	}
+
+	return key;
+}
+
 bool ItemViewWidget::applyFilter(const QModelIndex &index)
 {
 	bool hasFound(m_filterString.isEmpty());
@@ -882,36 +1117,13 @@ bool ItemViewWidget::applyFilter(const QModelIndex &index)
 			}
 		}
 	}
-	else
+	else if (m_hasFilterIdentifiers)
 	{
-		const int columnCount(index.parent().isValid() ? getRowCount(index.parent()) : getColumnCount());
-
-		for (int i = 0; i < columnCount; ++i)
-		{
-			const QModelIndex childIndex(index.sibling(index.row(), i));
-
-			if (!childIndex.isValid())
-			{
-				continue;
-			}
-
-			QSet<int>::iterator iterator;
-
-			for (iterator = m_filterRoles.begin(); iterator != m_filterRoles.end(); ++iterator)
-			{
-				if (childIndex.data(*iterator).toString().contains(m_filterString, Qt::CaseInsensitive))
-				{
-					hasFound = true;
-
-					break;
-				}
-			}
-
-			if (hasFound)
-			{
-				break;
-			}
-		}
+		hasFound = (hasFound || m_filterIdentifiers.contains(index.data(Qt::UserRole).toULongLong()));
+	}
+	else if (!hasFound)
+	{
+		hasFound = getFilterKey(index).contains(m_filterString);
 	}
 
 	setRowHidden(index.row(), index.parent(), (!hasFound || (isFolder && getRowCount(index) == 0)));
@@ -102,15 +102,21 @@ public slots:
 	void setColumnVisibility(int column, bool hide);
 	void setExclusive(bool isExclusive);
 	void setFilterString(const QString filter = QString());
+	void setFilterIdentifiers(const QString &filter, const QSet<quint64> &identifiers);
+	void setFilterIdentifier(const QModelIndex &index, bool isMatching);
 	void setFilterRoles(const QSet<int> &roles);
 
 protected:
+	void timerEvent(QTimerEvent *event) override;
 	void showEvent(QShowEvent *event) override;
 	void keyPressEvent(QKeyEvent *event) override;
 	void dropEvent(QDropEvent *event) override;
 	void startDrag(Qt::DropActions supportedActions) override;
 	void ensureInitialized();
 	void moveRow(bool up);
+	void updateFilterString(const QString &filter);
+	void updateFilterParents(const QModelIndex &index);
+	QString getFilterKey(const QModelIndex &index);
 	bool applyFilter(const QModelIndex &index);
 
 protected slots:
@@ -120,20 +126,31 @@ protected slots:
 	void notifySelectionChanged();
 	void updateDropSelection();
 	void updateFilter();
+	void resetFilter();
+	void filterInsertedRows(const QModelIndex &parent, int first, int last);
+	void filterMovedRows(const QModelIndex &sourceParent, int sourceStart, int sourceEnd, const QModelIndex &destinationParent, int destinationRow);
+	void filterRemovedRows(const QModelIndex &parent, int first, int last);
+	void removeFilterKeys(const QModelIndex &parent, int first, int last);
+	void filterChangedRows(const QModelIndex &topLeft, const QModelIndex &bottomRight);
 
 private:
 	HeaderViewWidget *m_headerWidget;
 	QStandardItemModel *m_sourceModel;
 	QSortFilterProxyModel *m_proxyModel;
 	QString m_filterString;
+	QString m_pendingFilterString;
 	QSet<QModelIndex> m_expandedBranches;
+	QHash<QStandardItem*, QString> m_filterKeys;
+	QSet<quint64> m_filterIdentifiers;
 	QSet<int> m_filterRoles;
 	ViewMode m_viewMode;
 	Qt::SortOrder m_sortOrder;
 	int m_sortColumn;
 	int m_dragRow;
 	int m_dropRow;
+	int m_filterTimer;
 	bool m_canGatherExpanded;
+	bool m_hasFilterIdentifiers;
 	bool m_isExclusive;
 	bool m_isModified;
 	bool m_isInitialized;
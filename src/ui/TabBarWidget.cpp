@@ -70,6 +70,7 @@ TabHandleWidget::TabHandleWidget(Window *window, TabBarWidget *parent) : QWidget
 	connect(window, SIGNAL(needsAttention()), this, SLOT(markAsNeedingAttention()));
 	connect(window, SIGNAL(titleChanged(QString)), this, SLOT(update()));
 	connect(window, SIGNAL(iconChanged(QIcon)), this, SLOT(update()));
+	connect(window, SIGNAL(thumbnailChanged()), this, SLOT(update()));
 	connect(window, SIGNAL(loadingStateChanged(WindowsManager::LoadingState)), this, SLOT(handleLoadingStateChanged(WindowsManager::LoadingState)));
 	connect(parent, SIGNAL(currentChanged(int)), this, SLOT(updateGeometries()));
 	connect(parent, SIGNAL(tabsAmountChanged(int)), this, SLOT(updateGeometries()));
@@ -1132,6 +1133,7 @@ void TabBarWidget::addTab(int index, Window *window)
 	setTabButton(index, QTabBar::RightSide, nullptr);
 
 	connect(window, SIGNAL(isPinnedChanged(bool)), this, SLOT(updatePinnedTabsAmount()));
+	connect(window, SIGNAL(thumbnailChanged()), this, SLOT(updatePreviewThumbnail()));
 
 	if (window->isPinned())
 	{
@@ -1420,6 +1422,21 @@ void TabBarWidget::updatePreviewPosition()
 	}
 }
 
+void TabBarWidget::updatePreviewThumbnail()
+{
+	if (!m_previewWidget || !m_previewWidget->isVisible())
+	{
+		return;
+	}
+
+	const int index(tabAt(mapFromGlobal(QCursor::pos())));
+
+	if (index >= 0 && getWindow(index) == sender())
+	{
+		showPreview(index);
+	}
+}
+
 void TabBarWidget::updatePinnedTabsAmount(Window *modifiedWindow)
 {
 	int amount(0);
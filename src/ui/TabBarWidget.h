@@ -125,6 +125,7 @@ protected:
 protected slots:
 	void optionChanged(int identifier, const QVariant &value);
 	void updatePreviewPosition();
+	void updatePreviewThumbnail();
 	void updatePinnedTabsAmount(Window *modifiedWindow = nullptr);
 	void updateStyle();
 	void setArea(Qt::ToolBarArea area);
@@ -336,6 +336,7 @@ signals:
 	void titleChanged(const QString &title);
 	void urlChanged(const QUrl &url);
 	void iconChanged(const QIcon &icon);
+	void thumbnailChanged();
 	void requestBlocked(const NetworkManager::ResourceInformation &request);
 	void contentStateChanged(WindowsManager::ContentStates state);
 	void loadingStateChanged(WindowsManager::LoadingState state);
@@ -136,6 +136,7 @@ signals:
 	void titleChanged(const QString &title);
 	void urlChanged(const QUrl &url, bool force = false);
 	void iconChanged(const QIcon &icon);
+	void thumbnailChanged();
 	void requestBlocked(const NetworkManager::ResourceInformation &request);
 	void contentStateChanged(WindowsManager::ContentStates state);
 	void loadingStateChanged(WindowsManager::LoadingState state);